@@ -16,6 +16,7 @@ GPIO:PG13, PG14
 #include <lcd/lcd.h>
 #include <stdio.h>
 #include "stm32f4xx.h"
+#include <timebase/timebase.h>
 
 
 int main(void)
@@ -62,8 +63,8 @@ int main(void)
 		/* First activate the green one, then toggle the two.
 		 * (with delay so we can see what's going on) */
 		HAL_GPIO_WritePin(GPIOG, GPIO_PIN_13, 1);
-		HAL_Delay(500);
+		timebase_sleep_ms(500);
 		HAL_GPIO_TogglePin(GPIOG, GPIO_PIN_13 | GPIO_PIN_14);
-		HAL_Delay(500);
+		timebase_sleep_ms(500);
 	}
 }
@@ -15,6 +15,7 @@
 /* Includes */
 #include <lcd/lcd.h>
 #include "stm32f4xx.h"
+#include <timebase/timebase.h>
 #include <esd.h>
 
 int main(void) {
@@ -40,7 +41,7 @@ int main(void) {
 		for (int i_pos = ESD_POSITION_1; i_pos <= ESD_POSITION_ALL; i_pos++) {
 			for (int i_digit = ESD_DIGIT_9; i_digit >= ESD_DIGIT_0; i_digit--) {
 				esd_show_digit(i_digit, i_pos);
-				HAL_Delay(500);
+				timebase_sleep_ms(500);
 			}
 		}
 
@@ -25,6 +25,7 @@
 /* Includes */
 #include <lcd/lcd.h>
 #include "stm32f4xx.h"
+#include <timebase/timebase.h>
 #include <joystick.h>
 #include <esd.h>
 
@@ -63,7 +64,7 @@ int main(void) {
 				current_digit--;
 			}
 			esd_show_digit(current_digit, current_pos);
-			HAL_Delay(200);
+			timebase_sleep_ms(200);
 		}
 		if (joystick_read_dir(JOYSTICK_B) == 0) {
 			if (current_pos == ESD_POSITION_1) {
@@ -72,7 +73,7 @@ int main(void) {
 				current_pos--;
 			}
 			esd_show_digit(current_digit, current_pos);
-			HAL_Delay(200);
+			timebase_sleep_ms(200);
 		}
 		if (joystick_read_dir(JOYSTICK_C) == 0) {
 			if (current_pos == ESD_POSITION_4) {
@@ -81,7 +82,7 @@ int main(void) {
 				current_pos++;
 			}
 			esd_show_digit(current_digit, current_pos);
-			HAL_Delay(200);
+			timebase_sleep_ms(200);
 		}
 
 		if (joystick_read_dir(JOYSTICK_D) == 0) {
@@ -91,7 +92,7 @@ int main(void) {
 				current_digit++;
 			}
 			esd_show_digit(current_digit, current_pos);
-			HAL_Delay(200);
+			timebase_sleep_ms(200);
 		}
 
 		/* when we press the joystick, a countdown starts*/
@@ -101,12 +102,12 @@ int main(void) {
 			if(current_digit != ESD_DIGIT_0) {
 				for (int i_digit = current_digit; i_digit >= ESD_DIGIT_0; i_digit--) {
 					esd_show_digit(i_digit, current_pos);
-					HAL_Delay(1000);
+					timebase_sleep_ms(1000);
 				}
 			}
 			/* At the end of the loop we set the digit back to its previous value */
 			esd_show_digit(current_digit, current_pos);
-			HAL_Delay(100);
+			timebase_sleep_ms(100);
 		}
 
 	}
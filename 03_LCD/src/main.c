@@ -18,6 +18,7 @@
 /* Includes */
 #include <lcd/lcd.h>
 #include "stm32f4xx.h"
+#include <timebase/timebase.h>
 #include <my_lcd.h>
 
 
@@ -37,7 +38,7 @@ int main(void) {
 			my_lcd_draw_baargraph(10, 40, 200, 35, i*50, RED, GREEN);
 			sprintf(buffer, "Zahl = %2d", i);
 			lcd_draw_text_at_line(buffer, 4, BLACK, 2, WHITE);
-			HAL_Delay(800);
+			timebase_sleep_ms(800);
 		}
 		/* Function call for horizontal bar graph */
 		//my_lcd_draw_baargraph(10, 40, 200, 35, 750, RED, GREEN);
@@ -19,7 +19,13 @@
 
 #include <lcd/lcd.h>
 #include "stm32f4xx.h"
+#include <stdio.h>
 #include <potis_dma.h>
+#include <my_lcd.h>
+
+/* Static functions (prototypes) */
+static void show_poti_1(void);
+static void show_poti_2(void);
 
 int main(void) {
 	HAL_Init();
@@ -30,19 +36,43 @@ int main(void) {
 	/* Initialization of DMA */
 	potis_dma_init();
 
-	/* Two arrays for the text on the LCD*/
-	char buffer[16];
-	char buffer_2[16];
+	/* The display is only redrawn, when the corresponding potentiometer has moved. */
+	potis_dma_subscribe(POTIS_DMA_1, show_poti_1);
+	potis_dma_subscribe(POTIS_DMA_2, show_poti_2);
 
 	while (1) {
-		/* The first average will be written on display */
-		sprintf(buffer, "Adress1 = %4lu", potis_dma_get_avg(POTIS_DMA_1));
-		lcd_draw_text_at_line(buffer, 2, BLACK, 2, WHITE);
+		/* Sleeps until a potentiometer has changed and calls the subscribers. */
+		potis_dma_wait_events();
+	}
+}
 
-		/* The second average will be written on display */
-		sprintf(buffer_2, "Adress2 = %4lu", potis_dma_get_avg(POTIS_DMA_2));
-		lcd_draw_text_at_line(buffer_2, 6, BLACK, 2, WHITE);
+/**
+  * @brief Writes the average of the first potentiometer and its bar graph on display.
+  * @param None
+  * @return None
+  */
+static void show_poti_1(void) {
+	char buffer[16];
+	uint32_t value = potis_dma_get_avg(POTIS_DMA_1);
 
-	}
+	/* The first average will be written on display */
+	sprintf(buffer, "Adress1 = %4lu", value);
+	lcd_draw_text_at_line(buffer, 2, BLACK, 2, WHITE);
+	/* 4095 is the full bar (1000 promille) */
+	my_lcd_draw_baargraph(10, 40, 200, 35, (value * 1000) / 4095, RED, GREEN);
 }
 
+/**
+  * @brief Writes the average of the second potentiometer and its bar graph on display.
+  * @param None
+  * @return None
+  */
+static void show_poti_2(void) {
+	char buffer[16];
+	uint32_t value = potis_dma_get_avg(POTIS_DMA_2);
+
+	/* The second average will be written on display */
+	sprintf(buffer, "Adress2 = %4lu", value);
+	lcd_draw_text_at_line(buffer, 6, BLACK, 2, WHITE);
+	my_lcd_draw_baargraph(10, 175, 200, 35, (value * 1000) / 4095, RED, GREEN);
+}
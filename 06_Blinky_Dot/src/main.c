@@ -33,8 +33,11 @@ int main(void) {
 	/* Initializes all necessary peripherals for controlling frequency and brightness of LEDs. */
 	dot_control_init();
 
+	/* Changes the frequency of the LEDs, but only when the first potentiometer has moved. */
+	potis_dma_subscribe(POTIS_DMA_1, dot_control_change_frequency);
+
 	while (1) {
-		/* Changes the frequency of the LEDs. */
-		dot_control_change_frequency();
+		/* Sleeps until a potentiometer has changed and calls the subscribers. */
+		potis_dma_wait_events();
 	}
 }
@@ -32,9 +32,12 @@ int main(void) {
 	//Initializes the dimming control.
 	dot_control_init();
 
-	while (1) {
-		/* Changes the frequency and brightness of the LEDs based on the potentiometer values. */
-		dot_control_change_dimming();
+	/* Changes the frequency and brightness of the LEDs based on the potentiometer values,
+	 * but only when one of them has moved. */
+	potis_dma_subscribe(POTIS_DMA_ALL, dot_control_change_dimming);
 
+	while (1) {
+		/* Sleeps until a potentiometer has changed and calls the subscribers. */
+		potis_dma_wait_events();
 	}
 }
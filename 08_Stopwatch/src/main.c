@@ -17,6 +17,7 @@
 
 /* Includes */
 #include <stopwatch.h>
+#include <timebase/timebase.h>
 
 /**
  * @brief Main function.
@@ -25,14 +26,19 @@
  * The stopwatch_init() function is called to initialize the stopwatch and all the peripherals. For more info
  * see stopwatch.c
  * The stopwatch_start() function is then called in an infinite loop to start the stopwatch functionality.
+ * Between two calls the core sleeps, the running time is drawn with a limited frame rate.
  *
  * @return none
  */
 int main(void) {
     stopwatch_init(); // Initialize the stopwatch.
 
+    /* Large digits with at most 25 frames per second, the rest of the time the core sleeps */
+    stopwatch_set_render(STOPWATCH_RENDER_DIGITS, 25);
+
     while (1) {
         stopwatch_start(); // Start the stopwatch.
+        timebase_idle(); // Sleep until the next interrupt (button, SysTick, ...).
     }
 }
 
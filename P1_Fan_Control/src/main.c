@@ -7,25 +7,112 @@
  * @brief       This file contains the main entry point of the program for controlling
  *              and monitoring the fan speed. It initializes the fan control module and
  *              enters a main loop where it continuously updates the fan status and sets
- *              the target RPM.
+ *              the target RPM (from the temperature of the environmental sensor or from
+ *              the potentiometer).
  ******************************************************************************
  ==================================================
  ### Resources used ###
- (see fan_control.c)
+ (see fan_control.c and, in the thermal mode, env_sensor.c)
  ==================================================
  */
 
 /* Includes */
 #include "stm32f4xx.h"
 #include <fan_control.h>
+#include <potis_dma.h>
+#include <env_sensor.h>
+#include <timebase/timebase.h>
+#include <soft_timer/soft_timer.h>
 #include <lcd/lcd.h>
 #include <stdio.h>
 
+/* Comment out to set the target RPM with the potentiometer instead of the temperature */
+#define MAIN_THERMAL_CONTROL
+
+/* Time between two refreshes of the display in milliseconds */
+#define MAIN_DISPLAY_INTERVAL_MS 100
+
+/* Module functions (prototypes) */
+static void main_display(void *arg);
+#ifdef MAIN_THERMAL_CONTROL
+static void main_thermal(void);
+#endif
+
+/* Module variables */
+soft_timer_t main_display_timer;
+/* The auto-tuning has been started once after the feed-forward table */
+static uint8_t main_tuning_started = 0;
+
+#ifdef MAIN_THERMAL_CONTROL
+/* Fan curve: quiet up to 25 °C, full speed from 40 °C, slows down after 1 °C of cooling */
+static const fan_control_curve_t main_fan_curve = {
+	.points = { { 2500, 1000 }, { 3000, 2000 }, { 3500, 3000 }, { 4000, 4500 } },
+	.count = 4,
+	.hysteresis = 100,
+};
+#endif
+
 
 int main(void) {
 	/* Initialize fan control module */
 	fan_control_init();
 
+#ifdef MAIN_THERMAL_CONTROL
+	/* Set target RPM from the temperature with every measurement of the sensor */
+	env_sensor_init();
+	fan_control_set_curve(&fan_control_fan, &main_fan_curve);
+	env_sensor_subscribe(main_thermal);
+#else
+	/* Set target RPM based on potentiometer value, whenever it has changed */
+	potis_dma_subscribe(POTIS_DMA_1, fan_control_set_rpm);
+#endif
+
+	/* Sweep the duty once to learn the feed-forward table, new targets then settle much faster.
+	 * Afterwards the main loop starts the auto-tuning once */
+	fan_control_learn_feedforward(&fan_control_fan);
+
+	/* Refresh the display periodically, the control runs in the interrupts */
+	soft_timer_setup(&main_display_timer, main_display, 0, 0);
+	soft_timer_start(&main_display_timer, 0, soft_timer_ms_to_ticks(MAIN_DISPLAY_INTERVAL_MS));
+
+	/* Main loop that continuously controls and monitors the fan speed */
+	while (1) {
+#ifndef MAIN_THERMAL_CONTROL
+		/* Calls fan_control_set_rpm() if the potentiometer has changed */
+		potis_dma_poll_events();
+#endif
+
+		/* When the table is learned, measure the gains around the current target (relay_tune.c),
+		 * Tyreus-Luyben for little overshoot. If it fails, the default gains stay */
+		if (!main_tuning_started && fan_control_feedforward_ready(&fan_control_fan)
+				&& fan_control_get_target(&fan_control_fan) > 0) {
+			fan_control_autotune(&fan_control_fan, RELAY_TUNE_TYREUS_LUYBEN);
+			main_tuning_started = 1;
+		}
+
+		/* Runs main_display() and the measurements of the sensor, when their timers have expired */
+		soft_timer_process();
+		timebase_idle();
+	}
+	/* Program should never reach this point */
+}
+
+#ifdef MAIN_THERMAL_CONTROL
+/*
+ * @brief Called with every new measurement of the sensor, sets the target RPM from the temperature
+ *        through main_fan_curve.
+ */
+static void main_thermal(void) {
+	float temperature = env_sensor_get_last(ENV_TEMPERATURE) * 100.0f;
+
+	fan_control_set_temperature((int32_t) (temperature < 0 ? temperature - 0.5f : temperature + 0.5f));
+}
+#endif
+
+/*
+ * @brief Shows the fan status on the display.
+ */
+static void main_display(void *arg) {
 	// for displaying target RPM value
 	char target_rpm_string[32];
 
@@ -35,28 +122,26 @@ int main(void) {
 	//for displaying current fan rpm.
 	char current_rpm_string[32];
 
-	/* Main loop that continuously controls and monitors the fan speed */
-	while (1) {
-		/* Show fan status on display */
+	/* Names of the RPM quality, in the order of fan_core_rpm_quality_t */
+	static const char *quality_names[] = { "starting", "valid", "noisy", "STALLED" };
+	char quality_string[32];
 
-		// Format the target RPM value as a string
-		sprintf(target_rpm_string, "Target RPM = %5lu", fan_control_poti_val);
-		// Display the target RPM value on the LCD at line 2
-		lcd_draw_text_at_line(target_rpm_string, 2, BLACK, 2, WHITE);
+	// Format the target RPM value as a string
+	sprintf(target_rpm_string, "Target RPM = %5lu", fan_control_get_target(&fan_control_fan));
+	// Display the target RPM value on the LCD at line 2
+	lcd_draw_text_at_line(target_rpm_string, 2, BLACK, 2, WHITE);
 
-		// Format the time interval between fan rotations as a string
-		sprintf(interval_string, "Interval : %5lu", fan_control_time_interval);
-		// Display the time interval on the LCD at line 4
-		lcd_draw_text_at_line(interval_string, 4, BLACK, 2, WHITE);
+	// Format the time interval between fan rotations as a string
+	sprintf(interval_string, "Interval : %5lu", fan_control_get_interval(&fan_control_fan));
+	// Display the time interval on the LCD at line 4
+	lcd_draw_text_at_line(interval_string, 4, BLACK, 2, WHITE);
 
-		// Format the current fan RPM as a string
-		sprintf(current_rpm_string, "RPM : %5lu", fan_control_actual_RPM);
-		// Display the current fan RPM on the LCD at line 6
-		lcd_draw_text_at_line(current_rpm_string, 6, BLACK, 2, WHITE);
+	// Format the current fan RPM as a string
+	sprintf(current_rpm_string, "RPM : %5lu", fan_control_get_rpm(&fan_control_fan));
+	// Display the current fan RPM on the LCD at line 6
+	lcd_draw_text_at_line(current_rpm_string, 6, BLACK, 2, WHITE);
 
-		/* Set target RPM based on potentiometer value */
-		fan_control_set_rpm();
-	}
-	/* Program should never reach this point */
+	// Show how far the RPM can be trusted, a stalled fan shows 0 RPM
+	sprintf(quality_string, "Tacho : %-8s", quality_names[fan_control_get_quality(&fan_control_fan)]);
+	lcd_draw_text_at_line(quality_string, 8, BLACK, 2, WHITE);
 }
-
@@ -23,6 +23,14 @@
 #include "bme280.h"
 #include "utils.h"
 #include "env_sensor.h"
+#include <timebase/timebase.h>
+#include <soft_timer/soft_timer.h>
+
+/* Time between two measurements in milliseconds, the core sleeps in between */
+#define MAIN_MEASUREMENT_INTERVAL_MS 1000
+
+/* Module functions (prototypes) */
+static void main_measure(void *arg);
 
 /* Module Variables */
 float main_temperature;
@@ -31,13 +39,13 @@ float main_pressure;
 char hum_string[50];
 char temp_string[50];
 char press_string[50];
+soft_timer_t main_measurement_timer;
 
 
 /*
  * @brief In the main function, the sequence of initializing BME280 sensor.
- * 		  Then, the env_sensor_get_value function is called to retrieve the sensor data.
- * 		  If the sensor data retrieval is successful, the temperature, humidity, and pressure values are formatted as strings using sprintf.
- * 		  These formatted strings are then displayed on the LCD using the lcd_draw_text_at_line function.
+ * 		  Then a periodic software timer calls main_measure() every MAIN_MEASUREMENT_INTERVAL_MS,
+ * 		  in between the core sleeps.
  */
 int main(void) {
 	/* Initialization of the module */
@@ -46,23 +54,39 @@ int main(void) {
 	/* Initialization of the LCD */
 	lcd_init();
 
+	/* Measure right away and then periodically */
+	soft_timer_init(0);
+	soft_timer_setup(&main_measurement_timer, main_measure, 0, 0);
+	soft_timer_start(&main_measurement_timer, 0,
+			soft_timer_ms_to_ticks(MAIN_MEASUREMENT_INTERVAL_MS));
+
 	while (1) {
-		/* Get the value of temperature from the sensor */
-		main_temperature = env_sensor_get_value(ENV_TEMPERATURE);
-		/* Formatting it as a string */
-		sprintf(temp_string, "Temperature %03.1f ", main_temperature);
-		lcd_draw_text_at_line(temp_string, 2, BLACK, 2, WHITE);
+		/* Runs main_measure(), when the timer has expired */
+		soft_timer_process();
+		timebase_idle();
+	}
+}
 
-		/* Get the value of humidity from the sensor */
-		main_humidity = env_sensor_get_value(ENV_HUMIDITY);
-		/* Formatting it as a string */
-		sprintf(hum_string, "Humidity %03.1f ", main_humidity);
-		lcd_draw_text_at_line(hum_string, 4, BLACK, 2, WHITE);
+/*
+ * @brief The env_sensor_get_value function is called to retrieve the sensor data.
+ * 		  If the sensor data retrieval is successful, the temperature, humidity, and pressure values are formatted as strings using sprintf.
+ * 		  These formatted strings are then displayed on the LCD using the lcd_draw_text_at_line function.
+ */
+static void main_measure(void *arg) {
+	/* Get the value of temperature from the sensor */
+	main_temperature = env_sensor_get_value(ENV_TEMPERATURE);
+	/* Formatting it as a string */
+	sprintf(temp_string, "Temperature %03.1f ", main_temperature);
+	lcd_draw_text_at_line(temp_string, 2, BLACK, 2, WHITE);
 
-		/* Get the value of pressure from the sensor */
-		main_pressure = env_sensor_get_value(ENV_PRESSURE);
-		sprintf(press_string, "Pressure %03.1f ", main_pressure/100);
-		lcd_draw_text_at_line(press_string, 6, BLACK, 2, WHITE);
+	/* Get the value of humidity from the sensor */
+	main_humidity = env_sensor_get_value(ENV_HUMIDITY);
+	/* Formatting it as a string */
+	sprintf(hum_string, "Humidity %03.1f ", main_humidity);
+	lcd_draw_text_at_line(hum_string, 4, BLACK, 2, WHITE);
 
-	}
+	/* Get the value of pressure from the sensor */
+	main_pressure = env_sensor_get_value(ENV_PRESSURE);
+	sprintf(press_string, "Pressure %03.1f ", main_pressure/100);
+	lcd_draw_text_at_line(press_string, 6, BLACK, 2, WHITE);
 }
@@ -11,8 +11,10 @@
 
  GPIOD: D Channel for the periphery, 8-segment board.
  GPIOE: E Channel for the 4 dots on 8-segment board.
- TIM_HandleTypeDef: Timer1 Initializing instance
- TIM_OC_InitTypeDef: Timer Output Compare instance (PWM1)
+ TIM1: Timer with output compare channel 2 (PWM1) on PE11, dot_control_timer.
+ The frequency is set with prescaler and auto-reload together, both are preloaded, so a change
+ only takes effect at the end of the running period.
+ TIM1_UP_TIM10_IRQHandler: Update interrupt of TIM1, dithers the compare value (see below).
 
  ==================================================
  ### Usage ###
@@ -25,6 +27,24 @@
 
  (#) Call "dot_control_change_frequency()" in main functions while-loop to change the frequency of the dot.
 
+ (#) Both functions can also be subscribed with "potis_dma_subscribe()", then they only run
+ when a potentiometer has changed.
+
+ The prescaler/auto-reload pairs for 1Hz - 10Hz are calculated once in dot_control_init()
+ into a table over the ADC range (DOT_CONTROL_LUT_SIZE entries), so changing the frequency
+ is only a table lookup and an integer multiplication.
+
+ ### Dimming ###
+
+ The eye sees brightness roughly logarithmically, so the second potentiometer is mapped
+ through a gamma table (gamma 2.2, 256 entries, 16 bit, linear interpolation in between)
+ onto the duty cycle. The table is constant, nothing is calculated at runtime.
+
+ The duty cycle (16 bit) times the period usually has a fractional part, that one compare value
+ cannot show. The update interrupt adds this fraction to an accumulator every period and sets the
+ compare value one higher, whenever the accumulator overflows (first order sigma-delta). Averaged
+ over the periods the duty cycle is exact to 16 bit, also at small duty cycles or short periods.
+
  @endverbatim
  **************************************************
  */
@@ -38,9 +58,65 @@
 #include <my_timer.h>
 
 /* Preprocessor macros */
-/* In order to meet the requirements given on the paper, we are required to create an Interval Value between 1 to 10 */
-#define MAX_INTERVAL(x) (x*(10-1))
-#define CORE_CLOCK(x) ((SystemCoreClock / (10000*x)) - 1)
+/* In order to meet the requirements given on the paper, the dot blinks with 1Hz to 10Hz (in millihertz) */
+#define DOT_CONTROL_MIN_FREQUENCY_MHZ 1000
+#define DOT_CONTROL_MAX_FREQUENCY_MHZ 10000
+/* Entries of the frequency table, the ADC value (12 bit) is shifted down to the index */
+#define DOT_CONTROL_LUT_SIZE 256
+#define DOT_CONTROL_LUT_SHIFT 4
+#define DOT_CONTROL_ADC_MAX 4095
+/* Duty cycles are fractions in Q16 (0 - 65535) */
+#define DOT_CONTROL_DUTY_MAX 65535
+#define DOT_CONTROL_DUTY_HALF 32768
+
+/* Module functions (prototypes) */
+static void dot_control_build_lut();
+static void dot_control_set(uint32_t frequency_adc, uint32_t duty_q16);
+static uint32_t dot_control_gamma(uint32_t adc);
+void TIM1_UP_TIM10_IRQHandler(void);
+
+/* Module variables */
+my_timer_t dot_control_timer;
+static my_timer_setting_t dot_control_lut[DOT_CONTROL_LUT_SIZE];
+/* Compare value in Q16 (integer part for the register, fraction for the dithering) */
+static volatile uint32_t dot_control_compare_q16 = 0;
+static uint32_t dot_control_dither_acc = 0;
+
+/* round(65535 * (i / 255)^2.2) */
+static const uint16_t dot_control_gamma_table[256] = {
+		    0,     0,     2,     4,     7,    11,    17,    24,
+		   32,    42,    53,    65,    79,    94,   111,   129,
+		  148,   169,   192,   216,   242,   270,   299,   330,
+		  362,   396,   432,   469,   508,   549,   591,   635,
+		  681,   729,   779,   830,   883,   938,   995,  1053,
+		 1113,  1175,  1239,  1305,  1373,  1443,  1514,  1587,
+		 1663,  1740,  1819,  1900,  1983,  2068,  2155,  2243,
+		 2334,  2427,  2521,  2618,  2717,  2817,  2920,  3024,
+		 3131,  3240,  3350,  3463,  3578,  3694,  3813,  3934,
+		 4057,  4182,  4309,  4438,  4570,  4703,  4838,  4976,
+		 5115,  5257,  5401,  5547,  5695,  5845,  5998,  6152,
+		 6309,  6468,  6629,  6792,  6957,  7124,  7294,  7466,
+		 7640,  7816,  7994,  8175,  8358,  8543,  8730,  8919,
+		 9111,  9305,  9501,  9699,  9900, 10102, 10307, 10515,
+		10724, 10936, 11150, 11366, 11585, 11806, 12029, 12254,
+		12482, 12712, 12944, 13179, 13416, 13655, 13896, 14140,
+		14386, 14635, 14885, 15138, 15394, 15652, 15912, 16174,
+		16439, 16706, 16975, 17247, 17521, 17798, 18077, 18358,
+		18642, 18928, 19216, 19507, 19800, 20095, 20393, 20694,
+		20996, 21301, 21609, 21919, 22231, 22546, 22863, 23182,
+		23504, 23829, 24156, 24485, 24817, 25151, 25487, 25826,
+		26168, 26512, 26858, 27207, 27558, 27912, 28268, 28627,
+		28988, 29351, 29717, 30086, 30457, 30830, 31206, 31585,
+		31966, 32349, 32735, 33124, 33514, 33908, 34304, 34702,
+		35103, 35507, 35913, 36321, 36732, 37146, 37562, 37981,
+		38402, 38825, 39252, 39680, 40112, 40546, 40982, 41421,
+		41862, 42306, 42753, 43202, 43654, 44108, 44565, 45025,
+		45487, 45951, 46418, 46888, 47360, 47835, 48313, 48793,
+		49275, 49761, 50249, 50739, 51232, 51728, 52226, 52727,
+		53230, 53736, 54245, 54756, 55270, 55787, 56306, 56828,
+		57352, 57879, 58409, 58941, 59476, 60014, 60554, 61097,
+		61642, 62190, 62741, 63295, 63851, 64410, 64971, 65535
+};
 
 /**
  * @brief Initializes the dimming control.
@@ -54,13 +130,18 @@ void dot_control_init() {
 	HAL_Init();
 
 	/**
-	 * The instance of TIM_HandleTypeDef is called "tim_handle_struct" here.
-	 * The Prescale field is not constant here. Therefore, an unsigned integer 32-bit variable
-	 * named scaler_var is defined and assigned to the prescaler field when the timer is initialized.
-	 * In order to get 10kHz, we need to assign to the prescaler 1600. (160000000 / 1600 = 10000)
+	 * The timer counts with 10kHz, a period of 10000 ticks results in 1Hz.
+	 * Prescaler and period are changed later on with the potentiometer, so the dot blinks between 1Hz and 10Hz.
 	 */
-	my_timer_init(TIMER_INSTANCE_1, TIMER_MODE_BASE, 10000, 10000);
-	my_timer_oc_init(INSTANCE_PWM_1, MODE_OC, 5000, TIM_CHANNEL_2);
+	my_timer_init(&dot_control_timer, TIM1, TIMER_MODE_BASE, 10000, 10000);
+	my_timer_oc_init(&dot_control_timer, INSTANCE_PWM_1, MODE_OC, 5000, TIM_CHANNEL_2);
+	my_timer_enable_preload(&dot_control_timer, TIM_CHANNEL_2);
+	dot_control_build_lut();
+
+	/* Update interrupt for the dithering of the compare value */
+	HAL_NVIC_SetPriority(TIM1_UP_TIM10_IRQn, 2, 0);
+	HAL_NVIC_EnableIRQ(TIM1_UP_TIM10_IRQn);
+	my_timer_enable_interrupt(&dot_control_timer);
 
 	/* CNTL1, CNTL2, CNTL3, CNTL4 are connected the pins PD14-PD15-PD0-PD1 */
 	/* We need to initialize other pins too, so we can make sure the unwanted pins stay off  */
@@ -81,7 +162,7 @@ void dot_control_init() {
 	GPIO_AF1_TIM1, GPIO_SPEED_MEDIUM);
 
 	/* Starting the Timer Output Compare Channel */
-	my_timer_start(MODE_OC, TIM_CHANNEL_2);
+	my_timer_start(&dot_control_timer, MODE_OC, TIM_CHANNEL_2);
 
 	/* Initializing the potentiometer for AD-conversion */
 	potis_dma_init();
@@ -91,45 +172,118 @@ void dot_control_init() {
  * @brief Changes the frequency and brightness for dimming control.
  * 		  This function reads the ADC values of two potentiometers and uses them to determine
  *        the desired frequency and brightness for dimming control.
- *        The first potentiometer value is used to calculate the frequency scaler,
- *        and the second potentiometer value is used to adjust the brightness of the LEDs.
+ *        The first potentiometer value selects the frequency from the table,
+ *        and the second potentiometer value is used to adjust the brightness of the LEDs
+ *        (gamma corrected).
  *
  * @param none
  * @return none
  */
 void dot_control_change_dimming() {
-	/* Reading the ADC value of the first potentiometer*/
-	float poti_1_val = potis_dma_get_avg(POTIS_DMA_1);
-	/* Reading the ADC value of the second potentiometer*/
-	float poti_2_val = potis_dma_get_avg(POTIS_DMA_2);
-
-	/* The value from potentiometer is maximum 1 */
-	float new_scaler = poti_1_val / 4095.0;
-	/* Setting the interval between 1Hz and 10Hz */
-	float set_interval = MAX_INTERVAL(new_scaler) + 1.0;
-	/* Setting the prescaler to the desired frequency */
-	my_timer_set_prescaler(CORE_CLOCK(set_interval));
-	/* Setting the compare unit to the desired frequency, in order to change
-	 * the "brightness" of the LEDs */
-	my_timer_set_compare(TIM_CHANNEL_2, (poti_2_val * 5000) / 4095);
+	dot_control_set(potis_dma_get_avg(POTIS_DMA_1),
+			dot_control_gamma(potis_dma_get_avg(POTIS_DMA_2)));
 }
 
 /**
  * @brief Changes the frequency of the dot control based on the potentiometer value.
+ *        The dot stays on for half of the period.
  *
  * @param none
  * @return none
  */
 void dot_control_change_frequency() {
-	/* Reading the ADC value of the first potentiometer*/
-	float poti_1_get_val = potis_dma_get_avg(POTIS_DMA_1);
+	dot_control_set(potis_dma_get_avg(POTIS_DMA_1), DOT_CONTROL_DUTY_HALF);
+}
+
+/**
+ * @brief Fills the frequency table: entry i gets the prescaler and period for
+ *        MIN + i * (MAX - MIN) / (DOT_CONTROL_LUT_SIZE - 1), so the first and the last entry
+ *        are exactly 1Hz and 10Hz.
+ *
+ * @param none
+ * @return none
+ */
+static void dot_control_build_lut() {
+	uint32_t frequency_mhz;
+
+	for (uint32_t i = 0; i < DOT_CONTROL_LUT_SIZE; i++) {
+		frequency_mhz = DOT_CONTROL_MIN_FREQUENCY_MHZ
+				+ (i * (DOT_CONTROL_MAX_FREQUENCY_MHZ - DOT_CONTROL_MIN_FREQUENCY_MHZ)
+						+ (DOT_CONTROL_LUT_SIZE - 1) / 2) / (DOT_CONTROL_LUT_SIZE - 1);
+		my_timer_solve(dot_control_timer.clock, frequency_mhz, 0xFFFF,
+				&dot_control_lut[i]);
+	}
+}
+
+/**
+ * @brief Sets frequency and duty cycle of the dot. All three registers are written while the
+ *        update event is held back, so they are taken over together at the end of the period.
+ *        The fraction of the compare value is left to the update interrupt.
+ *
+ * @param frequency_adc ADC value (0 - 4095), that selects the frequency.
+ * @param duty_q16 Share of the period, the dot is on (0 - DOT_CONTROL_DUTY_MAX).
+ * @return none
+ */
+static void dot_control_set(uint32_t frequency_adc, uint32_t duty_q16) {
+	const my_timer_setting_t *setting;
+	uint32_t compare_q16;
+
+	if (frequency_adc > DOT_CONTROL_ADC_MAX) {
+		frequency_adc = DOT_CONTROL_ADC_MAX;
+	}
+	if (duty_q16 > DOT_CONTROL_DUTY_MAX) {
+		duty_q16 = DOT_CONTROL_DUTY_MAX;
+	}
+	setting = &dot_control_lut[frequency_adc >> DOT_CONTROL_LUT_SHIFT];
 
-	/* The value from potentiometer is maximum 1 */
-	float new_scaler = poti_1_get_val / 4095.0;
+	/* Period (at most 2^16) times duty (below 2^16) fits into 32 bit */
+	compare_q16 = (setting->period + 1) * duty_q16;
 
-	/* Setting the interval between 1Hz and 10Hz */
-	float set_interval = MAX_INTERVAL(new_scaler) + 1.0;
+	my_timer_begin_update(&dot_control_timer);
+	my_timer_apply(&dot_control_timer, setting);
+	/* Setting the compare unit relative to the period, in order to change the "brightness" of the LEDs */
+	my_timer_set_compare(&dot_control_timer, TIM_CHANNEL_2, compare_q16 >> 16);
+	dot_control_compare_q16 = compare_q16;
+	my_timer_end_update(&dot_control_timer);
+}
+
+/**
+ * @brief Maps an ADC value onto a duty cycle with the gamma table. The upper 8 bits select
+ *        the entry, the lower 4 bits interpolate linearly to the next one.
+ *
+ * @param adc ADC value (0 - 4095).
+ * @return Duty cycle in Q16 (0 - 65535).
+ */
+static uint32_t dot_control_gamma(uint32_t adc) {
+	uint32_t index;
+	uint32_t low;
+	uint32_t high;
+
+	if (adc > DOT_CONTROL_ADC_MAX) {
+		adc = DOT_CONTROL_ADC_MAX;
+	}
+	index = adc >> DOT_CONTROL_LUT_SHIFT;
+	low = dot_control_gamma_table[index];
+	high = (index < 255) ? dot_control_gamma_table[index + 1] : low;
+
+	return low + (((high - low) * (adc & ((1 << DOT_CONTROL_LUT_SHIFT) - 1)))
+			>> DOT_CONTROL_LUT_SHIFT);
+}
+
+/**
+ * @brief Update interrupt of TIM1, once per period. Adds the fraction of the compare value to the
+ *        accumulator and writes the compare value for the next period (preloaded): one higher,
+ *        if the accumulator has overflowed.
+ *
+ * @param none
+ * @return none
+ */
+void TIM1_UP_TIM10_IRQHandler(void) {
+	if (!__HAL_TIM_GET_FLAG(&dot_control_timer.handle, TIM_FLAG_UPDATE)) {
+		return;
+	}
+	__HAL_TIM_CLEAR_FLAG(&dot_control_timer.handle, TIM_FLAG_UPDATE);
 
-	/* Setting the prescaler to the desired frequency */
-	my_timer_set_prescaler(CORE_CLOCK(set_interval));
+	__HAL_TIM_SET_COMPARE(&dot_control_timer.handle, TIM_CHANNEL_2,
+			dot_control_dither_step(dot_control_compare_q16, &dot_control_dither_acc));
 }
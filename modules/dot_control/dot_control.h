@@ -14,6 +14,28 @@
 #ifndef DOT_CONTROL_H_
 #define DOT_CONTROL_H_
 
+/* Includes */
+#include <stdint.h>
+
+/* Public inline functions */
+/**
+ * @brief One period of the dithering (first order sigma-delta): adds the fraction of the compare
+ *        value to the accumulator and returns the compare value for the next period, one higher
+ *        if the accumulator has overflowed. Without hardware, so it can be tested on the host.
+ *
+ * @param compare_q16 Compare value in Q16.
+ * @param acc Accumulator, keeps the fraction (below 2^16) from period to period.
+ * @return Compare value for the register.
+ */
+static inline uint32_t dot_control_dither_step(uint32_t compare_q16, uint32_t *acc) {
+	uint32_t compare;
+
+	*acc += compare_q16 & 0xFFFF;
+	compare = (compare_q16 >> 16) + (*acc >> 16);
+	*acc &= 0xFFFF;
+	return compare;
+}
+
 /* Public functions (prototypes )*/
 void dot_control_init(); //Initializes all necessary peripherals for controlling frequency and brightness of LEDs.
 void dot_control_change_dimming(); //Changes the frequency and brightness of the LEDs based on the potentiometer values.
@@ -0,0 +1,135 @@
+/**
+ **************************************************
+ * @file ema.c
+ * @author Berkay Özgür, C. Arda Sengenc
+ * @version v1.0
+ * @date 17.10.2026
+ * @brief: Fixed-point exponential moving average (first order IIR low pass).
+ @verbatim
+ ==================================================
+ ### Description ###
+ y[n] = y[n-1] + alpha * (x[n] - y[n-1])
+
+ The state is kept with EMA_FRAC_BITS fractional bits, so the small steps of a
+ slow filter are not lost by truncation, and the output is rounded to the nearest
+ integer. A step of the state is rounded as well, it stays 0 once the state is
+ within 2^-EMA_FRAC_BITS / (2 * alpha) of the input. With 16 fractional bits this
+ dead band is below 1/4 for every coefficient (8 bits left a slow filter stuck
+ short of the input, e.g. 998 of 1000 with tau = 1000 samples). The coefficient is either a power of two (a single shift) or a Q15 value
+ (a single multiplication). There is no division in ema_update(), so the cost is
+ the same for every signal and every sample.
+
+ Every signal gets its own ema_t and it can be chained after any source,
+ e.g. ema_update(&filter, median_filter_update(&median, value)).
+
+ ==================================================
+ ### Usage ###
+
+ (#) Call "ema_init_time_constant()", "ema_init_alpha()" or "ema_init_shift()"
+ once for every filter.
+
+ (#) Call "ema_update()" with every new sample, it returns the filtered value.
+
+ @endverbatim
+ **************************************************
+ */
+
+/* Includes */
+#include "ema.h"
+
+/* Preprocessor macros */
+#define EMA_HALF ((int64_t) 1 << (EMA_FRAC_BITS - 1))
+
+/**
+ * @brief Initializes a filter with a Q15 coefficient.
+ * @param filter Pointer to the filter.
+ * @param alpha_q15 Weight of a new sample, 32768 would be 1.0 (no smoothing).
+ * @return none
+ */
+void ema_init_alpha(ema_t *filter, uint16_t alpha_q15) {
+	filter->alpha = alpha_q15;
+	filter->shift = 0;
+	ema_reset(filter);
+}
+
+/**
+ * @brief Initializes a filter with the coefficient 2^-shift.
+ * @param filter Pointer to the filter.
+ * @param shift e.g. 3 gives every new sample a weight of 1/8. Must be 1 to 15.
+ * @return none
+ */
+void ema_init_shift(ema_t *filter, uint8_t shift) {
+	filter->alpha = 0;
+	filter->shift = shift;
+	ema_reset(filter);
+}
+
+/**
+ * @brief Initializes a filter from a time constant and the sample period.
+ *        The coefficient is alpha = T / (tau + T), the discrete version of a
+ *        first order low pass. The division is only done here, not per sample.
+ * @param filter Pointer to the filter.
+ * @param tau_us Time constant in microseconds.
+ * @param sample_period_us Time between two calls of ema_update() in microseconds.
+ * @return none
+ */
+void ema_init_time_constant(ema_t *filter, uint32_t tau_us,
+		uint32_t sample_period_us) {
+	uint64_t sum = (uint64_t) tau_us + sample_period_us;
+	uint32_t alpha;
+
+	if (sum == 0) {
+		alpha = 1 << 15;
+	} else {
+		alpha = (((uint64_t) sample_period_us << 15) + sum / 2) / sum;
+	}
+	/* alpha = 0 would freeze the filter */
+	if (alpha == 0) {
+		alpha = 1;
+	}
+	ema_init_alpha(filter, alpha);
+}
+
+/**
+ * @brief Forgets the history, the next sample is taken over directly.
+ * @param filter Pointer to the filter.
+ * @return none
+ */
+void ema_reset(ema_t *filter) {
+	filter->state = 0;
+	filter->primed = 0;
+}
+
+/**
+ * @brief Feeds a new sample into the filter.
+ * @param filter Pointer to the filter.
+ * @param input New sample.
+ * @return Filtered value, rounded to the nearest integer.
+ */
+uint32_t ema_update(ema_t *filter, uint32_t input) {
+	int64_t x = (int64_t) input << EMA_FRAC_BITS;
+
+	if (!filter->primed) {
+		/* No start-up ramp from 0, the first sample is the start value */
+		filter->state = x;
+		filter->primed = 1;
+	} else if (filter->shift) {
+		/* Arithmetic shift with rounding to nearest */
+		filter->state += ((x - filter->state) + ((int64_t) 1 << (filter->shift - 1)))
+				>> filter->shift;
+	} else {
+		/* 49x16 bit product, below 2^63 for every 32 bit input and alpha up to 1.0,
+		 * rounded back to Q(EMA_FRAC_BITS) */
+		filter->state += ((x - filter->state) * filter->alpha + (1 << 14)) >> 15;
+	}
+	return ema_get(filter);
+}
+
+/**
+ * @brief Returns the filtered value without feeding a new sample.
+ * @param filter Pointer to the filter.
+ * @return Filtered value, rounded to the nearest integer.
+ */
+uint32_t ema_get(const ema_t *filter) {
+	return (uint32_t) ((filter->state + EMA_HALF) >> EMA_FRAC_BITS);
+}
@@ -0,0 +1,41 @@
+/**
+**************************************************
+* @file ema.h
+* @author Berkay Özgür, C. Arda Sengenc
+* @version v1.0
+* @date 17.10.2026
+* @brief: Header file for the fixed-point exponential smoothing (EMA) module.
+**************************************************
+*/
+
+#ifndef EMA_EMA_H_
+#define EMA_EMA_H_
+
+/* Includes */
+#include <stdint.h>
+
+/* Public preprocessor macros */
+/* Fractional bits of the internal state (64 bit, so inputs may use all 32 bits). With 16 bits the
+ * smallest coefficients (alpha 1/32768, shift 15) still move the state until it is within 1/4 of
+ * the input, so the rounded output reaches every constant input */
+#define EMA_FRAC_BITS 16
+/* Coefficient num/den as Q15, e.g. EMA_ALPHA_Q15(1, 5) for the old (4*last + new) / 5 */
+#define EMA_ALPHA_Q15(num, den) ((uint16_t)((((uint32_t)(num) << 15) + (den) / 2) / (den)))
+
+/* Public types */
+typedef struct {
+	int64_t state;   // filtered value in Q(EMA_FRAC_BITS)
+	uint16_t alpha;  // coefficient in Q15, used if shift is 0
+	uint8_t shift;   // coefficient 2^-shift, 0 selects alpha
+	uint8_t primed;  // 0 until the first sample has been seen
+} ema_t;
+
+/* Public functions (prototypes) */
+void ema_init_alpha(ema_t *filter, uint16_t alpha_q15);
+void ema_init_shift(ema_t *filter, uint8_t shift);
+void ema_init_time_constant(ema_t *filter, uint32_t tau_us, uint32_t sample_period_us);
+void ema_reset(ema_t *filter);
+uint32_t ema_update(ema_t *filter, uint32_t input);
+uint32_t ema_get(const ema_t *filter);
+
+#endif /* EMA_EMA_H_ */
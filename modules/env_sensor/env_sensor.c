@@ -15,7 +15,10 @@
 
  I2C: I2C1
 
- TIMER: Timer 2 for microseconds.
+ TIMER: Global timebase (TIM5, see timebase.c) for microseconds.
+
+ SOFT_TIMER: One periodic timer (not in the interrupt) reads the sensor at its data rate, as soon as
+ the first subscriber is registered.
 
  Bosch BME280.
 
@@ -27,6 +30,12 @@
  (#) Call "env_sensor_get_value(env_sensor_t input)" in main-function's while-loop to read
      desired data from sensor. (For parameter, see env_sensor.h)
 
+ (#) Event driven usage: Call "env_sensor_subscribe(callback)" once for every consumer. Then the sensor
+     is read once per measurement of the BME280 (standby time plus measurement time, see
+     "env_sensor_get_period_ms()"), and every callback runs with the new values, that it reads with
+     "env_sensor_get_last()". The reading runs in "soft_timer_process()", so soft_timer_init() must
+     have been called and soft_timer_process() must run in main-function's while-loop.
+
 
  @endverbatim
  **************************************************
@@ -60,9 +69,13 @@
 #include "bme280.h"
 #include "utils.h"
 #include "env_sensor.h"
+#include <timebase/timebase.h>
+#include <soft_timer/soft_timer.h>
 
 /* Preprocessor macros */
 #define DEVICE_ADDRESS 0x76
+/* Standby time between two measurements in normal mode, as set with BME280_STANDBY_TIME_62_5_MS */
+#define ENV_SENSOR_STANDBY_US 62500
 
 /* Module variables */
 // Variable to store the temperature value obtained from the BME280 sensor.
@@ -77,9 +90,16 @@ float env_sensor_pressure;
 // Variable to store the result or status of BME280 API functions.
 int8_t env_sensor_rslt;
 
-// Variable to store the period value used for delays or timing calculations.
+// Variable to store the period value used for delays or timing calculations (time between two measurements in ms).
 uint32_t env_sensor_period;
 
+/* Periodic timer, that reads the sensor for the subscribers */
+soft_timer_t env_sensor_timer;
+
+/* Registered consumers of the periodic measurement */
+static env_sensor_callback_t env_sensor_callbacks[ENV_SENSOR_MAX_SUBSCRIBERS];
+static uint8_t env_sensor_callback_count = 0;
+
 /* Module structs  */
 // Structure that represents the BME280 device.
 struct bme280_dev env_sensor_dev;
@@ -93,19 +113,16 @@ struct bme280_settings env_sensor_settings;
 // I2C handle structure for the I2C communication interface.
 I2C_HandleTypeDef env_sensor_hi2c1;
 
-// Timer handle structure for the weather timer
-TIM_HandleTypeDef env_sensor_tim_handle_struct_weather;
-
 /* ### Static Functions ###
 
- (#) "env_sensor_timer_init" for Initializing the weather timer (TIM2) for precise counting.
-
  (#) "env_sensor_gpio_init" for Initializing the GPIO pins used for the I2C interface.
 
  (#) "env_sensor_i2c_init" for Initializing the I2C interface for communication.
 
  (#) "env_sensor_bosch_init" for Initializing the BME280 sensor.
 
+ (#) "env_sensor_sample" for Reading the sensor periodically and calling the subscribers.
+
  (#) "user_delay_us" for Delaying the execution for the specified microseconds.
 
  (#) "user_i2c_write" for Writing data to the sensor's registers through the I2C bus.
@@ -118,7 +135,6 @@ TIM_HandleTypeDef env_sensor_tim_handle_struct_weather;
 /* Static module functions */
 void Error_Handler(void);
 static void env_sensor_gpio_init(void);
-static void env_sensor_timer_init(void);
 static void user_delay_us(uint32_t period, void *intf_ptr);
 static int8_t user_i2c_write(uint8_t reg_addr, const uint8_t *data,
 		uint32_t len, void *intf_ptr);
@@ -126,6 +142,7 @@ static int8_t user_i2c_read(uint8_t reg_addr, uint8_t *data, uint32_t len,
 		void *intf_ptr);
 static void env_sensor_i2c_init(void);
 static void env_sensor_bosch_init(void);
+static void env_sensor_sample(void *arg);
 
 
 /**
@@ -134,7 +151,7 @@ static void env_sensor_bosch_init(void);
  * This function initializes the necessary components and configurations to use the environmental sensor.
  * It performs the following steps:
  *   1. Initializes the microcontroller HAL.
- *   2. Initializes the weather timer (TIM2) for precise counting.
+ *   2. Initializes the global timebase for the microsecond delays.
  *   3. Initializes the GPIO pins used for the I2C interface.
  *   4. Initializes the I2C interface for communication.
  *   5. Initializes the BME280 sensor.
@@ -147,7 +164,7 @@ static void env_sensor_bosch_init(void);
 void env_sensor_init(void) {
 	HAL_Init();
 
-	env_sensor_timer_init();
+	timebase_init();
 
 	env_sensor_gpio_init();
 
@@ -224,7 +241,7 @@ static void env_sensor_bosch_init(void) {
 	env_sensor_dev.settings.standby_time = BME280_STANDBY_TIME_62_5_MS;
 
 	settings_sel = BME280_OSR_PRESS_SEL | BME280_OSR_TEMP_SEL
-			| BME280_OSR_HUM_SEL | BME280_FILTER_SEL;
+			| BME280_OSR_HUM_SEL | BME280_FILTER_SEL | BME280_STANDBY_SEL;
 
 	// Set the sensor settings based on the selected configuration.
 	env_sensor_rslt = bme280_set_sensor_settings(settings_sel, &env_sensor_dev);
@@ -232,6 +249,10 @@ static void env_sensor_bosch_init(void) {
 	// Set the sensor mode to normal mode for continuous measurements.
 	env_sensor_rslt = bme280_set_sensor_mode(BME280_NORMAL_MODE,
 			&env_sensor_dev);
+
+	// In normal mode a new measurement is ready after every measurement and standby time.
+	env_sensor_period = (bme280_cal_meas_delay(&env_sensor_dev.settings) * 1000
+			+ ENV_SENSOR_STANDBY_US + 999) / 1000;
 }
 
 /**
@@ -294,6 +315,83 @@ float env_sensor_get_value(env_sensor_t input) {
 
 }
 
+/**
+ * @brief Registers a callback, which is called with every new measurement of the sensor.
+ *        The first subscriber starts the periodic reading of the sensor.
+ *
+ * @param callback Function to call. It reads the new values with env_sensor_get_last().
+ * @return 0 on success, -1 if there is no free slot left.
+ *
+ */
+int8_t env_sensor_subscribe(env_sensor_callback_t callback) {
+	if (env_sensor_callback_count >= ENV_SENSOR_MAX_SUBSCRIBERS) {
+		return -1;
+	}
+	env_sensor_callbacks[env_sensor_callback_count] = callback;
+	env_sensor_callback_count++;
+
+	if (!soft_timer_is_active(&env_sensor_timer)) {
+		/* The I2C transfer blocks, so the reading runs in soft_timer_process() and not in the interrupt */
+		soft_timer_setup(&env_sensor_timer, env_sensor_sample, 0, 0);
+		soft_timer_start(&env_sensor_timer, soft_timer_ms_to_ticks(env_sensor_period),
+				soft_timer_ms_to_ticks(env_sensor_period));
+	}
+	return 0;
+}
+
+/**
+ * @brief Returns a value of the last periodic measurement, without an I2C transfer.
+ *
+ * @param input The type of value to be retrieved (temperature, humidity, or pressure).
+ * @return The value of the last measurement, 0 before the first one.
+ *
+ */
+float env_sensor_get_last(env_sensor_t input) {
+	switch (input) {
+	case ENV_TEMPERATURE:
+		return env_sensor_temperature;
+	case ENV_HUMIDITY:
+		return env_sensor_humidity;
+	case ENV_PRESSURE:
+		return env_sensor_pressure;
+	}
+	return 0;
+}
+
+/**
+ * @brief Returns the time between two measurements of the sensor, the rate of the subscribers.
+ *
+ * @param none
+ * @return Time in milliseconds.
+ *
+ */
+uint32_t env_sensor_get_period_ms(void) {
+	return env_sensor_period;
+}
+
+/**
+ * @brief Periodic reading (soft_timer callback): gets the newest measurement and calls the subscribers.
+ *        If the transfer fails, the old values stay and nobody is called.
+ *
+ * @param arg unused
+ * @return none
+ *
+ */
+static void env_sensor_sample(void *arg) {
+	env_sensor_rslt = bme280_get_sensor_data(BME280_ALL, &env_sensor_comp_data,
+			&env_sensor_dev);
+	if (env_sensor_rslt != BME280_OK) {
+		return;
+	}
+	env_sensor_temperature = env_sensor_comp_data.temperature;
+	env_sensor_humidity = env_sensor_comp_data.humidity;
+	env_sensor_pressure = env_sensor_comp_data.pressure;
+
+	for (uint8_t i = 0; i < env_sensor_callback_count; i++) {
+		env_sensor_callbacks[i]();
+	}
+}
+
 /**
  * @brief Writes data to the sensor's registers through the I2C bus.
  * @param reg_addr The register address to write to.
@@ -365,19 +463,14 @@ static int8_t user_i2c_read(uint8_t reg_addr, uint8_t *data, uint32_t len,
  * @param intf_ptr Pointer to the interface structure
  * @note This function introduces a delay in the execution by waiting for the specified number of microseconds.
  *
- * This function provides a microsecond delay by utilizing the TIM2 timer peripheral.
- * It starts the timer, enters a loop until the specified period in microseconds is reached, stops the timer,
- * and resets its count value. The function enables precise timing by utilizing the hardware timer.
+ * This function provides a microsecond delay by utilizing the global timebase (TIM5).
+ * The timer keeps running, so no timer has to be started, stopped or reset here.
+ * The core sleeps while waiting for the measurement, very short delays are busy waits.
  *
  * @return none
  */
 static void user_delay_us(uint32_t period, void *intf_ptr) {
-	HAL_TIM_Base_Start(&env_sensor_tim_handle_struct_weather);
-
-	while (__HAL_TIM_GET_COUNTER(&env_sensor_tim_handle_struct_weather) < period) {
-	}
-	HAL_TIM_Base_Stop(&env_sensor_tim_handle_struct_weather);
-	__HAL_TIM_SET_COUNTER(&env_sensor_tim_handle_struct_weather, 0);
+	timebase_sleep_us(period);
 }
 
 /**
@@ -396,33 +489,6 @@ void Error_Handler(void) {
 	/* USER CODE END Error_Handler_Debug */
 }
 
-/**
- * @brief Initializes the weather timer (TIM2) for precise counting.
- * @note This function configures and initializes the weather timer (TIM2) for precise timekeeping and counting.
- *
- * @param none
- * @return none
- */
-static void env_sensor_timer_init(void) {
-	__HAL_RCC_TIM2_CLK_ENABLE();
-
-	env_sensor_tim_handle_struct_weather.Instance = TIM2;
-
-	env_sensor_tim_handle_struct_weather.Init.Prescaler = (SystemCoreClock / 2
-			/ 1000000) - 1;
-
-	env_sensor_tim_handle_struct_weather.Init.Period = 10000000 - 1;
-
-	env_sensor_tim_handle_struct_weather.Init.CounterMode = TIM_COUNTERMODE_UP;
-	env_sensor_tim_handle_struct_weather.Init.ClockDivision =
-	TIM_CLOCKDIVISION_DIV1;
-	env_sensor_tim_handle_struct_weather.Init.AutoReloadPreload =
-	TIM_AUTORELOAD_PRELOAD_DISABLE;
-
-	env_sensor_tim_handle_struct_weather.Init.RepetitionCounter = 0;
-	HAL_TIM_Base_Init(&env_sensor_tim_handle_struct_weather);
-}
-
 //void env_sensor_can_init(void) {
 //	CAN_HandleTypeDef can_handle_struct;
 //	can_handle_struct.Instance = CAN1;
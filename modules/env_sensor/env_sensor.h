@@ -11,6 +11,12 @@
 #ifndef ENV_SENSOR_ENV_SENSOR_H_
 #define ENV_SENSOR_ENV_SENSOR_H_
 
+/* Includes */
+#include <stdint.h>
+
+/* Public preprocessor macros */
+#define ENV_SENSOR_MAX_SUBSCRIBERS 4
+
 /* Public enums as shortcuts for each sensor */
 typedef enum {
 	ENV_TEMPERATURE,
@@ -18,9 +24,15 @@ typedef enum {
 	ENV_PRESSURE,
 } env_sensor_t;
 
+/* Public types */
+typedef void (*env_sensor_callback_t)(void);
+
 /* Public functions (prototypes)*/
 void env_sensor_init(void);
 float env_sensor_get_value(env_sensor_t input);
+int8_t env_sensor_subscribe(env_sensor_callback_t callback);
+float env_sensor_get_last(env_sensor_t input);
+uint32_t env_sensor_get_period_ms(void);
 
 
 #endif /* ENV_SENSOR_ENV_SENSOR_H_ */
@@ -10,49 +10,97 @@
  * value of a signal is adjusted by varying the width of its pulses while keeping the frequency constant. By adjusting the duty cycle
  * of the PWM signal, the average voltage or power delivered to the fan motor can be controlled. This, in turn, affects the fan's speed.
  * Higher duty cycles result in higher average voltage/power and faster fan speeds, while lower duty cycles result in lower speeds.
+ * Up to FAN_CONTROL_MAX_FANS fans are controlled independently, each one is a fan_t with its own channels,
+ * RPM estimation, controller and target.
  *
  @verbatim
  ==================================================
  ### Resources used ###
 
- TIM2: It is  used to measure the time intervals between consecutive interrupts triggered by a GPIO pin (PB1).
- It is started when the first interrupt occurs and stopped when the second interrupt occurs. The time interval between
- these two interrupts is then used to calculate the actual RPM of the fan. Timer TIM2 is configured in the code to count up with
- a specific prescaler and period, allowing accurate measurement of time intervals.
+ TIM2: Free-running 32 bit counter with 1 MHz. Every fan uses one of its four channels, that captures the counter
+ value at every rising edge of the tacho signal in hardware, so every period is measured and the jitter is one
+ timer tick (1 us), no matter how late an interrupt runs. The time between the edges is then used to calculate
+ the actual RPM of the fan.
 
- TIM3: Timer TIM3 is used to generate the PWM signal that controls the fan speed. It is responsible for generating
- the PWM signal with a specific frequency (f_pwm) and duty cycle (controlled by the control output calculated in the regulateFanSpeed() function).
- Timer TIM3 is configured to count up with a specific prescaler and period, which determines the PWM frequency and resolution.
+ DMA1, DMA_CHANNEL_3: One stream per capture channel copies every captured value into the ring of FAN_CORE_TACHO_RING
+ timestamps of its fan (circular mode). No interrupt is used, the counter of the DMA tells how many edges have arrived.
+ TIM2_CH1: DMA1_Stream5, TIM2_CH2: DMA1_Stream6, TIM2_CH3: DMA1_Stream1, TIM2_CH4: DMA1_Stream7.
+ HAL_TIM_IC_Start_DMA() is not used, it refuses a second channel while the timer handle is busy with the first one.
 
- PB1: configured for interrupt-based tachometer output (Grün-TACHO_AUSGANG).
+ SOFT_TIMER: One periodic timer (tick of the timebase, TIM5) runs the control of all fans every FAN_CORE_SAMPLE_MS
+ in the tick interrupt: for every fan the RPM is estimated from the newest timestamps and its PI controller (pi_ctrl,
+ Q16 fixed point) sets the duty cycle. The sample time is therefore fixed and does not depend on the fan speed,
+ the time of one tick grows linearly with the number of fans.
 
- PB5: configured for PWM input (BLAU-PWM-Eingang) signal.
+ fan_core: the RPM estimation (median of the newest periods, stall detection), the PI controller, the feed-forward
+ table and the auto-tuning of every fan do not touch the hardware (see fan_core.c). The tick hands them the DMA
+ counter and writes the duty, that they return, so the same code runs on a PC against the simulated fan
+ (fan_sim.c, "make -C tests"). "fan_control_get_quality()" tells how far the RPM can be trusted.
+
+ TIM3: Timer TIM3 is used to generate the PWM signals that control the fan speeds, one channel per fan. It is responsible
+ for generating the PWM signal with a specific frequency (FAN_CONTROL_PWM_HZ) and duty cycle (controlled by the control output
+ returned by fan_core_sample()). Timer TIM3 counts up with the full timer clock, so the period has the most
+ compare steps, that the clock allows at this frequency (25 kHz: 640 steps at 16 MHz). All fans share this frequency.
+ The controller works with a Q15 duty command, that is scaled to the compare steps only when it is written, so the
+ controller does not depend on the PWM frequency and uses the full resolution.
+
+ Tacho pins (AF1, pull-up):         TIM2_CH1 PA5, TIM2_CH2 PB3, TIM2_CH3 PB10, TIM2_CH4 PB11.
+ PWM pins (AF2, open drain):        TIM3_CH1 PB4, TIM3_CH2 PB5, TIM3_CH3 PB0,  TIM3_CH4 PB1.
+
+ fan_control_fan: the fan of the board, tacho on PA5 (Grün-TACHO_AUSGANG), PWM on PB5 (BLAU-PWM-Eingang).
+ Before, the tacho was read with EXTI1 on PB1, PB1 has no TIM2 channel, so the green wire moved to PA5.
 
 
  ==================================================
  ### Usage ###
 
- (#) Call "fan_control_init()" to initialize the module and all the necessary peripheries.
+ (#) Call "fan_control_init()" to initialize the module and all the necessary peripheries. It adds fan_control_fan.
+
+ (#) Call "fan_control_add()" for every further fan with its capture and PWM channel, e.g.
+ 	 static fan_t fan_2;
+ 	 fan_control_add(&fan_2, 2, 1);
+ 	 Then set its target with "fan_control_set_target()" and read it with "fan_control_get_rpm()".
 
  (#) Call "fan_control_show_status()" in main-function's while-loop to see target RPM, and current RPM.
- 	 Alternative: We are now printing the same values in main.c with extern variables.
+ 	 Alternative: We are now printing the same values in main.c with "fan_control_get_rpm()" and the other getters.
 
- (#) Call "fan_control_set_rpm()" in main-function's while loop to set the target RPM with potentiometer.
+ (#) Call "fan_control_set_rpm()" in main-function's while loop to set the target RPM of fan_control_fan with potentiometer.
+ 	 Alternative: Subscribe it with "potis_dma_subscribe()", so it only runs when the potentiometer has changed.
 
+ (#) Simulation: "make -C tests" runs fan_core against a simulated fan (fan_sim.c) on a PC, faster than real time.
+ 	 It measures rise time, overshoot, settling time and steady state error of step responses with the default,
+ 	 the fed forward and the tuned control and fails, if they miss their limits ("fan_sim_metrics_check()").
+ 	 Run it after every change of the controller.
 
+ (#) Optional: call "fan_control_learn_feedforward()" once after the init. For FAN_CORE_FF_POINTS * FAN_CORE_FF_SETTLE_MS
+ 	 the duty steps from FAN_CORE_MIN_DUTY to FAN_CORE_MAX_DUTY and the steady RPM of every step is stored in a monotone table
+ 	 ("fan_control_feedforward_ready()" tells when it is done). Afterwards every new target moves the duty at once by
+ 	 the difference of the interpolated duties (feed-forward), the PI controller only trims the residual error, so
+ 	 a new target settles in a fraction of the time.
 
- ### Static Functions ###
+ (#) Optional: call "fan_control_autotune()" to replace the gains of the PI controller by measured ones. For at most
+ 	 FAN_CORE_TUNE_MAX_MS the duty toggles between FAN_CORE_MIN_DUTY and FAN_CORE_MAX_DUTY around the current target
+ 	 (relay_tune.c), the fan oscillates and the gains follow from its amplitude and period.
+ 	 "fan_control_get_autotune_state()" tells when it is over, if it fails the old gains stay.
 
- (#) " EXTI1_IRQHandler" for the interrupt handler for the EXTI1 (External Interrupt Line 1) interrupt.
- For more detailed information, see below.
+ (#) Thermal mode: call "fan_control_set_curve()" with a curve of target RPM over temperature, then
+ 	 "fan_control_set_temperature()" with every new temperature (e.g. subscribed with "env_sensor_subscribe()",
+ 	 so it runs at the data rate of the sensor). The target follows the curve, linear between its points. When
+ 	 the temperature falls, the target only follows after it has fallen by the hysteresis of the curve, so a
+ 	 temperature, that jitters around a point, does not make the fan speed up and slow down all the time.
+ 	 With a curve the potentiometer ("fan_control_set_rpm()") does not change the target.
 
- (#) " HAL_GPIO_EXTI_Callback" for handling the EXTI interrupt triggered by PB1.
- It starts and stops Timer 2 to measure the time interval of the fan rotation and adjusts the fan speed accordingly.
- For more detailed information, see below.
+ (#) Optional: call "fan_control_set_tacho_window()" to choose of how many periods the median is taken
+ 	 (1 ... FAN_CORE_TACHO_RING / 2 - 1, odd). More periods reject more outliers, but react slower.
+
+ 	 The feed-forward table, the auto-tuning and the tacho window belong to one fan each.
+
+
+
+ ### Static Functions ###
 
- (#) "regulateFanSpeed()" for calculating the actual RPM of the fan based on the measured time interval and
- adjusts the fan speed using a proportional-integral (PI) control algorithm. It limits the output value within the
- specified range and updates the error sum accordingly.
+ (#) "fan_control_tick()" runs "fan_core_sample()" of every fan with the DMA counter of its tacho and sets the duty,
+ that it returns (see fan_core.c for the RPM estimation and the PI controller).
 
  @endverbatim
  **************************************************
@@ -66,64 +114,95 @@
 #include <my_timer.h>
 #include <potis_dma.h>
 #include <utils.h>
-
-/**
- * The Proportional-Integral (PI) controller is commonly used in control systems to regulate a process variable based on an error signal.
- * In the context of fan speed control, a PI controller is used to adjust the fan speed and maintain it at a desired setpoint.
- *
- * Proportional Control: The proportional term (Kp * error) in the controller output allows for an immediate response to the error signal.
- * It provides a control action that is proportional to the difference between the desired fan speed (target RPM) and the actual
- * fan speed (measured RPM). The proportional control helps to reduce the steady-state error and improve the system's responsiveness.
- *
- * Integral Control: The integral term (Ki * errorSum) in the controller output takes into account the accumulated error over time.
- * It helps to eliminate the steady-state error by continuously integrating the error signal. The integral control component is
- * particularly useful when there are factors such as friction or external disturbances that can cause a deviation from the desired fan speed.
- *
- * By combining both proportional and integral control, the PI controller provides a balance between
- * immediate response (proportional control) and long-term error correction (integral control).
- * It helps to stabilize the fan speed control system, minimize the deviation from the target RPM,
- * and improve the overall performance and accuracy of the fan speed regulation.
- */
+#include <soft_timer/soft_timer.h>
+#include <relay_tune/relay_tune.h>
 
 /* Static module functions */
-void EXTI1_IRQHandler(void);
-static void regulateFanSpeed();
-static void fan_control_pins_init();
+static void fan_control_tick(void *arg);
+static uint32_t fan_control_tacho_written(const fan_t *fan);
+static void fan_control_set_duty(fan_t *fan, uint32_t duty);
+static uint32_t fan_control_duty_compare(uint32_t duty);
+static uint32_t fan_control_curve_rpm(const fan_control_curve_t *curve, int32_t temperature);
 static void fan_control_timer_2_init();
 static void fan_control_timer_3_init();
+static void fan_control_tacho_init(fan_t *fan);
+static void fan_control_pwm_init(const fan_t *fan);
 
 /* Preprocessor macros */
-#define MAX_PWM 199
-#define MIN_PWM 15
+/* No temperature has been set on the curve yet */
+#define FAN_CONTROL_CURVE_NONE INT32_MIN
+/* Counter frequency of the capture timer, one tick is the resolution of a period */
+#define FAN_CONTROL_TACHO_HZ 1000000
+/* Input filter of the capture channel: 8 samples with fDTS / 32 (16 us at 16 MHz) against bouncing edges */
+#define FAN_CONTROL_TACHO_FILTER 0x0F
 
 // BLUE is connected to PB5. PWM_INPUT - Open-Drain. Has the TIM3_CH2 function.
-// GREEN is connected to PB1. TACHO_OUTPUT - pull-up resistor.
+// GREEN is connected to PA5. TACHO_OUTPUT - pull-up resistor. Has the TIM2_CH1 function.
 // YELLOW is connected  to an 5V Energy Source
 // ORANGE is connected an GND which stands for ground
 
 /* Module variables */
-volatile uint32_t fan_control_time_interval = 0;
-volatile uint8_t fan_start_flag = 0;
-volatile uint32_t frequency = 10000;
-volatile uint32_t fan_control_actual_RPM = 0;
-volatile uint32_t targetRPM = 0;
-volatile int32_t errorSum = 0;
+volatile uint32_t frequency = FAN_CONTROL_TACHO_HZ;
 volatile uint32_t fan_control_poti_val = 0;
-// The suitable parameters for the PI Controller
-volatile float Kp = 0.98;
-volatile float Ki = 2.1;
-volatile float output = 0.0;
-
-TIM_HandleTypeDef fan_control_tim_2_handle_struct;
-TIM_HandleTypeDef fan_control_tim_3_handle_struct;
-TIM_OC_InitTypeDef fan_control_tim_oc_handle_struct;
+fan_t fan_control_fan;
+
+my_timer_t fan_control_tim_2;
+my_timer_t fan_control_tim_3;
+/* One DMA stream per capture channel of TIM2 (index channel - 1) */
+DMA_HandleTypeDef fan_control_dma_handle_struct[FAN_CONTROL_MAX_FANS];
+/* The periodic timer, that runs the control of all fans */
+soft_timer_t fan_control_timer;
+
+/* Fans, that the tick controls. A fan is counted after it is complete */
+static fan_t *fan_control_fans[FAN_CONTROL_MAX_FANS];
+static volatile uint8_t fan_control_fan_count = 0;
+
+/* HAL channels of the channel numbers 1 ... 4 */
+static const uint32_t fan_control_channels[FAN_CONTROL_MAX_FANS] = {
+	TIM_CHANNEL_1, TIM_CHANNEL_2, TIM_CHANNEL_3, TIM_CHANNEL_4,
+};
+
+/* Pin and DMA stream of a capture channel of TIM2 */
+typedef struct {
+	GPIO_TypeDef *port;
+	uint16_t pin;
+	DMA_Stream_TypeDef *stream;
+	uint16_t dma_id;		// index of the DMA handle in the timer handle
+	uint32_t dma_request;	// capture compare DMA request of the channel
+} fan_control_tacho_hw_t;
+
+/* Pin of a PWM channel of TIM3 */
+typedef struct {
+	GPIO_TypeDef *port;
+	uint16_t pin;
+} fan_control_pwm_hw_t;
+
+/* For TIM2_CH1 ... CH4 we need according to Table 42 these streams, all with DMA_CHANNEL_3 */
+static const fan_control_tacho_hw_t fan_control_tacho_hw[FAN_CONTROL_MAX_FANS] = {
+	{ GPIOA, GPIO_PIN_5, DMA1_Stream5, TIM_DMA_ID_CC1, TIM_DMA_CC1 },
+	{ GPIOB, GPIO_PIN_3, DMA1_Stream6, TIM_DMA_ID_CC2, TIM_DMA_CC2 },
+	{ GPIOB, GPIO_PIN_10, DMA1_Stream1, TIM_DMA_ID_CC3, TIM_DMA_CC3 },
+	{ GPIOB, GPIO_PIN_11, DMA1_Stream7, TIM_DMA_ID_CC4, TIM_DMA_CC4 },
+};
+
+static const fan_control_pwm_hw_t fan_control_pwm_hw[FAN_CONTROL_MAX_FANS] = {
+	{ GPIOB, GPIO_PIN_4 },
+	{ GPIOB, GPIO_PIN_5 },
+	{ GPIOB, GPIO_PIN_0 },
+	{ GPIOB, GPIO_PIN_1 },
+};
+
+/* Compare steps of one PWM period (ARR + 1 of TIM3) */
+static uint32_t fan_control_pwm_period;
 
 /* Public functions */
 
 /**
  * @brief Initializes the whole fan control system.
  *        This function initializes the necessary components and peripherals for the fan control system,
- *        including HAL, potentiometer DMA, LCD, fan control pins, timer 2 and timer 3 with output compare.
+ *        including HAL, potentiometer DMA, LCD, timer 2 for the tachos and timer 3 for the PWM.
+ *        Then the fan of the board is added as fan_control_fan and at last the control of all fans
+ *        is started with its fixed sample time.
  *
  * @param none
  * @return none
@@ -136,11 +215,170 @@ void fan_control_init() {
 
 	lcd_init();
 
-	fan_control_pins_init();
-
 	fan_control_timer_2_init();
 
 	fan_control_timer_3_init();
+
+	fan_control_add(&fan_control_fan, 1, 2);
+
+	/* The control runs directly in the tick interrupt, so the sample time does not jitter with the main loop */
+	soft_timer_init(0);
+	soft_timer_setup(&fan_control_timer, fan_control_tick, 0, SOFT_TIMER_ISR);
+	soft_timer_start(&fan_control_timer, soft_timer_ms_to_ticks(FAN_CORE_SAMPLE_MS),
+			soft_timer_ms_to_ticks(FAN_CORE_SAMPLE_MS));
+}
+
+/**
+ * @brief Adds a fan to the control. Its PWM starts at FAN_CORE_MIN_DUTY with the target 0, from the next
+ *        tick on it is controlled like all others. Call it after fan_control_init().
+ *
+ * @param fan The fan, it must stay valid (static or global).
+ * @param tacho_channel Capture channel of TIM2 for the tacho (1 ... 4).
+ * @param pwm_channel PWM channel of TIM3 (1 ... 4).
+ * @return 0 on success, -1 if a channel is invalid or already used or FAN_CONTROL_MAX_FANS are added.
+ *
+ */
+int8_t fan_control_add(fan_t *fan, uint8_t tacho_channel, uint8_t pwm_channel) {
+	uint8_t count = fan_control_fan_count;
+
+	if (count >= FAN_CONTROL_MAX_FANS || tacho_channel < 1
+			|| tacho_channel > FAN_CONTROL_MAX_FANS || pwm_channel < 1
+			|| pwm_channel > FAN_CONTROL_MAX_FANS) {
+		return -1;
+	}
+	for (uint8_t i = 0; i < count; i++) {
+		if (fan_control_fans[i] == fan || fan_control_fans[i]->tacho_channel == tacho_channel
+				|| fan_control_fans[i]->pwm_channel == pwm_channel) {
+			return -1;
+		}
+	}
+
+	fan->tacho_channel = tacho_channel;
+	fan->pwm_channel = pwm_channel;
+	fan->curve = 0;
+	fan->curve_temperature = FAN_CONTROL_CURVE_NONE;
+	/* The RPM calculation uses the frequency, that TIM2 actually counts with */
+	fan_core_init(&fan->core, frequency);
+
+	fan_control_pwm_init(fan);
+
+	fan_control_tacho_init(fan);
+
+	/* Counted last, so the tick never sees a fan, that is not complete */
+	fan_control_fans[count] = fan;
+	fan_control_fan_count = count + 1;
+	return 0;
+}
+
+/**
+ * @brief Sets the target RPM of a fan.
+ *
+ * @param fan The fan.
+ * @param rpm Target RPM.
+ * @return none
+ *
+ */
+void fan_control_set_target(fan_t *fan, uint32_t rpm) {
+	fan_core_set_target(&fan->core, rpm);
+}
+
+/**
+ * @brief Returns the target RPM of a fan (set manually or by its curve).
+ *
+ * @param fan The fan.
+ * @return Target RPM.
+ *
+ */
+uint32_t fan_control_get_target(const fan_t *fan) {
+	return fan_core_get_target(&fan->core);
+}
+
+/**
+ * @brief Switches a fan into the thermal mode: from now on fan_control_set_temperature() sets its
+ *        target with the curve. The first temperature sets the target directly.
+ *
+ * @param fan The fan.
+ * @param curve The curve, it must stay valid (static or global). 0 for the manual target again.
+ * @return 0 on success, -1 if the curve has no points, too many or temperatures, that do not ascend.
+ *
+ */
+int8_t fan_control_set_curve(fan_t *fan, const fan_control_curve_t *curve) {
+	if (curve != 0) {
+		if (curve->count < 1 || curve->count > FAN_CONTROL_CURVE_MAX_POINTS
+				|| curve->hysteresis < 0) {
+			return -1;
+		}
+		for (uint8_t i = 1; i < curve->count; i++) {
+			if (curve->points[i].temperature <= curve->points[i - 1].temperature) {
+				return -1;
+			}
+		}
+	}
+	fan->curve_temperature = FAN_CONTROL_CURVE_NONE;
+	fan->curve = curve;
+	return 0;
+}
+
+/**
+ * @brief Sets the target of every fan in the thermal mode from a new temperature.
+ *        While the temperature rises, the target follows the curve at once. While it falls, the
+ *        temperature on the curve stays until the temperature is hysteresis below it, then it follows
+ *        at this distance.
+ *
+ * @param temperature Temperature in 0.01 °C.
+ * @return none
+ *
+ */
+void fan_control_set_temperature(int32_t temperature) {
+	uint8_t count = fan_control_fan_count;
+	fan_t *fan;
+
+	for (uint8_t i = 0; i < count; i++) {
+		fan = fan_control_fans[i];
+		if (fan->curve == 0) {
+			continue;
+		}
+		if (fan->curve_temperature == FAN_CONTROL_CURVE_NONE
+				|| temperature > fan->curve_temperature) {
+			fan->curve_temperature = temperature;
+		} else if (temperature < fan->curve_temperature - fan->curve->hysteresis) {
+			fan->curve_temperature = temperature + fan->curve->hysteresis;
+		}
+		fan_core_set_target(&fan->core, fan_control_curve_rpm(fan->curve, fan->curve_temperature));
+	}
+}
+
+/**
+ * @brief Returns the RPM of a fan, as estimated in the last sample.
+ *
+ * @param fan The fan.
+ * @return RPM, 0 while starting and when stalled.
+ *
+ */
+uint32_t fan_control_get_rpm(const fan_t *fan) {
+	return fan_core_get_rpm(&fan->core);
+}
+
+/**
+ * @brief Returns the time between two edges (one half rotation) of a fan.
+ *
+ * @param fan The fan.
+ * @return Median period in timer ticks, 0 while starting and when stalled.
+ *
+ */
+uint32_t fan_control_get_interval(const fan_t *fan) {
+	return fan_core_get_interval(&fan->core);
+}
+
+/**
+ * @brief Returns how far the RPM of a fan can be trusted.
+ *
+ * @param fan The fan.
+ * @return Quality of the last estimation.
+ *
+ */
+fan_core_rpm_quality_t fan_control_get_quality(const fan_t *fan) {
+	return fan_core_get_quality(&fan->core);
 }
 
 /**
@@ -168,12 +406,12 @@ void fan_control_show_status() {
 //	lcd_draw_text_at_line(target_rpm_string, 2, BLACK, 2, WHITE);
 //
 //	// Format the time interval between fan rotations as a string
-//	sprintf(interval_string, "Interval : %5lu", fan_control_time_interval);
+//	sprintf(interval_string, "Interval : %5lu", fan_control_get_interval(&fan_control_fan));
 //	// Display the time interval on the LCD at line 4
 //	lcd_draw_text_at_line(interval_string, 4, BLACK, 2, WHITE);
 //
 //	// Format the current fan RPM as a string
-//	sprintf(current_rpm_string, "RPM : %5lu", fan_control_actual_RPM);
+//	sprintf(current_rpm_string, "RPM : %5lu", fan_control_get_rpm(&fan_control_fan));
 //	// Display the current fan RPM on the LCD at line 6
 //	lcd_draw_text_at_line(current_rpm_string, 6, BLACK, 2, WHITE);
 }
@@ -181,7 +419,7 @@ void fan_control_show_status() {
 /**
  * @brief Sets the target RPM for fan control.
  *        This function reads the value from the potentiometer and scales it to a target RPM value.
- *        The calculated target RPM value is then assigned to the global variable `targetRPM`.
+ *        The calculated target RPM value is then the target of fan_control_fan, unless its curve sets the target.
  *
  * @param none
  * @return none
@@ -193,218 +431,273 @@ void fan_control_set_rpm() {
 	 * The potentiometer value is multiplied by 4500 and divided by 4095 to convert it to the desired range.
 	 */
 	fan_control_poti_val = (potis_dma_get_avg(POTIS_DMA_1) * 4500) / 4095;
-	targetRPM = fan_control_poti_val;
+	if (fan_control_fan.curve == 0) {
+		fan_control_set_target(&fan_control_fan, fan_control_poti_val);
+	}
 }
 
 
 
+/**
+ * @brief Sets the number of periods, whose median the RPM estimation of a fan uses.
+ *        The DMA ring holds twice as many timestamps as can be used, so the newest ones are
+ *        never overwritten while they are read.
+ *
+ * @param fan The fan.
+ * @param periods Number of periods (1 ... FAN_CORE_TACHO_RING / 2 - 1), clamped. Even numbers
+ *        take the upper median, odd ones are better.
+ * @return none
+ *
+ */
+void fan_control_set_tacho_window(fan_t *fan, uint8_t periods) {
+	fan_core_set_tacho_window(&fan->core, periods);
+}
+
+/**
+ * @brief Starts the auto-tuning of the PI controller of a fan around its current target RPM.
+ *        The relay experiment starts with the next sample of the control, the fan should run near
+ *        the target already. Afterwards the control continues with the new gains.
+ *
+ * @param fan The fan.
+ * @param rule Tuning rule (RELAY_TUNE_TYREUS_LUYBEN for little overshoot).
+ * @return none
+ *
+ */
+void fan_control_autotune(fan_t *fan, relay_tune_rule rule) {
+	fan_core_autotune(&fan->core, rule);
+}
+
+/**
+ * @brief Returns the state of the auto-tuning of a fan.
+ *
+ * @param fan The fan.
+ * @return RELAY_TUNE_RUNNING while the duty toggles, RELAY_TUNE_DONE if the new gains are used,
+ *         RELAY_TUNE_FAILED if the old gains stay.
+ *
+ */
+relay_tune_state fan_control_get_autotune_state(const fan_t *fan) {
+	return fan_core_get_autotune_state(&fan->core);
+}
+
+/**
+ * @brief Starts learning the feed-forward table of a fan. The sweep starts with the next sample of
+ *        the control, the target is ignored until it is done. A table, that has been learned before,
+ *        stays in use until the new one is complete.
+ *
+ * @param fan The fan.
+ * @return none
+ *
+ */
+void fan_control_learn_feedforward(fan_t *fan) {
+	fan_core_learn_feedforward(&fan->core);
+}
+
+/**
+ * @brief Checks if the feed-forward table of a fan has been learned and is used.
+ *
+ * @param fan The fan.
+ * @return 1 if the table is used, 0 before and while it is learned.
+ *
+ */
+uint8_t fan_control_feedforward_ready(const fan_t *fan) {
+	return fan_core_feedforward_ready(&fan->core);
+}
+
 /* Static module functions (for implementation) */
 
 /**
  * @brief Initializes Timer 3 for fan control using PWM. This function initializes Timer 3
- * 		  with the necessary settings to control a fan using PWM (Pulse Width Modulation). The fan
+ * 		  with the necessary settings to control the fans using PWM (Pulse Width Modulation). The fan
  *        speed is controlled by varying the duty cycle of the PWM signal. The frequency of the PWM
- *        signal is set to 200Hz, and the timer period is calculated accordingly. The PWM signal is output on Timer 3 Channel 2.
+ *        signal is FAN_CONTROL_PWM_HZ, the counter runs with the full timer clock, so the period has
+ *        the most compare steps possible. Only below clock / 65536 a prescaler is needed. The output compare
+ *        setting is prepared here, fan_control_pwm_init() configures the channel of every fan with it.
  *
  * @param none
  * @return none
  */
 static void fan_control_timer_3_init() {
-	// Desired PWM frequency in Hz
-	uint32_t f_pwm = 200;
-	// Desired timer frequency based on PWM frequency.
-	uint32_t f_timer = f_pwm * 27000;
-
-	/* Enable clock for Timer 3 */
-	__HAL_RCC_TIM3_CLK_ENABLE();
-	fan_control_tim_3_handle_struct.Instance = TIM3;
-	fan_control_tim_3_handle_struct.Init.Prescaler = (SystemCoreClock / 2
-			/ f_timer) - 1;
-	fan_control_tim_3_handle_struct.Init.Period = f_pwm - 1;
-	/* Counter mode is assigned to count up */
-	fan_control_tim_3_handle_struct.Init.CounterMode = TIM_COUNTERMODE_UP;
-	fan_control_tim_3_handle_struct.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
-	fan_control_tim_3_handle_struct.Init.AutoReloadPreload =
-	TIM_AUTORELOAD_PRELOAD_DISABLE;
-	/* Here you specify after how many overflows an event should be generated */
-	fan_control_tim_3_handle_struct.Init.RepetitionCounter = 0;
-	HAL_TIM_PWM_Init(&fan_control_tim_3_handle_struct);
-
-	fan_control_tim_oc_handle_struct.OCMode = TIM_OCMODE_PWM1;
-	/* Must be in period, compare-value*/
-	fan_control_tim_oc_handle_struct.Pulse = 0;
-	fan_control_tim_oc_handle_struct.OCIdleState = TIM_OCIDLESTATE_SET;
+	uint32_t clock = my_timer_get_clock(TIM3);
+	// Smallest prescaler, with which the period fits into the 16 bit counter (1 for 25 kHz)
+	uint32_t prescaler = (clock / FAN_CONTROL_PWM_HZ + 0xFFFF) / 0x10000;
+	// Timer frequency and the number of timer ticks per PWM period (resolution of the duty cycle)
+	uint32_t f_timer = clock / prescaler;
 
-	fan_control_tim_oc_handle_struct.OCPolarity = TIM_OCPOLARITY_HIGH;
-	fan_control_tim_oc_handle_struct.OCNIdleState = TIM_OCNIDLESTATE_RESET;
-	fan_control_tim_oc_handle_struct.OCNPolarity = TIM_OCNPOLARITY_HIGH;
-	/* Configuration of the output compare channel with timer3 and corresponding channel */
-	HAL_TIM_PWM_ConfigChannel(&fan_control_tim_3_handle_struct,
-			&fan_control_tim_oc_handle_struct,
-			TIM_CHANNEL_2);
+	fan_control_pwm_period = (f_timer + FAN_CONTROL_PWM_HZ / 2) / FAN_CONTROL_PWM_HZ;
+	my_timer_init(&fan_control_tim_3, TIM3, TIMER_MODE_PWM, f_timer, fan_control_pwm_period);
 
-	/* Start PWM on Timer 3, Channel 2 */
-	HAL_TIM_PWM_Start(&fan_control_tim_3_handle_struct, TIM_CHANNEL_2);
+	fan_control_tim_3.oc.OCMode = TIM_OCMODE_PWM1;
+	/* Must be in period, compare-value*/
+	fan_control_tim_3.oc.Pulse = 0;
+	fan_control_tim_3.oc.OCIdleState = TIM_OCIDLESTATE_SET;
+
+	fan_control_tim_3.oc.OCPolarity = TIM_OCPOLARITY_HIGH;
+	fan_control_tim_3.oc.OCNIdleState = TIM_OCNIDLESTATE_RESET;
+	fan_control_tim_3.oc.OCNPolarity = TIM_OCNPOLARITY_HIGH;
+	fan_control_tim_3.oc.OCFastMode = TIM_OCFAST_DISABLE;
 }
 
 /**
  * @brief Initializes Timer 2 for the time between two half rotations.
- *        This function initializes Timer 2 for fan control by calling the `my_timer_init()` function.
- *        Timer 2 is configured in base mode with a prescaler of 10000 and a period of 10000.
- *        The TIM_HandleTypeDef structure is then obtained using the `my_timer_get_struct()` function.
+ *        Timer 2 counts free-running with 1 MHz over its full 32 bit range, so the difference of two
+ *        timestamps is always correct. The channels are configured by fan_control_tacho_init() for every fan.
  *
  * @param none
  * @return none
  */
 static void fan_control_timer_2_init() {
-	my_timer_init(TIMER_INSTANCE_2, TIMER_MODE_BASE, 10000, 10000);
-	fan_control_tim_2_handle_struct = my_timer_get_struct();
+	my_timer_init(&fan_control_tim_2, TIM2, TIMER_MODE_IC, FAN_CONTROL_TACHO_HZ, 0);
+	/* The RPM estimation of every fan uses the frequency, that the timer actually counts with */
+	frequency = my_timer_get_tick_hz(&fan_control_tim_2);
+
+	/* Clock enabling for DMA */
+	__HAL_RCC_DMA1_CLK_ENABLE();
 }
 
 /**
- * @brief Initializes the GPIO pins for fan control.
- *        This function configures the necessary GPIO pins for fan control.
- *        The BLUE PWM input is connected to PB5 and is configured as an alternate function output open-drain.
- *        The Green-TACHO_OUTPUT is connected to PB1 and is initialized as an input with a pull-up resistor.
- *        Additionally, the interrupt priority and enable settings for TACHO_OUTPUT are also configured.
+ * @brief Initializes the tacho of a fan: its pin with a pull-up resistor, its capture channel of timer 2
+ *        for the rising edges and its DMA stream, that copies every capture into the timestamp ring of the fan.
+ *        The stream and the DMA request of the channel are started directly, HAL_TIM_IC_Start_DMA() only
+ *        accepts one channel per timer.
  *
- * @param none
+ * @param fan The fan.
  * @return none
  */
-static void fan_control_pins_init() {
-	// BLUE PWM input is connected to PB5.
-	__HAL_RCC_GPIOB_CLK_ENABLE();
-	GPIO_InitTypeDef gpio_init_b;
-
-	/* Configure BLUE PWM input pin (PB5), must be initialised as alternate function - open drain
-	 * and the Alternate Field must be set to GPIO_AF2_TIM3 in order to connect Timer 3 for reading pwm signal  */
-	gpio_init_b.Pin = GPIO_PIN_5;
-	gpio_init_b.Mode = GPIO_MODE_AF_OD;
-	gpio_init_b.Pull = GPIO_PULLDOWN;
-	gpio_init_b.Speed = GPIO_SPEED_MEDIUM;
-	gpio_init_b.Alternate = GPIO_AF2_TIM3;
-	HAL_GPIO_Init(GPIOB, &gpio_init_b);
-
-	// Green-TACHO_OUTPUT is connected to PB1 and must be initialized as INPUT and PULLUP
-	gpio_init_b.Pin = GPIO_PIN_1;
-	gpio_init_b.Mode = GPIO_MODE_IT_RISING;
-	gpio_init_b.Pull = GPIO_PULLUP;
-	HAL_GPIO_Init(GPIOB, &gpio_init_b);
-
-	/* Interrupt-Priority for TACHO_OUTPUT */
-	HAL_NVIC_SetPriority(EXTI1_IRQn, 1, 0);
-	/* Enabling the interrupts for TACHO_OUTPUT */
-	HAL_NVIC_EnableIRQ(EXTI1_IRQn);
+static void fan_control_tacho_init(fan_t *fan) {
+	const fan_control_tacho_hw_t *hw = &fan_control_tacho_hw[fan->tacho_channel - 1];
+	DMA_HandleTypeDef *dma = &fan_control_dma_handle_struct[fan->tacho_channel - 1];
+	uint32_t channel = fan_control_channels[fan->tacho_channel - 1];
+
+	// Green-TACHO_OUTPUT must be initialized as TIM2 input with PULLUP
+	utils_init_gpio(hw->port, hw->pin, GPIO_MODE_AF_PP, GPIO_PULLUP, GPIO_AF1_TIM2,
+			GPIO_SPEED_MEDIUM);
+
+	my_timer_ic_init(&fan_control_tim_2, channel, TIM_INPUTCHANNELPOLARITY_RISING,
+			FAN_CONTROL_TACHO_FILTER);
+
+	dma->Instance = hw->stream;
+	dma->Init.Channel = DMA_CHANNEL_3;
+	dma->Init.Direction = DMA_PERIPH_TO_MEMORY;
+	dma->Init.PeriphInc = DMA_PINC_DISABLE;
+	dma->Init.MemInc = DMA_MINC_ENABLE;
+	/* The capture registers of TIM2 have 32 bits */
+	dma->Init.PeriphDataAlignment = DMA_PDATAALIGN_WORD;
+	dma->Init.MemDataAlignment = DMA_MDATAALIGN_WORD;
+	/* The ring is overwritten endlessly, the newest timestamps are found with the DMA counter */
+	dma->Init.Mode = DMA_CIRCULAR;
+	dma->Init.Priority = DMA_PRIORITY_HIGH;
+	dma->Init.FIFOMode = DMA_FIFOMODE_DISABLE;
+	HAL_DMA_Init(dma);
+	__HAL_LINKDMA(&fan_control_tim_2.handle, hdma[hw->dma_id], *dma);
+
+	/* CCR1 ... CCR4 follow each other. No interrupts, the sample reads the DMA counter */
+	HAL_DMA_Start(dma, (uint32_t) (&fan_control_tim_2.handle.Instance->CCR1 + (fan->tacho_channel - 1)),
+			(uint32_t) fan->core.tacho_ring, FAN_CORE_TACHO_RING);
+	__HAL_TIM_ENABLE_DMA(&fan_control_tim_2.handle, hw->dma_request);
+	HAL_TIM_IC_Start(&fan_control_tim_2.handle, channel);
 }
 
 /**
- * @brief Interrupt Request Handler
- *
- * This function serves as an interrupt handler for EXTI1, which is triggered when a rising edge is detected on the
- * corresponding GPIO pin (GPIO_PIN_1). It retrieves the EXTI handle, checks if the interrupt is pending, and
- * then calls the appropriate handler for further processing.
+ * @brief Initializes the PWM channel of a fan and its pin. The BLUE PWM input must be initialised as
+ *        alternate function - open drain and the Alternate Field must be set to GPIO_AF2_TIM3 in order
+ *        to connect Timer 3. The duty starts at FAN_CORE_MIN_DUTY.
  *
- * @param none
+ * @param fan The fan.
  * @return none
- *
  */
-void EXTI1_IRQHandler(void) {
-	EXTI_HandleTypeDef hexti;
-	HAL_EXTI_GetHandle(&hexti, EXTI_LINE_1);
+static void fan_control_pwm_init(const fan_t *fan) {
+	const fan_control_pwm_hw_t *hw = &fan_control_pwm_hw[fan->pwm_channel - 1];
+	uint32_t channel = fan_control_channels[fan->pwm_channel - 1];
 
-	if (HAL_EXTI_GetPending(&hexti, EXTI_TRIGGER_RISING)) {
-		HAL_GPIO_EXTI_IRQHandler(GPIO_PIN_1);
-	}
+	utils_init_gpio(hw->port, hw->pin, GPIO_MODE_AF_OD, GPIO_PULLDOWN, GPIO_AF2_TIM3,
+			GPIO_SPEED_MEDIUM);
+
+	/* Configuration of the output compare channel with timer3 and corresponding channel */
+	HAL_TIM_PWM_ConfigChannel(&fan_control_tim_3.handle, &fan_control_tim_3.oc, channel);
+	my_timer_set_compare(&fan_control_tim_3, channel, fan_control_duty_compare(FAN_CORE_MIN_DUTY));
+
+	/* Start PWM on Timer 3 */
+	my_timer_start(&fan_control_tim_3, MODE_PWM, channel);
 }
 
 /**
- * @brief GPIO EXTI callback function.
+ * @brief Periodic control (soft_timer callback in the tick interrupt): runs the sample of every fan
+ *        with the newest timestamp of its DMA and writes the duty, that its controller returns.
  *
- * This function is called when an interrupt event occurs on a GPIO pin.
- * It performs specific actions based on the GPIO pin that triggered the interrupt.
- *
- * @param GPIO_Pin The GPIO pin number that triggered the interrupt.
+ * @param arg unused
  * @return none
  *
  */
-void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin) {
-	switch (GPIO_Pin) {
-	case GPIO_PIN_1:
-		/* At the beginning, the start_flag is false, so the program enters the first block.
-		 * During the second half of the full rotation, the program enters the second block.
-		 * The timer is stopped, and its value is assigned to the time_interval variable.
-		 * time_interval is the time between two half rotations.
-		 * The timer is then reset to zero.
-		 */
-		if (!fan_start_flag) {
-			HAL_TIM_Base_Start(&fan_control_tim_2_handle_struct);
-			fan_start_flag = 1;
-		} else {
-			HAL_TIM_Base_Stop(&fan_control_tim_2_handle_struct);
-			fan_control_time_interval = __HAL_TIM_GET_COUNTER(
-					&fan_control_tim_2_handle_struct);
-			regulateFanSpeed();
-			__HAL_TIM_SET_COUNTER(&fan_control_tim_2_handle_struct, 0);
-			fan_start_flag = 0;
-		}
-		break;
-	default:
-		break;
+static void fan_control_tick(void *arg) {
+	uint8_t count = fan_control_fan_count;
+	fan_t *fan;
+
+	for (uint8_t i = 0; i < count; i++) {
+		fan = fan_control_fans[i];
+		// The duty (Q15) sets the PWM compare value of the TIM3 channel of the fan
+		fan_control_set_duty(fan, fan_core_sample(&fan->core, fan_control_tacho_written(fan)));
 	}
 }
 
 /**
- * @brief GPIO EXTI callback function
+ * @brief Returns the index of the next timestamp, that will be written into the ring of a fan.
  *
- * Regulates the speed of a fan based on target RPM and measured RPM.
- * This function calculates the required fan speed adjustment to achieve the target RPM
- * based on the measured RPM. It uses a proportional-integral (PI) controller algorithm
- * to compute the output PWM value that controls the fan speed.
- * The time_interval variable represents the time difference between each half revolution.
- * To obtain the time for a complete revolution, it needs to be multiplied by 2.
+ * @param fan The fan.
+ * @return Index 0 ... FAN_CORE_TACHO_RING - 1.
+ */
+static uint32_t fan_control_tacho_written(const fan_t *fan) {
+	/* The DMA counts down from FAN_CORE_TACHO_RING to 1 and starts again */
+	return FAN_CORE_TACHO_RING
+			- __HAL_DMA_GET_COUNTER(&fan_control_dma_handle_struct[fan->tacho_channel - 1]);
+}
+
+/**
+ * @brief Sets the duty cycle of a fan (compare value of its TIM3 channel).
  *
- * @param none
+ * @param fan The fan.
+ * @param duty Q15 command FAN_CORE_MIN_DUTY ... FAN_CORE_MAX_DUTY.
  * @return none
  */
-static void regulateFanSpeed() {
-	/**
-	 * actualRPM explains that the time_interval variable represents the time difference between each half revolution of the fan.
-	 * To calculate the time for a complete revolution, it needs to be multiplied by 2.
-	 * The actualRPM is then calculated by dividing the frequency by the adjusted time_interval and
-	 * multiplying it by 60 to convert it to RPM.
-	 */
-	fan_control_actual_RPM = (frequency / (fan_control_time_interval * 2)) * 60;
+static void fan_control_set_duty(fan_t *fan, uint32_t duty) {
+	my_timer_set_compare(&fan_control_tim_3, fan_control_channels[fan->pwm_channel - 1],
+			fan_control_duty_compare(duty));
+}
 
-	/**
-	 * The error is calculated by subtracting the actualRPM from the targetRPM,
-	 * representing the deviation between the desired and actual fan speeds. The errorSum is updated
-	 * by adding the error value to accumulate the cumulative error over time. The output is calculated using
-	 * a proportional-integral (PI) controller algorithm, where the proportional term (Kp * error)
-	 * and integral term with sampling period (Ki * errorSum * Ta) are combined.
-	 */
-	int32_t error = targetRPM - fan_control_actual_RPM;
-	/* Ta is the sampling period */
-	float Ta = fan_control_time_interval / frequency;
-	errorSum = errorSum + error;
-	output = Kp * error + Ki * errorSum * Ta;
+/**
+ * @brief Scales a Q15 duty command to the compare steps of the PWM period, rounded.
+ *
+ * @param duty Q15 command 0 ... 32767.
+ * @return Compare value 0 ... fan_control_pwm_period.
+ */
+static uint32_t fan_control_duty_compare(uint32_t duty) {
+	return (duty * fan_control_pwm_period + (1 << 14)) >> 15;
+}
 
-	/**
-	 * This section checks if the output exceeds the maximum allowable PWM value (MAX_PWM) or
-	 * falls below the minimum allowable PWM value (MIN_PWM). If either condition is true, the output
-	 * is limited to the corresponding limit, and the errorSum is adjusted by subtracting the error value
-	 * to prevent excessive accumulation of error.
-	 */
-	if (output > MAX_PWM) {
-		output = MAX_PWM;
-		errorSum = errorSum - error;
-	} else if (output < MIN_PWM) {
-		output = MIN_PWM;
-		errorSum = errorSum - error;
-	}
+/**
+ * @brief Interpolates the target RPM for a temperature on a curve.
+ *
+ * @param curve The curve.
+ * @param temperature Temperature in 0.01 °C.
+ * @return RPM, the one of the first or last point outside of the curve.
+ */
+static uint32_t fan_control_curve_rpm(const fan_control_curve_t *curve, int32_t temperature) {
+	const fan_control_curve_point_t *low;
+	const fan_control_curve_point_t *high;
 
-	// This line sets the pulse width modulation (PWM) compare value for channel 2 of tim_3_handle_struct.
-	// It controls the fan speed by adjusting the duty cycle of the PWM signal. The value of output determines the PWM compare value.
-	__HAL_TIM_SET_COMPARE(&fan_control_tim_3_handle_struct, TIM_CHANNEL_2,
-			output);
+	if (temperature <= curve->points[0].temperature) {
+		return curve->points[0].rpm;
+	}
+	for (uint8_t i = 1; i < curve->count; i++) {
+		low = &curve->points[i - 1];
+		high = &curve->points[i];
+		if (temperature <= high->temperature) {
+			/* The RPM may also fall along the curve, so signed */
+			return (uint32_t) ((int64_t) low->rpm
+					+ ((int64_t) (temperature - low->temperature)
+							* ((int64_t) high->rpm - low->rpm)
+							+ (high->temperature - low->temperature) / 2)
+							/ (high->temperature - low->temperature));
+		}
+	}
+	return curve->points[curve->count - 1].rpm;
 }
-
@@ -11,14 +11,73 @@
 #ifndef FAN_CONTROL_FAN_CONTROL_H_
 #define FAN_CONTROL_FAN_CONTROL_H_
 
+/* Includes */
+#include <stdint.h>
+#include <fan_core/fan_core.h>
+#include <relay_tune/relay_tune.h>
+
+/* Public preprocessor macros */
+/* Frequency of the fan PWM (TIM3), 25 kHz is the standard of 4-wire fans. The timer counts with its
+ * full clock, so a period has as many compare steps as the clock allows (640 at 16 MHz) */
+#define FAN_CONTROL_PWM_HZ 25000
+/* Largest number of fans: each one needs a capture channel of TIM2 and a PWM channel of TIM3 */
+#define FAN_CONTROL_MAX_FANS 4
+
+/* Most points of a fan curve */
+#define FAN_CONTROL_CURVE_MAX_POINTS 8
+
+/* Public types */
+/* One point of a fan curve */
+typedef struct {
+	int32_t temperature;						// 0.01 °C
+	uint32_t rpm;
+} fan_control_curve_point_t;
+
+/* Fan curve: target RPM over the temperature, linear between the points (ascending temperatures) and
+ * constant outside of them. A fan only slows down again, when the temperature has fallen by hysteresis. */
+typedef struct {
+	fan_control_curve_point_t points[FAN_CONTROL_CURVE_MAX_POINTS];
+	uint8_t count;
+	int32_t hysteresis;							// 0.01 °C
+} fan_control_curve_t;
+
+/* One fan with its channels, curve and its RPM estimation and controller (fan_core). The fields belong to
+ * fan_control, use the functions below to set the target and to read the RPM. */
+typedef struct {
+	/* Channels (1 ... 4): capture channel of TIM2 for the tacho, PWM channel of TIM3 */
+	uint8_t tacho_channel;
+	uint8_t pwm_channel;
+
+	/* Thermal mode: curve, that sets the target (0 for the manual target), and the temperature on the
+	 * curve after the hysteresis */
+	const fan_control_curve_t *curve;
+	int32_t curve_temperature;
+
+	/* Estimation and control, the DMA writes the tacho timestamps into core.tacho_ring */
+	fan_core_t core;
+} fan_t;
+
 /* Public functions (prototypes )*/
 void fan_control_init();
+int8_t fan_control_add(fan_t *fan, uint8_t tacho_channel, uint8_t pwm_channel);
+void fan_control_set_target(fan_t *fan, uint32_t rpm);
+uint32_t fan_control_get_target(const fan_t *fan);
+int8_t fan_control_set_curve(fan_t *fan, const fan_control_curve_t *curve);
+void fan_control_set_temperature(int32_t temperature);
+uint32_t fan_control_get_rpm(const fan_t *fan);
+uint32_t fan_control_get_interval(const fan_t *fan);
+fan_core_rpm_quality_t fan_control_get_quality(const fan_t *fan);
 void fan_control_set_rpm();
 void fan_control_show_status();
+void fan_control_set_tacho_window(fan_t *fan, uint8_t periods);
+void fan_control_autotune(fan_t *fan, relay_tune_rule rule);
+relay_tune_state fan_control_get_autotune_state(const fan_t *fan);
+void fan_control_learn_feedforward(fan_t *fan);
+uint8_t fan_control_feedforward_ready(const fan_t *fan);
 
 /* Public variables (for printing in main.c)*/
-extern volatile uint32_t fan_control_time_interval;
-extern volatile uint32_t fan_control_actual_RPM;
+/* The fan of the board (tacho PA5 on TIM2_CH1, PWM PB5 on TIM3_CH2), set by the potentiometer */
+extern fan_t fan_control_fan;
 extern volatile uint32_t fan_control_poti_val;
 
 #endif /* FAN_CONTROL_FAN_CONTROL_H_ */
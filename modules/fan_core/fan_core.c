@@ -0,0 +1,551 @@
+/**
+ **************************************************
+ * @file fan_core.c
+ * @author Berkay Özgür, C. Arda Sengenc
+ * @version v1.0
+ * @date 17.10.2026
+ * @brief: Hardware independent part of the fan control: RPM estimation from the tacho timestamps,
+ * PI control, feed-forward table and auto-tuning of one fan. It only sees the timestamp ring and
+ * returns the duty, so it runs unchanged on the target (fan_control.c) and on a PC against the
+ * simulated fan (fan_sim.c, see tests/fan_sim_test.c).
+ @verbatim
+ ==================================================
+ ### Resources used ###
+
+ None, the caller provides the fan_core_t, fills its tacho_ring with the timestamps of the rising
+ tacho edges and calls "fan_core_sample()" every FAN_CORE_SAMPLE_MS.
+
+ RPM estimation: the median of the newest tacho_window periods, so a single bouncing or missed edge
+ does not reach the controller. The RPM follows from the period with a reciprocal from a small table and two
+ Newton steps instead of a division. Without an edge for FAN_CORE_STALL_MS the fan counts as stalled and the
+ RPM drops to 0, so the controller reacts. "fan_core_get_quality()" tells how far the RPM can be trusted.
+
+ Control: PI controller (pi_ctrl, Q16 fixed point) with the Q15 duty as output, limited to
+ FAN_CORE_MIN_DUTY ... FAN_CORE_MAX_DUTY without winding up its integral.
+
+ ==================================================
+ ### Usage ###
+
+ (#) Call "fan_core_init()" with the counter frequency of the timestamps.
+
+ (#) Call "fan_core_sample()" every FAN_CORE_SAMPLE_MS with the ring index of the next timestamp
+ 	 (from the DMA counter), it returns the duty for the PWM.
+
+ (#) Set the target with "fan_core_set_target()" and read the speed with "fan_core_get_rpm()".
+
+ (#) Optional: "fan_core_learn_feedforward()" sweeps the duty from FAN_CORE_MIN_DUTY to FAN_CORE_MAX_DUTY
+ 	 in FAN_CORE_FF_POINTS steps of FAN_CORE_FF_SETTLE_MS and stores the steady RPM of every step in a
+ 	 monotone table. Afterwards every new target moves the duty at once by the difference of the
+ 	 interpolated duties, the PI controller only trims the residual error.
+
+ (#) Optional: "fan_core_autotune()" replaces the gains by measured ones (relay_tune.c): for at most
+ 	 FAN_CORE_TUNE_MAX_MS the duty toggles between the limits around the current target.
+
+ (#) Optional: "fan_core_set_tacho_window()" chooses of how many periods the median is taken.
+
+ @endverbatim
+ **************************************************
+ */
+
+/* Includes */
+#include "fan_core.h"
+#include <median/median.h>
+
+/**
+ * The Proportional-Integral (PI) controller is commonly used in control systems to regulate a process variable based on an error signal.
+ * In the context of fan speed control, a PI controller is used to adjust the fan speed and maintain it at a desired setpoint.
+ *
+ * Proportional Control: The proportional term (Kp * error) in the controller output allows for an immediate response to the error signal.
+ * It provides a control action that is proportional to the difference between the desired fan speed (target RPM) and the actual
+ * fan speed (measured RPM). The proportional control helps to reduce the steady-state error and improve the system's responsiveness.
+ *
+ * Integral Control: The integral term (Ki * sum of error * Ta) in the controller output takes into account the accumulated error over time.
+ * It helps to eliminate the steady-state error by continuously integrating the error signal. The integral control component is
+ * particularly useful when there are factors such as friction or external disturbances that can cause a deviation from the desired fan speed.
+ *
+ * By combining both proportional and integral control, the PI controller provides a balance between
+ * immediate response (proportional control) and long-term error correction (integral control).
+ * It helps to stabilize the fan speed control system, minimize the deviation from the target RPM,
+ * and improve the overall performance and accuracy of the fan speed regulation.
+ */
+
+/* Preprocessor macros */
+/* Default gains of the PI Controller (Q15 duty per RPM, and per RPM and second): Tyreus-Luyben of the
+ * relay experiment at 2000 RPM with the simulated fan (Ku 125, Tu 275 ms, see tests/fan_sim_test.c).
+ * The former 0.98 and 2.1 (PWM with 200 steps) were four to five times as high and oscillated below 1500 RPM,
+ * where the median of the tacho periods lags the most */
+#define FAN_CORE_KP PI_CTRL_Q16(39.5)
+#define FAN_CORE_KI PI_CTRL_Q16(64.0)
+/* Switching band of the relay of the auto-tuning (above the noise of the RPM) */
+#define FAN_CORE_TUNE_HYSTERESIS 30
+/* No target has been fed forward yet, the next one sets the duty absolutely */
+#define FAN_CORE_FF_NONE 0xFFFFFFFF
+/* A period, that differs from the median by more than 1 / FAN_CORE_TACHO_OUTLIER, is an outlier */
+#define FAN_CORE_TACHO_OUTLIER 4
+
+/* Module functions (prototypes) */
+static void fan_core_estimate_rpm(fan_core_t *core, uint32_t written);
+static int32_t fan_core_regulate(fan_core_t *core);
+static uint8_t fan_core_ff_sweep(fan_core_t *core, int32_t *duty);
+static int32_t fan_core_ff_duty(const fan_core_t *core, uint32_t rpm);
+static uint32_t fan_core_ff_point_duty(uint8_t point);
+
+/* Reciprocal 2^32 / (1 + (i + 0.5) / 64) as start value for the Newton steps in fan_core_rpm_from_period() */
+static const uint32_t fan_core_reciprocal_table[64] = {
+	0xFE03F810, 0xFA232CF2, 0xF6603D98, 0xF2B9D648,
+	0xEF2EB720, 0xEBBDB2A6, 0xE865AC7B, 0xE525982B,
+	0xE1FC780E, 0xDEE95C4D, 0xDBEB61EF, 0xD901B203,
+	0xD62B80D6, 0xD3680D37, 0xD0B69FCC, 0xCE168A77,
+	0xCB8727C0, 0xC907DA4F, 0xC6980C6A, 0xC4372F85,
+	0xC1E4BBD6, 0xBFA02FE8, 0xBD691047, 0xBB3EE722,
+	0xB92143FA, 0xB70FBB5A, 0xB509E68B, 0xB30F6353,
+	0xB11FD3B8, 0xAF3ADDC7, 0xAD602B58, 0xAB8F69E3,
+	0xA9C84A48, 0xA80A80A8, 0xA655C439, 0xA4A9CF1E,
+	0xA3065E40, 0xA16B312F, 0x9FD809FE, 0x9E4CAD24,
+	0x9CC8E161, 0x9B4C6F9F, 0x99D722DB, 0x9868C80A,
+	0x97012E02, 0x95A02568, 0x94458094, 0x92F11384,
+	0x91A2B3C5, 0x905A3863, 0x8F1779DA, 0x8DDA5202,
+	0x8CA29C04, 0x8B70344A, 0x8A42F870, 0x891AC73B,
+	0x87F78088, 0x86D90544, 0x85BF3761, 0x84A9F9C8,
+	0x83993052, 0x828CBFBF, 0x81848DA9, 0x80808081,
+};
+
+/**
+ * @brief Initializes the estimation and the control of a fan with the default gains, the target 0
+ *        and no feed-forward table. The duty starts at FAN_CORE_MIN_DUTY.
+ *
+ * @param core The fan.
+ * @param tick_hz Counter frequency of the timestamps in the ring (see fan_core_rpm_from_period()).
+ * @return none
+ */
+void fan_core_init(fan_core_t *core, uint32_t tick_hz) {
+	core->tick_hz = tick_hz;
+	core->target_rpm = 0;
+	core->tacho_window = FAN_CORE_TACHO_WINDOW;
+	core->kp = FAN_CORE_KP;
+	core->ki = FAN_CORE_KI;
+	core->tune.state = RELAY_TUNE_IDLE;
+	core->tune_requested = 0;
+	core->ff_ready = 0;
+	core->ff_requested = 0;
+	core->ff_point = FAN_CORE_FF_POINTS;
+	fan_core_restart(core);
+}
+
+/**
+ * @brief Lets the estimation and the controller start again from rest, e.g. after the fan has been
+ *        switched off. The gains, the feed-forward table and the target stay.
+ *
+ * @param core The fan.
+ * @return none
+ */
+void fan_core_restart(fan_core_t *core) {
+	core->time_interval = 0;
+	core->actual_rpm = 0;
+	core->quality = FAN_CORE_RPM_STARTING;
+	core->tacho_last_written = 0;
+	core->tacho_fresh = 0;
+	core->tacho_quiet_ms = 0;
+	pi_ctrl_init(&core->pi, core->kp, core->ki, FAN_CORE_SAMPLE_MS * 1000,
+			FAN_CORE_MIN_DUTY, FAN_CORE_MAX_DUTY);
+	core->ff_target = FAN_CORE_FF_NONE;
+}
+
+/**
+ * @brief Sample of one fan: estimates the period, starts a requested sweep or auto-tuning and
+ *        regulates the fan speed.
+ *
+ * @param core The fan.
+ * @param written Ring index of the next timestamp, that will be written.
+ * @return Duty for the PWM, Q15 FAN_CORE_MIN_DUTY ... FAN_CORE_MAX_DUTY.
+ */
+int32_t fan_core_sample(fan_core_t *core, uint32_t written) {
+	fan_core_estimate_rpm(core, written);
+	if (core->ff_requested) {
+		core->ff_requested = 0;
+		core->ff_point = 0;
+		core->ff_samples = 0;
+		core->ff_sum = 0;
+	}
+	if (core->tune_requested && core->ff_point == FAN_CORE_FF_POINTS) {
+		relay_tune_start(&core->tune, core->target_rpm, FAN_CORE_TUNE_HYSTERESIS,
+				FAN_CORE_MIN_DUTY, FAN_CORE_MAX_DUTY, FAN_CORE_SAMPLE_MS * 1000,
+				FAN_CORE_TUNE_MAX_MS, core->tune_rule);
+		core->tune_requested = 0;
+	}
+	return fan_core_regulate(core);
+}
+
+/**
+ * @brief Sets the target RPM of a fan.
+ *
+ * @param core The fan.
+ * @param rpm Target RPM.
+ * @return none
+ */
+void fan_core_set_target(fan_core_t *core, uint32_t rpm) {
+	core->target_rpm = rpm;
+}
+
+/**
+ * @brief Returns the target RPM of a fan.
+ *
+ * @param core The fan.
+ * @return Target RPM.
+ */
+uint32_t fan_core_get_target(const fan_core_t *core) {
+	return core->target_rpm;
+}
+
+/**
+ * @brief Returns the RPM of a fan, as estimated in the last sample.
+ *
+ * @param core The fan.
+ * @return RPM, 0 while starting and when stalled.
+ */
+uint32_t fan_core_get_rpm(const fan_core_t *core) {
+	return core->actual_rpm;
+}
+
+/**
+ * @brief Returns the time between two edges (one half rotation) of a fan.
+ *
+ * @param core The fan.
+ * @return Median period in timer ticks, 0 while starting and when stalled.
+ */
+uint32_t fan_core_get_interval(const fan_core_t *core) {
+	return core->time_interval;
+}
+
+/**
+ * @brief Returns how far the RPM of a fan can be trusted.
+ *
+ * @param core The fan.
+ * @return Quality of the last estimation.
+ */
+fan_core_rpm_quality_t fan_core_get_quality(const fan_core_t *core) {
+	return core->quality;
+}
+
+/**
+ * @brief Sets the number of periods, whose median the RPM estimation of a fan uses.
+ *        The ring holds twice as many timestamps as can be used, so the newest ones are
+ *        never overwritten while they are read.
+ *
+ * @param core The fan.
+ * @param periods Number of periods (1 ... FAN_CORE_TACHO_RING / 2 - 1), clamped. Even numbers
+ *        take the upper median, odd ones are better.
+ * @return none
+ */
+void fan_core_set_tacho_window(fan_core_t *core, uint8_t periods) {
+	if (periods < 1) {
+		periods = 1;
+	} else if (periods > FAN_CORE_TACHO_RING / 2 - 1) {
+		periods = FAN_CORE_TACHO_RING / 2 - 1;
+	}
+	core->tacho_window = periods;
+}
+
+/**
+ * @brief Starts the auto-tuning of the PI controller of a fan around its current target RPM.
+ *        The relay experiment starts with the next sample, the fan should run near
+ *        the target already. Afterwards the control continues with the new gains.
+ *
+ * @param core The fan.
+ * @param rule Tuning rule (RELAY_TUNE_TYREUS_LUYBEN for little overshoot).
+ * @return none
+ */
+void fan_core_autotune(fan_core_t *core, relay_tune_rule rule) {
+	core->tune_rule = rule;
+	core->tune_requested = 1;
+}
+
+/**
+ * @brief Returns the state of the auto-tuning of a fan.
+ *
+ * @param core The fan.
+ * @return RELAY_TUNE_RUNNING while the duty toggles, RELAY_TUNE_DONE if the new gains are used,
+ *         RELAY_TUNE_FAILED if the old gains stay.
+ */
+relay_tune_state fan_core_get_autotune_state(const fan_core_t *core) {
+	if (core->tune_requested) {
+		return RELAY_TUNE_RUNNING;
+	}
+	return relay_tune_get_state(&core->tune);
+}
+
+/**
+ * @brief Starts learning the feed-forward table of a fan. The sweep starts with the next sample,
+ *        the target is ignored until it is done. A table, that has been learned before,
+ *        stays in use until the new one is complete.
+ *
+ * @param core The fan.
+ * @return none
+ */
+void fan_core_learn_feedforward(fan_core_t *core) {
+	core->ff_requested = 1;
+}
+
+/**
+ * @brief Checks if the feed-forward table of a fan has been learned and is used.
+ *
+ * @param core The fan.
+ * @return 1 if the table is used, 0 before and while it is learned.
+ */
+uint8_t fan_core_feedforward_ready(const fan_core_t *core) {
+	return core->ff_ready && !core->ff_requested && core->ff_point == FAN_CORE_FF_POINTS;
+}
+
+/**
+ * @brief Calculates the RPM from the time between two edges (one half rotation) without a division:
+ *        RPM = tick_hz * 60 / (2 * period). The period is normalized to 1 <= m < 2, the start value
+ *        of 1 / m comes from a table with 64 entries (6 bit), two Newton steps r = r * (2 - m * r)
+ *        make it exact to about 24 bit. The result differs from the rounded division by at most
+ *        1 RPM for every period up to tick_hz 10 MHz (tests/fan_core_test.c sweeps 1 and 10 MHz).
+ *        At higher tick rates the error grows at the shortest periods (2 RPM at 16 MHz, 11 RPM at
+ *        100 MHz). Above about 107 MHz the product overflows for periods from 2^31 on.
+ *
+ * @param tick_hz Counter frequency of the timestamps, at most 100 MHz.
+ * @param period Period in timer ticks.
+ * @return RPM, 0 for the period 0.
+ */
+uint32_t fan_core_rpm_from_period(uint32_t tick_hz, uint32_t period) {
+	uint64_t factor = (uint64_t) tick_hz * 60 / 2;
+	uint32_t shift;
+	uint32_t mantissa;
+	uint64_t reciprocal;
+	uint64_t product;
+
+	if (period == 0) {
+		return 0;
+	}
+
+	/* period = mantissa * 2^(shift - 31), mantissa in Q31 between 1 and 2 (CLZ instruction on the target) */
+	shift = (uint32_t) __builtin_clz(period);
+	mantissa = period << shift;
+
+	/* 1 / mantissa in Q32, the table index are the 6 bits after the leading one */
+	reciprocal = fan_core_reciprocal_table[(mantissa >> 25) & 0x3F];
+	for (uint8_t i = 0; i < 2; i++) {
+		product = ((uint64_t) mantissa * reciprocal) >> 32;
+		reciprocal = (reciprocal * (((uint64_t) 1 << 32) - product)) >> 31;
+		/* 1 / 1 would need 33 bits */
+		if (reciprocal > 0xFFFFFFFF) {
+			reciprocal = 0xFFFFFFFF;
+		}
+	}
+
+	/* factor / period = factor * reciprocal * 2^(shift - 63), rounded */
+	return (uint32_t) ((factor * reciprocal + ((uint64_t) 1 << (62 - shift))) >> (63 - shift));
+}
+
+/* Static module functions (for implementation) */
+
+/**
+ * @brief Estimates the RPM of a fan from its timestamp ring and detects a stall.
+ *        The periods between the newest tacho_window + 1 timestamps are compared and their median
+ *        is used, so a single wrong edge is rejected. Only edges since the start or the last stall
+ *        count, the long gap of a stall is never a period. Timer ticks only wrap in 32 bit, so the
+ *        unsigned differences are correct.
+ *
+ * @param core The fan.
+ * @param written Ring index of the next timestamp, that will be written.
+ * @return none
+ */
+static void fan_core_estimate_rpm(fan_core_t *core, uint32_t written) {
+	/* Zeroed, the compiler cannot see that the loop below always fills the window */
+	uint32_t periods[FAN_CORE_TACHO_RING / 2] = { 0 };
+	uint32_t window = core->tacho_window;
+	uint32_t edges;
+	uint32_t newest;
+	uint32_t median;
+	uint32_t deviation;
+	fan_core_rpm_quality_t quality = FAN_CORE_RPM_VALID;
+
+	/* New edges since the last sample, the ring never wraps completely within one sample */
+	edges = (written + FAN_CORE_TACHO_RING - core->tacho_last_written) % FAN_CORE_TACHO_RING;
+	core->tacho_last_written = written;
+
+	if (edges == 0) {
+		if (core->tacho_quiet_ms < FAN_CORE_STALL_MS) {
+			core->tacho_quiet_ms += FAN_CORE_SAMPLE_MS;
+		}
+		if (core->tacho_quiet_ms >= FAN_CORE_STALL_MS) {
+			core->tacho_fresh = 0;
+			core->time_interval = 0;
+			core->actual_rpm = 0;
+			core->quality = FAN_CORE_RPM_STALLED;
+			return;
+		}
+	} else {
+		core->tacho_quiet_ms = 0;
+		core->tacho_fresh += edges;
+		if (core->tacho_fresh > FAN_CORE_TACHO_RING) {
+			core->tacho_fresh = FAN_CORE_TACHO_RING;
+		}
+	}
+
+	if (core->tacho_fresh <= window) {
+		core->time_interval = 0;
+		core->actual_rpm = 0;
+		core->quality = FAN_CORE_RPM_STARTING;
+		return;
+	}
+
+	newest = (written + FAN_CORE_TACHO_RING - 1) % FAN_CORE_TACHO_RING;
+	for (uint32_t i = 0; i < window; i++) {
+		periods[i] = core->tacho_ring[(newest + FAN_CORE_TACHO_RING - i) % FAN_CORE_TACHO_RING]
+				- core->tacho_ring[(newest + FAN_CORE_TACHO_RING - i - 1) % FAN_CORE_TACHO_RING];
+	}
+	/* The window is limited to 1 ... FAN_CORE_TACHO_RING / 2 - 1 by fan_core_set_tacho_window() */
+	(void)median_kernel(periods, window, &median);
+
+	for (uint32_t i = 0; i < window; i++) {
+		deviation = (periods[i] > median) ? periods[i] - median : median - periods[i];
+		if (deviation > median / FAN_CORE_TACHO_OUTLIER) {
+			quality = FAN_CORE_RPM_NOISY;
+		}
+	}
+
+	core->time_interval = median;
+	core->actual_rpm = fan_core_rpm_from_period(core->tick_hz, median);
+	core->quality = quality;
+}
+
+/**
+ * @brief Fan speed regulation. The error between the target and the actual RPM is handled by the
+ *        PI controller with the fixed sample time FAN_CORE_SAMPLE_MS, a stalled fan has the RPM 0,
+ *        so the controller drives it up again. A new target does not kick the output, the
+ *        proportional term only acts on the measurement.
+ *
+ * @param core The fan.
+ * @return Duty for the PWM.
+ */
+static int32_t fan_core_regulate(fan_core_t *core) {
+	uint32_t target = core->target_rpm;
+	int32_t output;
+
+	/* During the sweep of the feed-forward table the duty steps through the table */
+	if (fan_core_ff_sweep(core, &output)) {
+		return output;
+	}
+
+	/**
+	 * Feed-forward: a new target moves the integral of the controller at once by the difference of the
+	 * duties, that the table gives for the old and the new target. Its correction of the table stays,
+	 * so the controller only has to trim the residual error.
+	 */
+	if (core->ff_ready && target != core->ff_target) {
+		if (core->ff_target == FAN_CORE_FF_NONE) {
+			pi_ctrl_preset(&core->pi, target, fan_core_ff_duty(core, target));
+		} else {
+			pi_ctrl_feed_forward(&core->pi, target,
+					fan_core_ff_duty(core, target) - fan_core_ff_duty(core, core->ff_target));
+		}
+		core->ff_target = target;
+	}
+
+	/**
+	 * While the auto-tuning runs, the relay sets the duty instead of the controller. When it is done,
+	 * the controller continues bumpless with the new gains from the duty it had before.
+	 */
+	if (relay_tune_get_state(&core->tune) == RELAY_TUNE_RUNNING) {
+		output = relay_tune_update(&core->tune, core->actual_rpm);
+		if (relay_tune_get_state(&core->tune) == RELAY_TUNE_RUNNING) {
+			return output;
+		}
+		if (relay_tune_get_state(&core->tune) == RELAY_TUNE_DONE) {
+			core->kp = core->tune.kp;
+			core->ki = core->tune.ki;
+			pi_ctrl_set_gains(&core->pi, core->kp, core->ki);
+		}
+	}
+
+	return pi_ctrl_update(&core->pi, target, core->actual_rpm);
+}
+
+/**
+ * @brief One sample of the sweep for the feed-forward table of a fan: every point holds its duty for
+ *        FAN_CORE_FF_SETTLE_MS, the RPM of the last FAN_CORE_FF_AVERAGE_MS is averaged.
+ *        Afterwards the table is made monotone and the controller continues from the sweep.
+ *
+ * @param core The fan.
+ * @param duty Result: duty of the sweep, only set while the sweep runs.
+ * @return 1 while the sweep sets the duty, 0 otherwise.
+ */
+static uint8_t fan_core_ff_sweep(fan_core_t *core, int32_t *duty) {
+	uint32_t settle = FAN_CORE_FF_SETTLE_MS / FAN_CORE_SAMPLE_MS;
+	uint32_t average = FAN_CORE_FF_AVERAGE_MS / FAN_CORE_SAMPLE_MS;
+	uint8_t point = core->ff_point;
+
+	if (point >= FAN_CORE_FF_POINTS) {
+		return 0;
+	}
+
+	core->ff_samples++;
+	if (core->ff_samples > settle - average) {
+		core->ff_sum += core->actual_rpm;
+	}
+	if (core->ff_samples < settle) {
+		*duty = fan_core_ff_point_duty(point);
+		return 1;
+	}
+
+	/* A higher duty never gives a lower speed, measuring noise must not make the table fall */
+	core->ff_rpm[point] = core->ff_sum / average;
+	if (point > 0 && core->ff_rpm[point] < core->ff_rpm[point - 1]) {
+		core->ff_rpm[point] = core->ff_rpm[point - 1];
+	}
+	core->ff_samples = 0;
+	core->ff_sum = 0;
+	core->ff_point = point + 1;
+
+	if (core->ff_point < FAN_CORE_FF_POINTS) {
+		*duty = fan_core_ff_point_duty(point + 1);
+		return 1;
+	}
+
+	/* Done: the next sample feeds the target forward absolutely */
+	core->ff_ready = 1;
+	core->ff_target = FAN_CORE_FF_NONE;
+	return 0;
+}
+
+/**
+ * @brief Interpolates the duty for an RPM from the feed-forward table of a fan.
+ *
+ * @param core The fan.
+ * @param rpm Desired RPM.
+ * @return Duty FAN_CORE_MIN_DUTY ... FAN_CORE_MAX_DUTY.
+ */
+static int32_t fan_core_ff_duty(const fan_core_t *core, uint32_t rpm) {
+	uint32_t low;
+	uint32_t high;
+
+	if (rpm <= core->ff_rpm[0]) {
+		return fan_core_ff_point_duty(0);
+	}
+	for (uint8_t i = 1; i < FAN_CORE_FF_POINTS; i++) {
+		low = core->ff_rpm[i - 1];
+		high = core->ff_rpm[i];
+		/* Flat parts of the table (equal RPM) are skipped, there rpm is never between low and high */
+		if (rpm <= high && high > low) {
+			return fan_core_ff_point_duty(i - 1)
+					+ (int32_t) (((rpm - low)
+							* (fan_core_ff_point_duty(i) - fan_core_ff_point_duty(i - 1))
+							+ (high - low) / 2) / (high - low));
+		}
+	}
+	return FAN_CORE_MAX_DUTY;
+}
+
+/**
+ * @brief Returns the duty of a point of the feed-forward table.
+ *
+ * @param point 0 ... FAN_CORE_FF_POINTS - 1.
+ * @return Duty, evenly spaced from FAN_CORE_MIN_DUTY to FAN_CORE_MAX_DUTY.
+ */
+static uint32_t fan_core_ff_point_duty(uint8_t point) {
+	return FAN_CORE_MIN_DUTY + ((FAN_CORE_MAX_DUTY - FAN_CORE_MIN_DUTY) * point
+			+ (FAN_CORE_FF_POINTS - 1) / 2) / (FAN_CORE_FF_POINTS - 1);
+}
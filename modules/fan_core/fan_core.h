@@ -0,0 +1,107 @@
+/**
+**************************************************
+* @file fan_core.h
+* @author Berkay Özgür, C. Arda Sengenc
+* @version v1.0
+* @date 17.10.2026
+* @brief: Header file for the hardware independent part of the fan control (RPM estimation,
+*         PI control, feed-forward and auto-tuning of one fan).
+**************************************************
+*/
+
+#ifndef FAN_CORE_FAN_CORE_H_
+#define FAN_CORE_FAN_CORE_H_
+
+/* Includes */
+#include <stdint.h>
+#include <pi_ctrl/pi_ctrl.h>
+#include <relay_tune/relay_tune.h>
+
+/* Public preprocessor macros */
+/* Duty cycle as Q15 command of the controller (0.0 ... 0.99997), independent of the compare steps */
+#define FAN_CORE_DUTY_Q15(x) ((int32_t) ((x) * 32768.0 + 0.5))
+/* Limits of the duty */
+#define FAN_CORE_MAX_DUTY FAN_CORE_DUTY_Q15(0.995)
+#define FAN_CORE_MIN_DUTY FAN_CORE_DUTY_Q15(0.075)
+
+/* Fixed sample time of the control, fan_core_sample() must be called this often */
+#define FAN_CORE_SAMPLE_MS 20
+
+/* Default number of edge periods, whose median the RPM estimation uses (odd) */
+#define FAN_CORE_TACHO_WINDOW 3
+/* Timestamps in the ring of every fan */
+#define FAN_CORE_TACHO_RING 16
+/* Time without an edge, after which the fan counts as stalled (periods up to this are measured, i.e. 60 RPM) */
+#define FAN_CORE_STALL_MS 500
+
+/* Duties of the feed-forward table, from FAN_CORE_MIN_DUTY to FAN_CORE_MAX_DUTY */
+#define FAN_CORE_FF_POINTS 8
+/* Feed-forward table: time per duty and the time at its end, that is averaged */
+#define FAN_CORE_FF_SETTLE_MS 3000
+#define FAN_CORE_FF_AVERAGE_MS 500
+
+/* Time limit of the auto-tuning */
+#define FAN_CORE_TUNE_MAX_MS 30000
+
+/* Public types */
+/* Quality of the RPM of a fan */
+typedef enum {
+	FAN_CORE_RPM_STARTING,	/* not enough edges since the start or a stall yet, the RPM is 0 */
+	FAN_CORE_RPM_VALID,
+	FAN_CORE_RPM_NOISY,		/* valid, but the median has rejected an outlier in the window */
+	FAN_CORE_RPM_STALLED,	/* no edge for FAN_CORE_STALL_MS, the RPM is 0 */
+} fan_core_rpm_quality_t;
+
+/* Estimation and control of one fan. The fields belong to fan_core, use the functions below. */
+typedef struct {
+	/* Target and estimated speed */
+	volatile uint32_t target_rpm;
+	volatile uint32_t time_interval;			// median time between two edges in timer ticks
+	volatile uint32_t actual_rpm;
+	volatile fan_core_rpm_quality_t quality;
+
+	/* Timestamps of the tacho edges, written by the capture DMA (or a simulated fan) only */
+	uint32_t tacho_ring[FAN_CORE_TACHO_RING];
+	uint32_t tick_hz;							// counter frequency of the timestamps
+	uint32_t tacho_last_written;				// ring index of the next timestamp at the last sample
+	uint32_t tacho_fresh;						// edges since the start or the last stall (saturates)
+	uint32_t tacho_quiet_ms;					// time since the last edge
+	volatile uint8_t tacho_window;				// number of periods, whose median is used
+
+	/* PI controller and its gains (tuned or default) */
+	pi_ctrl_t pi;
+	int32_t kp;
+	int32_t ki;
+
+	/* Auto-tuning, requested by fan_core_autotune(), it starts in the next sample */
+	relay_tune_t tune;
+	volatile uint8_t tune_requested;
+	volatile relay_tune_rule tune_rule;
+
+	/* Feed-forward: steady RPM at the duties of the sweep (monotone) and the state of the sweep */
+	uint32_t ff_rpm[FAN_CORE_FF_POINTS];
+	volatile uint8_t ff_ready;
+	volatile uint8_t ff_requested;
+	uint8_t ff_point;							// FAN_CORE_FF_POINTS when not sweeping
+	uint32_t ff_samples;
+	uint32_t ff_sum;
+	uint32_t ff_target;							// target, whose feed-forward duty is in the output
+} fan_core_t;
+
+/* Public functions (prototypes) */
+void fan_core_init(fan_core_t *core, uint32_t tick_hz);
+void fan_core_restart(fan_core_t *core);
+int32_t fan_core_sample(fan_core_t *core, uint32_t written);
+void fan_core_set_target(fan_core_t *core, uint32_t rpm);
+uint32_t fan_core_get_target(const fan_core_t *core);
+uint32_t fan_core_get_rpm(const fan_core_t *core);
+uint32_t fan_core_get_interval(const fan_core_t *core);
+fan_core_rpm_quality_t fan_core_get_quality(const fan_core_t *core);
+void fan_core_set_tacho_window(fan_core_t *core, uint8_t periods);
+void fan_core_autotune(fan_core_t *core, relay_tune_rule rule);
+relay_tune_state fan_core_get_autotune_state(const fan_core_t *core);
+void fan_core_learn_feedforward(fan_core_t *core);
+uint8_t fan_core_feedforward_ready(const fan_core_t *core);
+uint32_t fan_core_rpm_from_period(uint32_t tick_hz, uint32_t period);
+
+#endif /* FAN_CORE_FAN_CORE_H_ */
@@ -0,0 +1,261 @@
+/**
+ **************************************************
+ * @file fan_sim.c
+ * @author Berkay Özgür, C. Arda Sengenc
+ * @version v1.0
+ * @date 17.10.2026
+ * @brief: Simulated fan for fan_core: a first order plus dead time model from the duty to the
+ * speed, that writes quantized tacho timestamps into a ring exactly like the capture DMA does.
+ * Together with the step response metrics, controller changes can be compared without a fan.
+ @verbatim
+ ==================================================
+ ### Resources used ###
+
+ None, the model runs in plain C and can also be compiled on a PC.
+
+ ==================================================
+ ### Model ###
+
+ Dead time: the duty reaches the motor dead_ms later.
+ Speed: first order towards gain * (duty - offset_duty) with the time constant tau_ms,
+ below offset_duty the fan stands still. The duty is the Q15 command of the controller
+ (0 ... 32767), the compare steps of the PWM are not simulated.
+ Tacho: pulses_per_rev edges per revolution, the time of every edge is calculated within
+ the millisecond step and quantized to the ticks of the capture timer (tick_hz).
+
+ ==================================================
+ ### Usage ###
+
+ (#) Call "fan_sim_init()" with the model parameters and the timestamp ring.
+
+ (#) Call "fan_sim_set_duty()" whenever the controller sets a new duty and "fan_sim_step()"
+ for every simulated millisecond. "fan_sim_get_written()" and "fan_sim_get_edges()" replace
+ the DMA counter and the edge count of the hardware.
+
+ (#) Call "fan_sim_metrics_start()" at the step, "fan_sim_metrics_add()" every millisecond with
+ the speed and "fan_sim_metrics_check()" to compare the result with limits.
+
+ @endverbatim
+ **************************************************
+ */
+
+/* Includes */
+#include "fan_sim.h"
+
+/* Module functions (prototypes) */
+static void fan_sim_edge(fan_sim_t *sim, float step_fraction);
+
+/**
+ * @brief Initializes a simulated fan, it stands still with duty 0.
+ *
+ * @param sim The simulated fan.
+ * @param params Model parameters (copied).
+ * @param ring Ring for the tacho timestamps.
+ * @param ring_size Number of timestamps in the ring.
+ * @return none
+ */
+void fan_sim_init(fan_sim_t *sim, const fan_sim_params_t *params, uint32_t *ring,
+		uint32_t ring_size) {
+	sim->params = *params;
+	if (sim->params.dead_ms > FAN_SIM_MAX_DEAD_MS) {
+		sim->params.dead_ms = FAN_SIM_MAX_DEAD_MS;
+	}
+	sim->rpm = 0;
+	sim->phase = 0;
+	sim->time_us = 0;
+	sim->duty = 0;
+	for (uint32_t i = 0; i < FAN_SIM_MAX_DEAD_MS; i++) {
+		sim->dead_line[i] = 0;
+	}
+	sim->dead_index = 0;
+	sim->ring = ring;
+	sim->ring_size = ring_size;
+	sim->written = 0;
+	sim->edges = 0;
+}
+
+/**
+ * @brief Sets the duty, that the controller outputs (the Q15 command, before fan_control scales it
+ *        to the compare steps of the PWM).
+ * @param sim The simulated fan.
+ * @param duty Duty as Q15 command (0 ... 32767).
+ * @return none
+ */
+void fan_sim_set_duty(fan_sim_t *sim, uint32_t duty) {
+	sim->duty = duty;
+}
+
+/**
+ * @brief Advances the model by FAN_SIM_STEP_MS: dead time, speed and tacho edges.
+ * @param sim The simulated fan.
+ * @return none
+ */
+void fan_sim_step(fan_sim_t *sim) {
+	uint32_t duty = sim->duty;
+	float target = 0;
+	float rate;
+	float used = 0;
+
+	/* Dead time: the duty of dead_ms ago is applied now */
+	if (sim->params.dead_ms > 0) {
+		duty = sim->dead_line[sim->dead_index];
+		sim->dead_line[sim->dead_index] = sim->duty;
+		sim->dead_index = (sim->dead_index + 1) % sim->params.dead_ms;
+	}
+
+	if (duty > sim->params.offset_duty) {
+		target = sim->params.gain * (float) (duty - sim->params.offset_duty);
+	}
+	/* First order step (backward Euler, stable for every time constant) */
+	sim->rpm += (target - sim->rpm) * FAN_SIM_STEP_MS
+			/ (float) (sim->params.tau_ms + FAN_SIM_STEP_MS);
+
+	/* Tacho pulses per millisecond, every completed pulse is one edge */
+	rate = sim->rpm * sim->params.pulses_per_rev / 60000.0f;
+	if (rate > 0) {
+		while (sim->phase + rate * (1.0f - used) >= 1.0f) {
+			used += (1.0f - sim->phase) / rate;
+			sim->phase = 0;
+			fan_sim_edge(sim, used);
+		}
+		sim->phase += rate * (1.0f - used);
+	}
+
+	sim->time_us += FAN_SIM_STEP_MS * 1000;
+}
+
+/**
+ * @brief Returns the true speed of the model.
+ * @param sim The simulated fan.
+ * @return Speed in RPM.
+ */
+uint32_t fan_sim_get_rpm(const fan_sim_t *sim) {
+	return (uint32_t) (sim->rpm + 0.5f);
+}
+
+/**
+ * @brief Returns the index of the next timestamp in the ring (what the DMA counter tells on hardware).
+ * @param sim The simulated fan.
+ * @return Index 0 ... ring_size - 1.
+ */
+uint32_t fan_sim_get_written(const fan_sim_t *sim) {
+	return sim->written;
+}
+
+/**
+ * @brief Returns the number of tacho edges since the start.
+ * @param sim The simulated fan.
+ * @return Edges.
+ */
+uint32_t fan_sim_get_edges(const fan_sim_t *sim) {
+	return sim->edges;
+}
+
+/**
+ * @brief Starts the measurement of a step response.
+ *
+ * @param metrics The measurement.
+ * @param start_rpm Speed before the step.
+ * @param target_rpm Target after the step.
+ * @param duration_ms Length of the run, the steady state error is taken from its last fifth.
+ * @return none
+ */
+void fan_sim_metrics_start(fan_sim_metrics_t *metrics, uint32_t start_rpm,
+		uint32_t target_rpm, uint32_t duration_ms) {
+	metrics->start_rpm = start_rpm;
+	metrics->target_rpm = target_rpm;
+	metrics->duration_ms = duration_ms;
+	metrics->elapsed_ms = 0;
+	metrics->t10_ms = duration_ms;
+	metrics->t90_ms = duration_ms;
+	metrics->rise_ms = duration_ms;
+	metrics->settling_ms = 0;
+	metrics->overshoot_rpm = 0;
+	metrics->steady_state_error_rpm = 0;
+	metrics->error_sum = 0;
+	metrics->error_count = 0;
+}
+
+/**
+ * @brief Adds the speed of one millisecond to the measurement and updates the metrics.
+ *
+ * @param metrics The measurement.
+ * @param rpm Speed in this millisecond.
+ * @return none
+ */
+void fan_sim_metrics_add(fan_sim_metrics_t *metrics, uint32_t rpm) {
+	/* Everything is counted in the direction of the step, so up and down steps are alike */
+	int32_t direction = (metrics->target_rpm >= metrics->start_rpm) ? 1 : -1;
+	int32_t step = (metrics->target_rpm - metrics->start_rpm) * direction;
+	int32_t progress = ((int32_t) rpm - metrics->start_rpm) * direction;
+	int32_t beyond = ((int32_t) rpm - metrics->target_rpm) * direction;
+	int32_t band = (step * FAN_SIM_SETTLE_PERCENT) / 100;
+	int32_t error = metrics->target_rpm - (int32_t) rpm;
+
+	if (band < FAN_SIM_SETTLE_MIN_RPM) {
+		band = FAN_SIM_SETTLE_MIN_RPM;
+	}
+
+	metrics->elapsed_ms++;
+
+	if (metrics->t10_ms == metrics->duration_ms && progress * 10 >= step) {
+		metrics->t10_ms = metrics->elapsed_ms;
+	}
+	if (metrics->t90_ms == metrics->duration_ms && progress * 10 >= step * 9) {
+		metrics->t90_ms = metrics->elapsed_ms;
+		metrics->rise_ms = metrics->t90_ms - metrics->t10_ms;
+	}
+	if (beyond > (int32_t) metrics->overshoot_rpm) {
+		metrics->overshoot_rpm = beyond;
+	}
+	/* Settled from the millisecond after the last one outside the band */
+	if (error > band || error < -band) {
+		metrics->settling_ms = metrics->elapsed_ms;
+	}
+	if (metrics->elapsed_ms > metrics->duration_ms - metrics->duration_ms / 5) {
+		metrics->error_sum += error;
+		metrics->error_count++;
+		metrics->steady_state_error_rpm = (int32_t) (metrics->error_sum
+				/ (int32_t) metrics->error_count);
+	}
+}
+
+/**
+ * @brief Compares a step response with limits (the regression gate for controller changes).
+ *
+ * @param metrics The measured step response.
+ * @param limits Largest allowed values (the magnitude of the steady state error is compared).
+ * @return 1 if all metrics are within their limits, 0 otherwise.
+ */
+uint8_t fan_sim_metrics_check(const fan_sim_metrics_t *metrics,
+		const fan_sim_metrics_t *limits) {
+	int32_t error = metrics->steady_state_error_rpm;
+	int32_t error_limit = limits->steady_state_error_rpm;
+
+	if (error < 0) {
+		error = -error;
+	}
+	if (error_limit < 0) {
+		error_limit = -error_limit;
+	}
+	return metrics->rise_ms <= limits->rise_ms
+			&& metrics->settling_ms <= limits->settling_ms
+			&& metrics->overshoot_rpm <= limits->overshoot_rpm
+			&& error <= error_limit;
+}
+
+/**
+ * @brief Writes the timestamp of one tacho edge into the ring.
+ * @param sim The simulated fan.
+ * @param step_fraction Time of the edge within the current step (0 ... 1).
+ * @return none
+ */
+static void fan_sim_edge(fan_sim_t *sim, float step_fraction) {
+	uint64_t edge_us = sim->time_us
+			+ (uint32_t) (step_fraction * (FAN_SIM_STEP_MS * 1000.0f));
+
+	/* Quantized to the capture timer, like the hardware captures the counter value */
+	sim->ring[sim->written] = (uint32_t) ((edge_us * sim->params.tick_hz) / 1000000);
+	sim->written = (sim->written + 1) % sim->ring_size;
+	sim->edges++;
+}
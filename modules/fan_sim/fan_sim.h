@@ -0,0 +1,80 @@
+/**
+**************************************************
+* @file fan_sim.h
+* @author Berkay Özgür, C. Arda Sengenc
+* @version v1.0
+* @date 17.10.2026
+* @brief: Header file for the simulated fan (plant model with tacho) and the step response metrics.
+**************************************************
+*/
+
+#ifndef FAN_SIM_FAN_SIM_H_
+#define FAN_SIM_FAN_SIM_H_
+
+/* Includes */
+#include <stdint.h>
+
+/* Public preprocessor macros */
+/* The model advances in steps of one millisecond */
+#define FAN_SIM_STEP_MS 1
+/* Longest dead time of the model */
+#define FAN_SIM_MAX_DEAD_MS 100
+/* Settling band: FAN_SIM_SETTLE_PERCENT of the step, but at least FAN_SIM_SETTLE_MIN_RPM */
+#define FAN_SIM_SETTLE_PERCENT 2
+#define FAN_SIM_SETTLE_MIN_RPM 20
+
+/* Public types */
+/* First order plus dead time model of a fan with tacho */
+typedef struct {
+	float gain;					// RPM per Q15 duty step (1 / 32768) above offset_duty
+	uint32_t offset_duty;		// Q15 duty, below which the fan stands still
+	uint32_t tau_ms;			// time constant of the speed
+	uint32_t dead_ms;			// dead time from the duty to the speed (at most FAN_SIM_MAX_DEAD_MS)
+	uint32_t pulses_per_rev;	// tacho pulses per revolution
+	uint32_t tick_hz;			// counter frequency of the capture timer, the timestamps are quantized to it
+} fan_sim_params_t;
+
+/* State of one simulated fan */
+typedef struct {
+	fan_sim_params_t params;
+	float rpm;					// true speed
+	float phase;				// tacho pulses since the last edge (0 ... 1)
+	uint32_t time_us;			// simulated time
+	uint32_t duty;				// Q15 duty, that was set last
+	uint32_t dead_line[FAN_SIM_MAX_DEAD_MS];	// Q15 duties on their way through the dead time
+	uint32_t dead_index;
+	uint32_t *ring;				// timestamps of the tacho edges, like the DMA writes them
+	uint32_t ring_size;
+	uint32_t written;			// index of the next timestamp in the ring
+	uint32_t edges;				// edges since the start
+} fan_sim_t;
+
+/* Step response metrics, all times in milliseconds from the step on */
+typedef struct {
+	uint32_t rise_ms;			// from 10 % to 90 % of the step
+	uint32_t settling_ms;		// until the speed stays within the settling band
+	uint32_t overshoot_rpm;		// largest speed beyond the target
+	int32_t steady_state_error_rpm;	// mean (target - speed) over the last fifth of the run
+	/* Internal state of the measurement */
+	int32_t start_rpm;
+	int32_t target_rpm;
+	uint32_t duration_ms;
+	uint32_t elapsed_ms;
+	uint32_t t10_ms;
+	uint32_t t90_ms;
+	int64_t error_sum;
+	uint32_t error_count;
+} fan_sim_metrics_t;
+
+/* Public functions (prototypes) */
+void fan_sim_init(fan_sim_t *sim, const fan_sim_params_t *params, uint32_t *ring, uint32_t ring_size);
+void fan_sim_set_duty(fan_sim_t *sim, uint32_t duty);
+void fan_sim_step(fan_sim_t *sim);
+uint32_t fan_sim_get_rpm(const fan_sim_t *sim);
+uint32_t fan_sim_get_written(const fan_sim_t *sim);
+uint32_t fan_sim_get_edges(const fan_sim_t *sim);
+void fan_sim_metrics_start(fan_sim_metrics_t *metrics, uint32_t start_rpm, uint32_t target_rpm, uint32_t duration_ms);
+void fan_sim_metrics_add(fan_sim_metrics_t *metrics, uint32_t rpm);
+uint8_t fan_sim_metrics_check(const fan_sim_metrics_t *metrics, const fan_sim_metrics_t *limits);
+
+#endif /* FAN_SIM_FAN_SIM_H_ */
@@ -0,0 +1,441 @@
+/**
+ **************************************************
+ * @file freq_counter.c
+ * @author Berkay Özgür, C. Arda Sengenc
+ * @version v1.0
+ * @date 17.10.2026
+ * @brief: Frequency counter for any pulse source (fan tacho, encoder, oscillator ...), that
+ * switches between period measurement at low and edge counting at high frequencies, so the
+ * relative precision stays high over the whole range. No interrupt and no DMA of its own.
+ @verbatim
+ ==================================================
+ ### Resources used ###
+
+ One timer per counter (TIM1, TIM3, TIM4, TIM8, TIM9, TIM12 or the 32 bit ones, if free), given
+ with its pins in a freq_counter_hw_t. The timer must have a slave mode controller
+ (not TIM6, TIM7, TIM10, TIM11, TIM13, TIM14). TIM8 paces the ADC, if potis_dma is used.
+
+ SOFT_TIMER: One periodic timer (in the tick interrupt) polls all counters every tick.
+
+ TIMER: Global timebase (TIM5, see timebase.c) for the length of a gate.
+
+ ==================================================
+ ### Principle ###
+
+ Period mode (low frequencies): the timer counts its clock, every rising edge on channel 1
+ captures the counter into CCR1 and resets it (slave reset mode), so CCR1 always holds the
+ last full period. The polls count the overflows in between, so a period may be much longer
+ than the range of the counter. Every poll, that sees a new capture, adds the period to a sum,
+ after the gate the frequency is periods / sum (reciprocal counting). Capture and reset happen
+ on the same edge, synchronized to the timer clock, so in a run of periods without a missed
+ edge the rounding errors cancel and the whole run is exact to one tick. Below the poll rate
+ every period is caught and one run covers the gate, above it every period is a run of its own.
+ Precision: runs / ticks in the sum.
+
+ Count mode (high frequencies): the edges clock the timer (external clock mode 2 from ETR, or
+ mode 1 from channel 1), the polls add the counted edges. After the gate the frequency is
+ edges / gate length. Precision: 1 / edges in the gate.
+
+ Switching: with rising frequency the edges of the count mode grow, while the period mode
+ loses precision, once the signal is faster than the polls. After every gate the counter
+ estimates the precision of the other mode and switches, when it would be twice as good
+ (the factor is the hysteresis). Both meet at sqrt(timer clock / gate), with a 16 MHz timer
+ clock and a 100 ms gate at about 12.6 kHz with 800 ppm. Far from this point the precision is
+ much better: 600 ppb below the poll rate (1 kHz), 50 ppm at 1 MHz. A longer gate improves it.
+
+ A source, that stops, reads at most the frequency of the time since its last edge, and 0 after
+ 2^32 timer clocks (268 s at 16 MHz) in the period mode or one empty gate in the count mode.
+
+ ==================================================
+ ### Usage ###
+
+ (#) Describe the timer and the pins, e.g. TIM4_CH1 on PD12 with the same signal on TIM4_ETR (PE0):
+ static const freq_counter_hw_t hw = { TIM4, GPIOD, GPIO_PIN_12, GPIO_AF2_TIM4, GPIO_PULLUP, 3,
+ 	GPIOE, GPIO_PIN_0 };
+ Without a second wire etr_port is 0 and the count mode takes its clock from channel 1 too.
+
+ (#) Call "freq_counter_init()" once, then "freq_counter_add()" with a freq_counter_t
+ (global variable), the pins and the gate in milliseconds (e.g. 100).
+
+ (#) Call "freq_counter_get_frequency_mhz()" for the last result in millihertz,
+ "freq_counter_get_results()" to see, whether there is a new one, and
+ "freq_counter_get_resolution_ppb()" for its precision.
+
+ @endverbatim
+ **************************************************
+ */
+
+/* Includes */
+#include "stm32f4xx.h"
+#include <freq_counter/freq_counter.h>
+#include <my_timer/my_timer.h>
+#include <soft_timer/soft_timer.h>
+#include <timebase/timebase.h>
+#include <utils.h>
+
+/* Preprocessor macros */
+/* The other mode must be this many times more precise, before the counter switches */
+#define FREQ_COUNTER_HYSTERESIS 2
+/* A period mode without an edge for this many timer clocks reads 0 */
+#define FREQ_COUNTER_STOP_CLOCKS 0x100000000ULL
+
+/* Module functions (prototypes) */
+static void freq_counter_poll(void *arg);
+static void freq_counter_sample_period(freq_counter_t *counter);
+static void freq_counter_sample_count(freq_counter_t *counter);
+static void freq_counter_start_period(freq_counter_t *counter);
+static void freq_counter_start_count(freq_counter_t *counter);
+static void freq_counter_restart_gate(freq_counter_t *counter, uint32_t now_us);
+static void freq_counter_publish(freq_counter_t *counter, uint64_t frequency_mhz,
+		uint32_t resolution_ppb);
+
+/* Module variables */
+static freq_counter_t *freq_counter_counters[FREQ_COUNTER_MAX_COUNTERS];
+static volatile uint8_t freq_counter_used = 0;
+soft_timer_t freq_counter_timer;
+
+/**
+ * @brief Starts the polling of the counters.
+ * @param none
+ * @return none
+ */
+void freq_counter_init(void) {
+	timebase_init();
+	soft_timer_init(0);
+	soft_timer_setup(&freq_counter_timer, freq_counter_poll, 0, SOFT_TIMER_ISR);
+	soft_timer_start(&freq_counter_timer, 1, 1);
+}
+
+/**
+ * @brief Starts a counter on its timer. It begins in the period mode and switches after the
+ *        first measurement, if the count mode is more precise. soft_timer_init() must not change
+ *        the tick afterwards.
+ *
+ * @param counter The counter, it must stay valid (static or global).
+ * @param hw Timer and pins, they must stay valid too.
+ * @param gate_ms Shortest time of one measurement in milliseconds.
+ * @return 0 on success, -1 if all counters are used or the timer has no slave mode controller.
+ */
+int8_t freq_counter_add(freq_counter_t *counter, const freq_counter_hw_t *hw,
+		uint32_t gate_ms) {
+	uint64_t range;
+	uint64_t prescaler;
+
+	if (freq_counter_used >= FREQ_COUNTER_MAX_COUNTERS
+			|| !IS_TIM_SLAVE_INSTANCE(hw->timer)
+			|| (hw->etr_port != 0 && !IS_TIM_ETR_INSTANCE(hw->timer))) {
+		return -1;
+	}
+
+	counter->hw = hw;
+	counter->gate_us = gate_ms * 1000;
+	counter->frequency_mhz = 0;
+	counter->resolution_ppb = 0;
+	counter->results = 0;
+
+	utils_init_gpio(hw->port, hw->pin, GPIO_MODE_AF_PP, hw->pull, hw->alternate,
+			GPIO_SPEED_FREQ_HIGH);
+	if (hw->etr_port != 0) {
+		utils_init_gpio(hw->etr_port, hw->etr_pin, GPIO_MODE_AF_PP, hw->pull,
+				hw->alternate, GPIO_SPEED_FREQ_HIGH);
+	}
+
+	/* Full clock and full range, the prescaler is set by the modes */
+	my_timer_init(&counter->timer, hw->timer, TIMER_MODE_IC,
+			my_timer_get_clock(hw->timer), 0);
+	my_timer_ic_init(&counter->timer, TIM_CHANNEL_1, TIM_INPUTCHANNELPOLARITY_RISING,
+			hw->filter);
+	/* Only an overflow sets the update flag, not the reset by an edge */
+	hw->timer->CR1 |= TIM_CR1_URS;
+	HAL_TIM_IC_Start(&counter->timer.handle, TIM_CHANNEL_1);
+
+	/* Smallest prescaler, that leaves two polls between two overflows (1 with 1 ms polls) */
+	range = (uint64_t) counter->timer.handle.Init.Period + 1;
+	prescaler = (2ULL * soft_timer_get_tick_us() * counter->timer.clock / 1000000 + range - 1)
+			/ range;
+	if (prescaler < 1) {
+		prescaler = 1;
+	} else if (prescaler > 0x10000) {
+		prescaler = 0x10000;
+	}
+	counter->prescaler = (uint32_t) prescaler;
+	freq_counter_start_period(counter);
+
+	/* The poll interrupt may run between both lines, it only reads the counters below the count */
+	freq_counter_counters[freq_counter_used] = counter;
+	freq_counter_used++;
+	return 0;
+}
+
+/**
+ * @brief Returns the result of the last measurement.
+ * @param counter The counter.
+ * @return Frequency in millihertz, 0 before the first measurement or without a signal.
+ */
+uint64_t freq_counter_get_frequency_mhz(const freq_counter_t *counter) {
+	uint32_t primask = __get_PRIMASK();
+	uint64_t frequency_mhz;
+
+	/* 64 bit are read in two halves, the poll interrupt must not write in between */
+	__disable_irq();
+	frequency_mhz = counter->frequency_mhz;
+	if (!primask) {
+		__enable_irq();
+	}
+	return frequency_mhz;
+}
+
+/**
+ * @brief Returns the precision of the last measurement: one count (edge or tick) relative to
+ *        all counts of the measurement.
+ * @param counter The counter.
+ * @return Resolution in parts per billion, 0 before the first measurement.
+ */
+uint32_t freq_counter_get_resolution_ppb(const freq_counter_t *counter) {
+	return counter->resolution_ppb;
+}
+
+/**
+ * @brief Returns the number of measurements so far, it changes with every new result.
+ * @param counter The counter.
+ * @return Number of measurements.
+ */
+uint32_t freq_counter_get_results(const freq_counter_t *counter) {
+	return counter->results;
+}
+
+/**
+ * @brief Returns the current mode of a counter.
+ * @param counter The counter.
+ * @return FREQ_COUNTER_PERIOD or FREQ_COUNTER_COUNT.
+ */
+freq_counter_mode_t freq_counter_get_mode(const freq_counter_t *counter) {
+	return counter->mode;
+}
+
+/**
+ * @brief Soft timer callback (tick interrupt): polls every counter once.
+ * @param arg not used
+ * @return none
+ */
+static void freq_counter_poll(void *arg) {
+	uint8_t used = freq_counter_used;
+
+	for (uint8_t i = 0; i < used; i++) {
+		if (freq_counter_counters[i]->mode == FREQ_COUNTER_PERIOD) {
+			freq_counter_sample_period(freq_counter_counters[i]);
+		} else {
+			freq_counter_sample_count(freq_counter_counters[i]);
+		}
+	}
+}
+
+/**
+ * @brief Poll in the period mode: extends the counter by its overflows, adds a new capture to the
+ *        sum and finishes the gate.
+ * @param counter The counter.
+ * @return none
+ */
+static void freq_counter_sample_period(freq_counter_t *counter) {
+	TIM_TypeDef *timer = counter->hw->timer;
+	uint64_t clock = counter->timer.clock;
+	uint64_t range = (uint64_t) counter->timer.handle.Init.Period + 1;
+	uint32_t status = timer->SR;
+	uint64_t ticks;
+	uint64_t quiet_clocks;
+	uint64_t frequency_mhz;
+	uint64_t edges;
+	uint32_t now_us;
+
+	if (status & TIM_SR_UIF) {
+		__HAL_TIM_CLEAR_FLAG(&counter->timer.handle, TIM_FLAG_UPDATE);
+		counter->overflows++;
+	}
+
+	if (status & TIM_SR_CC1IF) {
+		/* Reading CCR1 clears the capture flag */
+		ticks = timer->CCR1;
+		if (status & TIM_SR_CC1OF) {
+			/* Several edges since the last poll: the last period is shorter than a poll, so no
+			 * overflow belongs to it, and the edges before it are lost */
+			__HAL_TIM_CLEAR_FLAG(&counter->timer.handle, TIM_FLAG_CC1OF);
+			counter->in_run = 0;
+		} else {
+			/* The counter can not overflow between the edge and this poll, so all overflows
+			 * since the last edge belong to this period */
+			ticks += counter->overflows * range;
+		}
+		counter->overflows = 0;
+
+		if (counter->discard) {
+			counter->discard = 0;
+			counter->in_run = 0;
+		} else if (ticks != 0) {
+			if (!counter->in_run) {
+				counter->runs++;
+			}
+			counter->in_run = 1;
+			counter->edges++;
+			counter->tick_sum += ticks;
+		}
+	} else if (status & TIM_SR_UIF) {
+		/* The frequency can at most be the one of the time since the last edge */
+		quiet_clocks = counter->overflows * range * counter->prescaler;
+		if (quiet_clocks >= FREQ_COUNTER_STOP_CLOCKS) {
+			counter->frequency_mhz = 0;
+		} else {
+			frequency_mhz = clock * 1000 / quiet_clocks;
+			if (counter->frequency_mhz > frequency_mhz) {
+				counter->frequency_mhz = frequency_mhz;
+			}
+		}
+	}
+
+	now_us = timebase_now_us();
+	counter->polls++;
+	if (counter->edges == 0 || now_us - counter->gate_start_us < counter->gate_us) {
+		return;
+	}
+
+	frequency_mhz = ((uint64_t) counter->edges * clock * 1000
+			+ counter->tick_sum * counter->prescaler / 2)
+			/ (counter->tick_sum * counter->prescaler);
+	freq_counter_publish(counter, frequency_mhz,
+			(uint32_t) ((1000000000ULL * counter->runs) / counter->tick_sum));
+
+	/* Edges, that the count mode would have seen in the same gate, against ticks per run */
+	edges = frequency_mhz * (now_us - counter->gate_start_us) / 1000000000ULL;
+	if (edges * counter->runs > FREQ_COUNTER_HYSTERESIS * counter->tick_sum) {
+		freq_counter_start_count(counter);
+	} else {
+		freq_counter_restart_gate(counter, now_us);
+	}
+}
+
+/**
+ * @brief Poll in the count mode: adds the edges since the last poll and finishes the gate.
+ * @param counter The counter.
+ * @return none
+ */
+static void freq_counter_sample_count(freq_counter_t *counter) {
+	/* Counter and time are read together, they are the borders of the gate */
+	uint32_t count = counter->hw->timer->CNT;
+	uint32_t now_us = timebase_now_us();
+	uint32_t elapsed_us = now_us - counter->gate_start_us;
+	uint64_t ticks;
+
+	counter->edges += (count - counter->last_count) & counter->timer.handle.Init.Period;
+	counter->last_count = count;
+	counter->polls++;
+	if (elapsed_us < counter->gate_us) {
+		return;
+	}
+
+	if (counter->edges == 0) {
+		/* No signal (or slower than the gate), the period mode waits for it */
+		freq_counter_publish(counter, 0, 0);
+		freq_counter_start_period(counter);
+		return;
+	}
+
+	freq_counter_publish(counter,
+			((uint64_t) counter->edges * 1000000000ULL + elapsed_us / 2) / elapsed_us,
+			1000000000UL / counter->edges + 1000000000UL / elapsed_us);
+
+	/* Ticks per run, that the period mode would have summed in the same gate: the whole gate,
+	 * if it catches every period, one period otherwise */
+	ticks = (uint64_t) counter->timer.clock * elapsed_us / 1000000 / counter->prescaler;
+	if (counter->edges > counter->polls) {
+		ticks /= counter->edges;
+	}
+	if (ticks > (uint64_t) FREQ_COUNTER_HYSTERESIS * counter->edges) {
+		freq_counter_start_period(counter);
+	} else {
+		freq_counter_restart_gate(counter, now_us);
+	}
+}
+
+/**
+ * @brief Switches to the period mode: internal clock, every edge captures and resets the counter.
+ * @param counter The counter.
+ * @return none
+ */
+static void freq_counter_start_period(freq_counter_t *counter) {
+	TIM_ClockConfigTypeDef clock_source = { 0 };
+	TIM_SlaveConfigTypeDef slave = { 0 };
+
+	clock_source.ClockSource = TIM_CLOCKSOURCE_INTERNAL;
+	HAL_TIM_ConfigClockSource(&counter->timer.handle, &clock_source);
+
+	slave.SlaveMode = TIM_SLAVEMODE_RESET;
+	slave.InputTrigger = TIM_TS_TI1FP1;
+	slave.TriggerPolarity = TIM_TRIGGERPOLARITY_RISING;
+	slave.TriggerFilter = counter->hw->filter;
+	HAL_TIM_SlaveConfigSynchro(&counter->timer.handle, &slave);
+	/* The trigger configuration switches the capture off */
+	TIM_CCxChannelCmd(counter->hw->timer, TIM_CHANNEL_1, TIM_CCx_ENABLE);
+
+	/* Load the prescaler now, the first capture is not a full period */
+	my_timer_set_prescaler(&counter->timer, counter->prescaler - 1);
+	counter->hw->timer->EGR = TIM_EGR_UG;
+	__HAL_TIM_CLEAR_FLAG(&counter->timer.handle, TIM_FLAG_UPDATE | TIM_FLAG_CC1 | TIM_FLAG_CC1OF);
+	counter->mode = FREQ_COUNTER_PERIOD;
+	counter->overflows = 0;
+	counter->discard = 1;
+	freq_counter_restart_gate(counter, timebase_now_us());
+}
+
+/**
+ * @brief Switches to the count mode: the edges clock the counter.
+ * @param counter The counter.
+ * @return none
+ */
+static void freq_counter_start_count(freq_counter_t *counter) {
+	TIM_ClockConfigTypeDef clock_source = { 0 };
+
+	if (counter->hw->etr_port != 0) {
+		clock_source.ClockSource = TIM_CLOCKSOURCE_ETRMODE2;
+		clock_source.ClockPolarity = TIM_CLOCKPOLARITY_NONINVERTED;
+	} else {
+		clock_source.ClockSource = TIM_CLOCKSOURCE_TI1;
+		clock_source.ClockPolarity = TIM_CLOCKPOLARITY_RISING;
+	}
+	clock_source.ClockPrescaler = TIM_CLOCKPRESCALER_DIV1;
+	clock_source.ClockFilter = counter->hw->filter;
+	HAL_TIM_ConfigClockSource(&counter->timer.handle, &clock_source);
+
+	my_timer_set_prescaler(&counter->timer, 0);
+	counter->hw->timer->EGR = TIM_EGR_UG;
+	counter->mode = FREQ_COUNTER_COUNT;
+	counter->last_count = counter->hw->timer->CNT;
+	freq_counter_restart_gate(counter, timebase_now_us());
+}
+
+/**
+ * @brief Starts a new gate.
+ * @param counter The counter.
+ * @param now_us Start of the gate.
+ * @return none
+ */
+static void freq_counter_restart_gate(freq_counter_t *counter, uint32_t now_us) {
+	counter->gate_start_us = now_us;
+	counter->polls = 0;
+	counter->edges = 0;
+	counter->tick_sum = 0;
+	counter->runs = 0;
+	counter->in_run = 0;
+}
+
+/**
+ * @brief Stores the result of a measurement.
+ * @param counter The counter.
+ * @param frequency_mhz Frequency in millihertz.
+ * @param resolution_ppb Precision in parts per billion.
+ * @return none
+ */
+static void freq_counter_publish(freq_counter_t *counter, uint64_t frequency_mhz,
+		uint32_t resolution_ppb) {
+	counter->frequency_mhz = frequency_mhz;
+	counter->resolution_ppb = resolution_ppb;
+	counter->results++;
+}
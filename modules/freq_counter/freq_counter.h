@@ -0,0 +1,77 @@
+/**
+**************************************************
+* @file freq_counter.h
+* @author Berkay Özgür, C. Arda Sengenc
+* @version v1.0
+* @date 17.10.2026
+* @brief: Header file for the hybrid frequency counter.
+**************************************************
+*/
+
+#ifndef FREQ_COUNTER_FREQ_COUNTER_H_
+#define FREQ_COUNTER_FREQ_COUNTER_H_
+
+/* Includes */
+#include <stdint.h>
+#include "stm32f4xx.h"
+#include <my_timer/my_timer.h>
+
+/* Public preprocessor macros */
+/* Largest number of counters, each one needs a timer of its own */
+#define FREQ_COUNTER_MAX_COUNTERS 4
+
+/* Public types */
+/* How the frequency is measured at the moment */
+typedef enum {
+	FREQ_COUNTER_PERIOD,	/* low frequencies: the timer counts its clock between two edges */
+	FREQ_COUNTER_COUNT,		/* high frequencies: the edges clock the timer during the gate */
+} freq_counter_mode_t;
+
+/* Pins of a counter. The signal must reach channel 1 of the timer, for the count mode it may
+ * also reach the ETR pin of the timer (the same signal on both pins), etr_port 0 if not. */
+typedef struct {
+	TIM_TypeDef *timer;			// TIM1, TIM3, TIM4, TIM8 ... (not used by any other module, e.g. TIM8 by potis_dma)
+	GPIO_TypeDef *port;			// channel 1 pin
+	uint16_t pin;
+	uint32_t alternate;			// e.g. GPIO_AF2_TIM4
+	uint32_t pull;				// e.g. GPIO_PULLUP for open collector outputs like a fan tacho
+	uint32_t filter;			// digital input filter (0 ... 15, see ICxF in RM0090) of both pins
+	GPIO_TypeDef *etr_port;		// ETR pin, 0 to clock the count mode from channel 1 (TI1FP1)
+	uint16_t etr_pin;
+} freq_counter_hw_t;
+
+/* One counter, the memory is provided by the user. The fields belong to freq_counter,
+ * use the functions below to read the result. */
+typedef struct {
+	const freq_counter_hw_t *hw;
+	my_timer_t timer;
+	uint32_t gate_us;				// shortest time of one measurement
+	volatile freq_counter_mode_t mode;
+
+	/* Running measurement */
+	uint32_t prescaler;				// timer clocks per tick in the period mode
+	uint32_t gate_start_us;
+	uint32_t polls;					// polls in the gate
+	uint32_t edges;					// edges (count mode) or captured periods (period mode) in the gate
+	uint32_t last_count;			// counter value at the last poll (count mode)
+	uint64_t tick_sum;				// sum of the captured periods in ticks (period mode)
+	uint32_t runs;					// runs of periods without a missed edge in between (period mode)
+	uint8_t in_run;					// the last edge was captured, the next period continues the run
+	uint8_t discard;				// the next capture is not a full period
+	uint32_t overflows;				// overflows of the counter since the last edge
+
+	/* Last result */
+	volatile uint64_t frequency_mhz;
+	volatile uint32_t resolution_ppb;
+	volatile uint32_t results;
+} freq_counter_t;
+
+/* Public functions (prototypes) */
+void freq_counter_init(void);
+int8_t freq_counter_add(freq_counter_t *counter, const freq_counter_hw_t *hw, uint32_t gate_ms);
+uint64_t freq_counter_get_frequency_mhz(const freq_counter_t *counter);
+uint32_t freq_counter_get_resolution_ppb(const freq_counter_t *counter);
+uint32_t freq_counter_get_results(const freq_counter_t *counter);
+freq_counter_mode_t freq_counter_get_mode(const freq_counter_t *counter);
+
+#endif /* FREQ_COUNTER_FREQ_COUNTER_H_ */
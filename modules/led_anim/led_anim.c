@@ -0,0 +1,224 @@
+/**
+ **************************************************
+ * @file led_anim.c
+ * @author Berkay Özgür, C. Arda Sengenc
+ * @version v1.0
+ * @date 17.10.2026
+ * @brief: Module for animating four LEDs on the four channels of TIM1. The animation is a
+ * table of frames, the DMA writes one frame into CCR1 ... CCR4 per update event, so the CPU
+ * has nothing to do while it plays.
+ @verbatim
+ ==================================================
+ ### Resources used ###
+
+ TIM1: PWM on CH1 (PE9), CH2 (PE11), CH3 (PE13), CH4 (PE14), active low like the dot.
+ The repetition counter divides the update events down to the frame rate.
+
+ DMA2_Stream5, DMA_CHANNEL_6 (TIM1_UP): Burst of four half words into TIM1->DMAR on every
+ update event, DCR points the burst at CCR1. No interrupt is used.
+
+ TIM1 is also used by dot_control, only one of both can be used at a time.
+
+ ==================================================
+ ### Usage ###
+
+ (#) Call "led_anim_init()" with the frame rate (LED_ANIM_PWM_HZ / 256 ... LED_ANIM_PWM_HZ).
+
+ (#) Compile time: write the frames as constant table, it stays in flash, e.g.
+ static const led_anim_frame_t blink[] = {
+ 	LED_ANIM_FRAME(LED_ANIM_PERIOD, 0, 0, 0),
+ 	LED_ANIM_FRAME(0, 0, 0, 0),
+ };
+
+ (#) Runtime: describe the animation with keyframes and call "led_anim_build()", that
+ interpolates the frames in between into a buffer, e.g. a chase:
+ static const led_anim_keyframe_t chase[] = {
+ 	{ { LED_ANIM_PERIOD, 0, 0, 0 }, 10 },
+ 	{ { 0, LED_ANIM_PERIOD, 0, 0 }, 10 },
+ 	{ { 0, 0, LED_ANIM_PERIOD, 0 }, 10 },
+ 	{ { 0, 0, 0, LED_ANIM_PERIOD }, 10 },
+ };
+ or breathing: { { 0, 0, 0, 0 }, 50 }, { { LED_ANIM_PERIOD, ... }, 50 }.
+
+ (#) Call "led_anim_play()" with the frames, endless (loop = 1) or once. After a single run
+ the last frame stays. The frames must stay valid while they are played.
+
+ (#) Call "led_anim_stop()" to stop the animation, the current frame stays.
+
+ @endverbatim
+ **************************************************
+ */
+
+/* Includes */
+#include "stm32f4xx.h"
+#include "led_anim.h"
+#include <my_timer.h>
+#include <utils.h>
+
+/* Preprocessor macros */
+/* Largest number of frames, the DMA counter (16 bit) counts half words */
+#define LED_ANIM_MAX_FRAMES (0xFFFF / LED_ANIM_CHANNELS)
+
+/* Module variables */
+my_timer_t led_anim_timer;
+DMA_HandleTypeDef led_anim_dma_handle_struct;
+
+/* Channels in the order of the registers CCR1 ... CCR4 */
+static const uint32_t led_anim_channels[LED_ANIM_CHANNELS] = { TIM_CHANNEL_1,
+		TIM_CHANNEL_2, TIM_CHANNEL_3, TIM_CHANNEL_4 };
+
+/**
+ * @brief Initializes TIM1 with four PWM channels, their pins and the DMA stream.
+ *        All LEDs are off afterwards.
+ *
+ * @param frame_hz Frames per second, rounded to LED_ANIM_PWM_HZ / n with n = 1 ... 256.
+ * @return none
+ */
+void led_anim_init(uint32_t frame_hz) {
+	uint32_t repetitions;
+
+	HAL_Init();
+
+	/* All four channels of TIM1 on port E, alternate function 1 */
+	utils_init_gpio(GPIOE, GPIO_PIN_9 | GPIO_PIN_11 | GPIO_PIN_13 | GPIO_PIN_14,
+			GPIO_MODE_AF_PP, GPIO_NOPULL, GPIO_AF1_TIM1, GPIO_SPEED_MEDIUM);
+
+	my_timer_init(&led_anim_timer, TIM1, TIMER_MODE_PWM,
+			LED_ANIM_PWM_HZ * LED_ANIM_PERIOD, LED_ANIM_PERIOD);
+
+	/* One update event (and therefore one frame) per "repetitions" PWM periods */
+	if (frame_hz == 0) {
+		frame_hz = 1;
+	}
+	repetitions = (LED_ANIM_PWM_HZ + frame_hz / 2) / frame_hz;
+	if (repetitions < 1) {
+		repetitions = 1;
+	} else if (repetitions > 256) {
+		repetitions = 256;
+	}
+	led_anim_timer.handle.Instance->RCR = repetitions - 1;
+	/* Load the repetition counter now, it is preloaded like the other registers */
+	HAL_TIM_GenerateEvent(&led_anim_timer.handle, TIM_EVENTSOURCE_UPDATE);
+
+	for (uint8_t i = 0; i < LED_ANIM_CHANNELS; i++) {
+		/* Compare value 0: the LED is off */
+		my_timer_oc_init(&led_anim_timer, INSTANCE_PWM_1, MODE_PWM, 0,
+				led_anim_channels[i]);
+		/* The DMA writes the next frame right after the update event, with preload it is
+		 * used from the next update event on, so all four channels change at the same time */
+		my_timer_enable_preload(&led_anim_timer, led_anim_channels[i]);
+		my_timer_start(&led_anim_timer, MODE_PWM, led_anim_channels[i]);
+	}
+
+	/* Burst of four transfers starting at CCR1 on every DMA request */
+	led_anim_timer.handle.Instance->DCR = TIM_DMABASE_CCR1
+			| TIM_DMABURSTLENGTH_4TRANSFERS;
+
+	/* Clock enabling for DMA */
+	__HAL_RCC_DMA2_CLK_ENABLE();
+
+	/* For TIM1_UP we need according to Table 44 DMA2_Stream5 and DMA_CHANNEL_6. */
+	led_anim_dma_handle_struct.Instance = DMA2_Stream5;
+	led_anim_dma_handle_struct.Init.Channel = DMA_CHANNEL_6;
+	led_anim_dma_handle_struct.Init.Direction = DMA_MEMORY_TO_PERIPH;
+	/* The peripheral address is always DMAR, the timer distributes the burst to the registers */
+	led_anim_dma_handle_struct.Init.PeriphInc = DMA_PINC_DISABLE;
+	led_anim_dma_handle_struct.Init.MemInc = DMA_MINC_ENABLE;
+	/* The compare registers of TIM1 have 16 bits */
+	led_anim_dma_handle_struct.Init.PeriphDataAlignment = DMA_PDATAALIGN_HALFWORD;
+	led_anim_dma_handle_struct.Init.MemDataAlignment = DMA_MDATAALIGN_HALFWORD;
+	led_anim_dma_handle_struct.Init.Mode = DMA_CIRCULAR;
+	led_anim_dma_handle_struct.Init.Priority = DMA_PRIORITY_MEDIUM;
+	led_anim_dma_handle_struct.Init.FIFOMode = DMA_FIFOMODE_DISABLE;
+	__HAL_LINKDMA(&led_anim_timer.handle, hdma[TIM_DMA_ID_UPDATE],
+			led_anim_dma_handle_struct);
+}
+
+/**
+ * @brief Builds the frames of an animation from keyframes. Keyframe k is reached after
+ *        keys[k].frames frames, that fade linearly from keyframe k - 1. The first keyframe
+ *        fades from the last one, so a looped animation has no jump.
+ *
+ * @param keys Keyframes.
+ * @param key_count Number of keyframes.
+ * @param frames Buffer for the frames.
+ * @param max_frames Size of the buffer in frames.
+ * @return Number of frames written, 0 if the buffer is too small.
+ */
+uint32_t led_anim_build(const led_anim_keyframe_t *keys, uint16_t key_count,
+		led_anim_frame_t *frames, uint32_t max_frames) {
+	uint32_t count = 0;
+	const led_anim_keyframe_t *from;
+	const led_anim_keyframe_t *to;
+	int32_t difference;
+
+	for (uint16_t k = 0; k < key_count; k++) {
+		count += (keys[k].frames > 0) ? keys[k].frames : 1;
+	}
+	if (count == 0 || count > max_frames) {
+		return 0;
+	}
+
+	count = 0;
+	for (uint16_t k = 0; k < key_count; k++) {
+		from = &keys[(k > 0) ? k - 1 : key_count - 1];
+		to = &keys[k];
+		uint16_t steps = (to->frames > 0) ? to->frames : 1;
+
+		for (uint16_t step = 1; step <= steps; step++) {
+			for (uint8_t ch = 0; ch < LED_ANIM_CHANNELS; ch++) {
+				difference = (int32_t) to->level[ch] - (int32_t) from->level[ch];
+				frames[count].level[ch] = from->level[ch]
+						+ (difference * step) / steps;
+			}
+			count++;
+		}
+	}
+	return count;
+}
+
+/**
+ * @brief Starts playing an animation. A running animation is stopped first.
+ *
+ * @param frames Frames (in flash or RAM), must stay valid while playing.
+ * @param frame_count Number of frames (at most LED_ANIM_MAX_FRAMES).
+ * @param loop 1 to repeat the animation endlessly, 0 to play it once.
+ * @return 0 on success, -1 if the number of frames is not possible.
+ */
+int8_t led_anim_play(const led_anim_frame_t *frames, uint32_t frame_count,
+		uint8_t loop) {
+	if (frame_count == 0 || frame_count > LED_ANIM_MAX_FRAMES) {
+		return -1;
+	}
+
+	led_anim_stop();
+
+	led_anim_dma_handle_struct.Init.Mode = loop ? DMA_CIRCULAR : DMA_NORMAL;
+	HAL_DMA_Init(&led_anim_dma_handle_struct);
+	HAL_DMA_Start(&led_anim_dma_handle_struct, (uint32_t) frames,
+			(uint32_t) &led_anim_timer.handle.Instance->DMAR,
+			frame_count * LED_ANIM_CHANNELS);
+
+	/* From now on every update event requests one burst */
+	__HAL_TIM_ENABLE_DMA(&led_anim_timer.handle, TIM_DMA_UPDATE);
+	return 0;
+}
+
+/**
+ * @brief Stops the animation, the LEDs keep the levels of the current frame.
+ * @param none
+ * @return none
+ */
+void led_anim_stop(void) {
+	__HAL_TIM_DISABLE_DMA(&led_anim_timer.handle, TIM_DMA_UPDATE);
+	HAL_DMA_Abort(&led_anim_dma_handle_struct);
+}
+
+/**
+ * @brief Checks if an animation is playing. An endless animation plays until led_anim_stop().
+ * @param none
+ * @return 1 while frames are transferred, 0 otherwise.
+ */
+uint8_t led_anim_is_playing(void) {
+	return (led_anim_dma_handle_struct.Instance->CR & DMA_SxCR_EN) != 0;
+}
@@ -0,0 +1,47 @@
+/**
+**************************************************
+* @file led_anim.h
+* @author Berkay Özgür, C. Arda Sengenc
+* @version v1.0
+* @date 17.10.2026
+* @brief: Header file for the LED animation module (TIM1 CH1-CH4 with DMA burst).
+**************************************************
+*/
+
+#ifndef LED_ANIM_LED_ANIM_H_
+#define LED_ANIM_LED_ANIM_H_
+
+/* Includes */
+#include <stdint.h>
+
+/* Public preprocessor macros */
+#define LED_ANIM_CHANNELS 4
+/* PWM frequency and steps per PWM period, the levels go from 0 (off) to LED_ANIM_PERIOD (on) */
+#define LED_ANIM_PWM_HZ 1000
+#define LED_ANIM_PERIOD 1000
+/* Level from a percentage, can be used in constant tables */
+#define LED_ANIM_PERCENT(p) ((uint16_t) (((p) * LED_ANIM_PERIOD) / 100))
+/* One frame with the levels of all four channels, can be used in constant tables */
+#define LED_ANIM_FRAME(ch1, ch2, ch3, ch4) { { (ch1), (ch2), (ch3), (ch4) } }
+
+/* Public types */
+/* One frame: compare values for CCR1 ... CCR4, exactly as the DMA burst writes them */
+typedef struct {
+	uint16_t level[LED_ANIM_CHANNELS];
+} led_anim_frame_t;
+
+/* One keyframe for led_anim_build() */
+typedef struct {
+	uint16_t level[LED_ANIM_CHANNELS];	// levels, that are reached at this keyframe
+	uint16_t frames;					// frames of the linear fade from the previous keyframe (at least 1)
+} led_anim_keyframe_t;
+
+/* Public functions (prototypes) */
+void led_anim_init(uint32_t frame_hz);
+uint32_t led_anim_build(const led_anim_keyframe_t *keys, uint16_t key_count,
+		led_anim_frame_t *frames, uint32_t max_frames);
+int8_t led_anim_play(const led_anim_frame_t *frames, uint32_t frame_count, uint8_t loop);
+void led_anim_stop(void);
+uint8_t led_anim_is_playing(void);
+
+#endif /* LED_ANIM_LED_ANIM_H_ */
@@ -9,10 +9,25 @@
 /* Includes */
 
 #include "median.h"
+#include <ema/ema.h>
+#include <timebase/timebase.h>
 
 /* Static module functions (prototypes) */
 
 void median_sort_list(uint32_t *list, uint32_t *srcList, uint16_t length);
+static uint16_t median_find(const uint32_t *list, uint16_t length, uint32_t element);
+
+/* Module variables */
+
+static uint32_t median_default_buffer[MEDIAN_FILTER_BUFFER_SIZE(MEDIAN_BUFFER_LENGTH)];
+static median_filter_t median_default_filter = {
+	median_default_buffer,
+	median_default_buffer + MEDIAN_BUFFER_LENGTH,
+	MEDIAN_BUFFER_LENGTH,
+	0
+};
+// Glättung 1/5 wie bisher (4*lastMedian + median) / 5, aber ohne Division
+static ema_t median_default_ema = { 0, EMA_ALPHA_Q15(1, 5), 0, 0 };
 
 /* Public functions */
 
@@ -39,31 +54,456 @@ void median_sort_list(uint32_t *list, uint32_t *srcList, uint16_t length);
  */
 uint32_t median_get_median(uint32_t newElement)
 {
-	static uint32_t ringBuffer[MEDIAN_BUFFER_LENGTH] = { 0 };	// mit 0,0,0,... initialisieren
-	static uint16_t pos = 0;
-	static uint32_t lastMedian = 0;
-	uint32_t		median;				// Positionszeiger deklarieren
-	uint32_t list[MEDIAN_BUFFER_LENGTH];					// leere Datenstruktur für den sortierten Ring-Puffer
+	uint32_t		median;
 
-	// 1. neues Element in Ring-Puffer einfügen
-	ringBuffer[pos] = newElement;
-	pos = (pos+1) % MEDIAN_BUFFER_LENGTH;	// neuge Zeigerposition berechnen
+	// 1.-3. neues Element in das (mit 0,0,0,... initialisierte) Standard-Fenster
+	//       einsortieren und Median holen
+	median = median_filter_update(&median_default_filter, newElement);
 
-	// 2. Ring-puffer sortieren
-	median_sort_list(list, ringBuffer, MEDIAN_BUFFER_LENGTH);
+	// 4. zusätzlich, leichte Glättung via Mittelwert-Filter (Festkomma-EMA, gerundet)
+	median = ema_update(&median_default_ema, median);
 
-	// 3. Mittleres Element der sortierten Liste (=Median) zurück geben
-	median = list[MEDIAN_BUFFER_LENGTH/2];
+	return median;
+}
 
-	// 4. zusätzlich, leichte Glättung via Mittelwert-Filter
-	median = (4*lastMedian + 1*median) / 5;
-	lastMedian = median;
+/**
+ * @brief  Initialisiert ein Medianfilter-Objekt.
+ *
+ * Jedes zu filternde Signal (Drehzahl, Potis, BME280, ...) bekommt ein eigenes
+ * Objekt, der Speicher wird vom Aufrufer bereitgestellt:
+ *		static uint32_t rpmBuffer[MEDIAN_FILTER_BUFFER_SIZE(5)];
+ *		static median_filter_t rpmFilter;
+ *		median_filter_init(&rpmFilter, rpmBuffer, 5);
+ *
+ * @param  filter:	Zeiger auf das Filter-Objekt.
+ * @param  buffer:	Puffer mit MEDIAN_FILTER_BUFFER_SIZE(length) Elementen.
+ * @param  length:	Fensterlänge, muss ungerade sein.
+ * @retval 0 bei Erfolg, -1 bei gerader Länge oder Länge 0.
+ */
+int8_t median_filter_init(median_filter_t *filter, uint32_t *buffer, uint16_t length)
+{
+	uint16_t i;
 
-	return median;
+	if( (length == 0) || ((length % 2) == 0) )
+	{	// Bei gerader Länge gibt es kein mittleres Element
+		return -1;
+	}
+
+	filter->ringBuffer = buffer;
+	filter->sortedList = buffer + length;
+	filter->length = length;
+	filter->pos = 0;
+
+	// mit 0,0,0,... initialisieren - so bleiben beide Listen gleich und sortiert
+	for(i=0; i<MEDIAN_FILTER_BUFFER_SIZE(length); i++)
+	{
+		buffer[i] = 0;
+	}
+	return 0;
+}
+
+/**
+ * @brief  Fügt einen neuen Wert in das Fenster ein und liefert den Median.
+ *
+ * Anders als median_get_median() wird die Liste nicht jedes Mal neu sortiert.
+ * Das älteste Element wird per binärer Suche in der sortierten Liste gefunden
+ * und in einem einzigen Durchlauf durch das neue ersetzt: die Elemente
+ * dazwischen rücken um eine Stelle nach, bis die Lücke an der richtigen
+ * Position für das neue Element steht. Aufwand O(n) statt O(n^2).
+ *
+ * @param  filter:		Zeiger auf das Filter-Objekt.
+ * @param  newElement:	Neuer Datenwert
+ * @retval Median des Fensters (ohne Glättung).
+ */
+uint32_t median_filter_update(median_filter_t *filter, uint32_t newElement)
+{
+	uint32_t *list = filter->sortedList;
+	uint16_t last = filter->length - 1;
+	uint32_t oldElement;
+	uint16_t i;
+
+	// 1. ältestes Element im Ring-Puffer durch das neue ersetzen
+	oldElement = filter->ringBuffer[filter->pos];
+	filter->ringBuffer[filter->pos] = newElement;
+	filter->pos++;
+	if( filter->pos >= filter->length )
+	{
+		filter->pos = 0;
+	}
+
+	// 2. Position des ältesten Elements in der sortierten Liste suchen
+	i = median_find(list, filter->length, oldElement);
+
+	// 3. Lücke zur Einfügeposition schieben und neues Element einsetzen
+	if( newElement > oldElement )
+	{	// Nachfolger, die kleiner sind, rücken nach vorne
+		while( (i < last) && (list[i+1] < newElement) )
+		{
+			list[i] = list[i+1];
+			i++;
+		}
+	}
+	else
+	{	// Vorgänger, die größer sind, rücken nach hinten
+		while( (i > 0) && (list[i-1] > newElement) )
+		{
+			list[i] = list[i-1];
+			i--;
+		}
+	}
+	list[i] = newElement;
+
+	// 4. Mittleres Element der sortierten Liste (=Median) zurück geben
+	return list[filter->length/2];
+}
+
+/**
+ * @brief  Liefert den aktuellen Median, ohne einen neuen Wert einzufügen.
+ * @param  filter:	Zeiger auf das Filter-Objekt.
+ * @retval Median des Fensters.
+ */
+uint32_t median_filter_get(const median_filter_t *filter)
+{
+	return filter->sortedList[filter->length/2];
+}
+
+/**
+ * @brief  Median einer beliebigen Liste, ohne Ring-Puffer.
+ *
+ * Für 3, 5, 7 und 9 Elemente werden die Sortiernetzwerke aus median.h benutzt,
+ * alle anderen Längen (bis MEDIAN_KERNEL_MAX_LENGTH) werden auf einer Kopie per
+ * Insertion-Sort bis zur Mitte sortiert.
+ *
+ * @param  values:	Zeiger auf die Werte, bleiben unverändert.
+ * @param  length:	Anzahl der Werte, 1 bis MEDIAN_KERNEL_MAX_LENGTH (ungerade, sonst oberer Median).
+ * @param  median:	Ziel für den Median, wird bei einem Fehler nicht verändert.
+ * @retval 0 bei Erfolg, -1 bei Länge 0 oder größer als MEDIAN_KERNEL_MAX_LENGTH.
+ */
+int8_t median_kernel(const uint32_t *values, uint16_t length, uint32_t *median)
+{
+	uint32_t list[MEDIAN_KERNEL_MAX_LENGTH];
+	uint32_t tmp;
+	uint16_t i, j;
+
+	switch(length)
+	{
+	case 1:
+		*median = values[0];
+		return 0;
+	case 3:
+		*median = median_kernel_3(values);
+		return 0;
+	case 5:
+		*median = median_kernel_5(values);
+		return 0;
+	case 7:
+		*median = median_kernel_7(values);
+		return 0;
+	case 9:
+		*median = median_kernel_9(values);
+		return 0;
+	default:
+		break;
+	}
+
+	if( (length == 0) || (length > MEDIAN_KERNEL_MAX_LENGTH) )
+	{	// ohne Werte gibt es keinen Median, längere Listen passen nicht in die Kopie
+		return -1;
+	}
+
+	// Insertion-Sort auf einer Kopie
+	for(j=0; j<length; j++)
+	{
+		tmp = values[j];
+		i = j;
+		while( (i > 0) && (list[i-1] > tmp) )
+		{
+			list[i] = list[i-1];
+			i--;
+		}
+		list[i] = tmp;
+	}
+	*median = list[length/2];
+	return 0;
+}
+
+/**
+ * @brief  Laufender Median über einen ganzen Block, z.B. eine fertige DMA-Puffer-Hälfte.
+ *
+ * Der Median wird nur an den Ausgabe-Positionen berechnet (jeder decimation-te
+ * Wert), dadurch kostet die Filterung pro Eingangswert nur einen Bruchteil eines
+ * Median-Kernels. Bsp: window = 5, decimation = 5 -> ein Sortiernetzwerk mit
+ * 7 Compare-Exchanges je 5 Werte.
+ *
+ * @param  src:			Zeiger auf den ersten Wert des Kanals.
+ * @param  count:		Anzahl der Werte dieses Kanals im Block.
+ * @param  stride:		Abstand zweier Werte im Speicher (2 bei zwei verschachtelten Kanälen).
+ * @param  window:		Fensterlänge (ungerade, 1 bis MEDIAN_KERNEL_MAX_LENGTH).
+ * @param  decimation:	nur jeder decimation-te Median wird ausgegeben.
+ * @param  dst:			Ziel für (count - window) / decimation + 1 Werte.
+ * @retval Anzahl der ausgegebenen Werte, 0 bei ungültigem Fenster.
+ */
+uint16_t median_block_running(const uint32_t *src, uint16_t count, uint16_t stride,
+		uint16_t window, uint16_t decimation, uint32_t *dst)
+{
+	uint32_t list[MEDIAN_KERNEL_MAX_LENGTH];
+	uint16_t i, j;
+	uint16_t n = 0;
+
+	if( (window == 0) || (window > count) || (window > MEDIAN_KERNEL_MAX_LENGTH) || (decimation == 0) )
+	{
+		return 0;
+	}
+
+	for(i=0; i+window <= count; i += decimation)
+	{
+		// Fenster aus dem verschachtelten Puffer einsammeln
+		for(j=0; j<window; j++)
+		{
+			list[j] = src[(i+j)*stride];
+		}
+		(void)median_kernel(list, window, &dst[n++]);	// Fenster ist oben geprüft
+	}
+	return n;
+}
+
+/**
+ * @brief  Hampel-Filter: ersetzt Ausreißer durch den Median ihrer Umgebung.
+ *
+ * Für jeden Wert wird im umgebenden Fenster der Median m und die mittlere
+ * absolute Abweichung MAD = median(|x - m|) bestimmt. Liegt der Wert weiter als
+ * k * 1.4826 * MAD vom Median entfernt, gilt er als Ausreißer.
+ * Am Rand des Blocks wird das Fenster in den Block hinein verschoben.
+ *
+ * @param  src:			Zeiger auf den ersten Wert des Kanals.
+ * @param  count:		Anzahl der Werte dieses Kanals im Block.
+ * @param  stride:		Abstand zweier Werte im Speicher.
+ * @param  window:		Fensterlänge (ungerade, 1 bis MEDIAN_KERNEL_MAX_LENGTH).
+ * @param  thresholdQ8:	Schwelle k in Q8, z.B. MEDIAN_HAMPEL_K3.
+ * @param  dst:			Ziel für count bereinigte Werte (dicht gepackt).
+ * @retval Anzahl der ersetzten Ausreißer.
+ */
+uint16_t median_block_hampel(const uint32_t *src, uint16_t count, uint16_t stride,
+		uint16_t window, uint16_t thresholdQ8, uint32_t *dst)
+{
+	uint32_t list[MEDIAN_KERNEL_MAX_LENGTH];
+	uint32_t median, mad, diff, x;
+	uint16_t i, j, start;
+	uint16_t outliers = 0;
+
+	if( (window == 0) || (window > count) || (window > MEDIAN_KERNEL_MAX_LENGTH) )
+	{
+		window = 1;	// kein sinnvolles Fenster -> Werte nur kopieren
+	}
+
+	for(i=0; i<count; i++)
+	{
+		x = src[i*stride];
+
+		// Fenster um i, am Rand in den Block hinein verschoben
+		start = (i > window/2) ? (i - window/2) : 0;
+		if( start + window > count )
+		{
+			start = count - window;
+		}
+
+		for(j=0; j<window; j++)
+		{
+			list[j] = src[(start+j)*stride];
+		}
+		(void)median_kernel(list, window, &median);	// Fenster ist oben geprüft
+
+		for(j=0; j<window; j++)
+		{
+			list[j] = (list[j] > median) ? (list[j] - median) : (median - list[j]);
+		}
+		(void)median_kernel(list, window, &mad);
+
+		// 1.4826 ~ 380/256, Schwelle = k * 1.4826 * MAD (Q8 * Q8 -> >> 16),
+		// in 64 Bit, da MAD * 380 * k schon ab MAD ~ 15000 (k = 3) nicht mehr in 32 Bit passt
+		diff = (x > median) ? (x - median) : (median - x);
+		if( diff > (((uint64_t)mad * 380 * thresholdQ8) >> 16) )
+		{
+			x = median;
+			outliers++;
+		}
+		dst[i] = x;
+	}
+	return outliers;
+}
+
+/**
+ * @brief  Getrimmter Mittelwert: Mittelwert ohne die trim kleinsten und trim größten Werte.
+ *
+ * Die Liste wird nicht sortiert, es werden nur die trim kleinsten und größten
+ * Werte mitgeführt (Aufwand O(count * trim)).
+ *
+ * @param  src:		Zeiger auf den ersten Wert des Kanals.
+ * @param  count:	Anzahl der Werte dieses Kanals im Block.
+ * @param  stride:	Abstand zweier Werte im Speicher.
+ * @param  trim:	Anzahl der verworfenen Werte je Seite (max. MEDIAN_TRIM_MAX).
+ * @retval getrimmter Mittelwert.
+ */
+uint32_t median_block_trimmed_mean(const uint32_t *src, uint16_t count, uint16_t stride,
+		uint16_t trim)
+{
+	uint32_t lowest[MEDIAN_TRIM_MAX];	// aufsteigend, lowest[trim-1] ist der größte davon
+	uint32_t highest[MEDIAN_TRIM_MAX];	// absteigend, highest[trim-1] ist der kleinste davon
+	uint64_t sum = 0;	// 32 Bit laufen schon bei wenigen großen Werten über
+	uint32_t x;
+	uint16_t i, j;
+
+	if( trim > MEDIAN_TRIM_MAX )
+	{
+		trim = MEDIAN_TRIM_MAX;
+	}
+	if( (count == 0) || (2*trim >= count) )
+	{
+		trim = 0;
+	}
+	if( count == 0 )
+	{
+		return 0;
+	}
+
+	for(j=0; j<trim; j++)
+	{
+		lowest[j] = 0xFFFFFFFF;
+		highest[j] = 0;
+	}
+
+	for(i=0; i<count; i++)
+	{
+		x = src[i*stride];
+		sum += x;
+
+		if( (trim > 0) && (x < lowest[trim-1]) )
+		{	// in die Liste der kleinsten Werte einsortieren
+			j = trim - 1;
+			while( (j > 0) && (lowest[j-1] > x) )
+			{
+				lowest[j] = lowest[j-1];
+				j--;
+			}
+			lowest[j] = x;
+		}
+		if( (trim > 0) && (x > highest[trim-1]) )
+		{	// in die Liste der größten Werte einsortieren
+			j = trim - 1;
+			while( (j > 0) && (highest[j-1] < x) )
+			{
+				highest[j] = highest[j-1];
+				j--;
+			}
+			highest[j] = x;
+		}
+	}
+
+	for(j=0; j<trim; j++)
+	{
+		sum -= lowest[j] + highest[j];
+	}
+	return (uint32_t)(sum / (count - 2*trim));
+}
+
+/**
+ * @brief  Vergleicht den alten Bubble-Sort mit dem sortierten Fenster und dem Sortiernetzwerk.
+ *
+ * Alle Verfahren filtern dieselbe Pseudo-Zufallsfolge mit
+ * MEDIAN_BUFFER_LENGTH Elementen, gemessen wird mit dem DWT-Zykluszähler.
+ * Die Ergebnisse lassen sich z.B. im Debugger ablesen.
+ *
+ * @param  samples:				Anzahl der gefilterten Werte.
+ * @param  cyclesBubbleSort:	Zyklen für alle Werte mit median_sort_list().
+ * @param  cyclesSortedWindow:	Zyklen für alle Werte mit median_filter_update().
+ * @param  cyclesNetwork:		Zyklen für alle Werte mit median_kernel_fixed().
+ * @retval None
+ */
+void median_benchmark(uint16_t samples, uint32_t *cyclesBubbleSort, uint32_t *cyclesSortedWindow,
+		uint32_t *cyclesNetwork)
+{
+	uint32_t ringBuffer[MEDIAN_BUFFER_LENGTH] = { 0 };
+	uint32_t list[MEDIAN_BUFFER_LENGTH];
+	uint32_t buffer[MEDIAN_FILTER_BUFFER_SIZE(MEDIAN_BUFFER_LENGTH)];
+	median_filter_t filter;
+	volatile uint32_t median;	// damit der Compiler nichts wegoptimiert
+	uint32_t seed, start;
+	uint16_t pos = 0;
+	uint16_t n;
+
+	// DWT-Zykluszähler einschalten
+	timebase_init();
+
+	// 1. bisheriges Verfahren: Ring-Puffer kopieren und komplett sortieren
+	seed = 12345;
+	start = timebase_now_cycles();
+	for(n=0; n<samples; n++)
+	{
+		seed = seed*1103515245 + 12345;
+		ringBuffer[pos] = (seed >> 16) & 0x0FFF;
+		pos = (pos+1) % MEDIAN_BUFFER_LENGTH;
+		median_sort_list(list, ringBuffer, MEDIAN_BUFFER_LENGTH);
+		median = list[MEDIAN_BUFFER_LENGTH/2];
+	}
+	*cyclesBubbleSort = timebase_now_cycles() - start;
+
+	// 2. sortiertes Fenster mit derselben Folge
+	median_filter_init(&filter, buffer, MEDIAN_BUFFER_LENGTH);
+	seed = 12345;
+	start = timebase_now_cycles();
+	for(n=0; n<samples; n++)
+	{
+		seed = seed*1103515245 + 12345;
+		median = median_filter_update(&filter, (seed >> 16) & 0x0FFF);
+	}
+	*cyclesSortedWindow = timebase_now_cycles() - start;
+
+	// 3. Sortiernetzwerk direkt auf dem Ring-Puffer
+	seed = 12345;
+	pos = 0;
+	start = timebase_now_cycles();
+	for(n=0; n<samples; n++)
+	{
+		seed = seed*1103515245 + 12345;
+		ringBuffer[pos] = (seed >> 16) & 0x0FFF;
+		pos = (pos+1) % MEDIAN_BUFFER_LENGTH;
+		median = median_kernel_fixed(ringBuffer);
+	}
+	*cyclesNetwork = timebase_now_cycles() - start;
+
+	(void)median;
 }
 
 /* Static module functions (implementation) */
 
+/**
+ * @brief  Binäre Suche in einer aufsteigend sortierten Liste.
+ * @param  list:	Zeiger auf die sortierte Liste.
+ * @param  length:	Länge der Liste.
+ * @param  element:	gesuchtes Element, muss in der Liste enthalten sein.
+ * @retval Index des Elements.
+ */
+static uint16_t median_find(const uint32_t *list, uint16_t length, uint32_t element)
+{
+	uint16_t low = 0;
+	uint16_t high = length - 1;
+	uint16_t mid;
+
+	while( low < high )
+	{
+		mid = (low + high) / 2;
+		if( list[mid] < element )
+		{
+			low = mid + 1;
+		}
+		else
+		{
+			high = mid;
+		}
+	}
+	return low;
+}
+
 /**
  * @brief  Sortieralgorithmus zur Sortierung einer ungeordneten Liste.
  * @param  list:	 Zeiger auf Ziel-Liste.
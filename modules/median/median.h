@@ -10,14 +10,140 @@
 
 /* Includes */
 
-#include "stm32f4xx.h"
+#include <stdint.h>
 
 /* Public Preprocessor defines */
 
 #define MEDIAN_BUFFER_LENGTH	9
 
+/* Größe des Puffers (in Elementen), den median_filter_init() für ein Fenster der Länge len braucht */
+#define MEDIAN_FILTER_BUFFER_SIZE(len)	(2*(len))
+
+/* Größte Fensterlänge für median_kernel() außerhalb der festen Netzwerke */
+#define MEDIAN_KERNEL_MAX_LENGTH	31
+
+/* Größte Anzahl an Werten, die median_block_trimmed_mean() pro Seite verwirft */
+#define MEDIAN_TRIM_MAX			8
+
+/* Hampel-Schwelle k = 3 in Q8, üblicher Standardwert */
+#define MEDIAN_HAMPEL_K3		(3*256)
+
+/*
+ * Compare-Exchange für die Sortiernetzwerke: danach gilt a <= b.
+ * Der ternäre Operator wird auf dem Cortex-M4 ohne Sprung übersetzt
+ * (CMP + IT-Block), die Laufzeit hängt also nicht von den Daten ab.
+ */
+#define MEDIAN_MIN(a, b)		((a) < (b) ? (a) : (b))
+#define MEDIAN_MAX(a, b)		((a) < (b) ? (b) : (a))
+#define MEDIAN_SORT2(a, b)		do { uint32_t t_ = MEDIAN_MIN(a, b); (b) = MEDIAN_MAX(a, b); (a) = t_; } while(0)
+
+/* Public types */
+
+/* Ein Medianfilter-Objekt, jedes Signal bekommt sein eigenes */
+typedef struct {
+	uint32_t *ringBuffer;	// Werte in Einfüge-Reihenfolge
+	uint32_t *sortedList;	// dieselben Werte, aufsteigend sortiert
+	uint16_t length;		// Fensterlänge (ungerade)
+	uint16_t pos;			// nächste Schreibposition im Ring-Puffer
+} median_filter_t;
+
+/* Public inline functions */
+
+/*
+ * Median-Kernel für feste Fensterlängen (Sortiernetzwerke nach N. Devillard,
+ * "Fast median search: an ANSI C implementation"). Es werden nur so viele
+ * Compare-Exchanges ausgeführt, wie für das mittlere Element nötig sind.
+ * Die Werte werden in lokale Variablen (Register) kopiert, die Quelle bleibt unverändert.
+ */
+
+static inline uint32_t median_kernel_3(const uint32_t *p)
+{
+	uint32_t p0 = p[0], p1 = p[1], p2 = p[2];
+
+	// max(min(a,b), min(max(a,b),c)) = 3 Vergleiche
+	return MEDIAN_MAX(MEDIAN_MIN(p0, p1), MEDIAN_MIN(MEDIAN_MAX(p0, p1), p2));
+}
+
+static inline uint32_t median_kernel_5(const uint32_t *p)
+{
+	uint32_t p0 = p[0], p1 = p[1], p2 = p[2], p3 = p[3], p4 = p[4];
+
+	MEDIAN_SORT2(p0, p1); MEDIAN_SORT2(p3, p4); MEDIAN_SORT2(p0, p3);
+	MEDIAN_SORT2(p1, p4); MEDIAN_SORT2(p1, p2); MEDIAN_SORT2(p2, p3);
+	MEDIAN_SORT2(p1, p2);
+	(void)p0; (void)p4;
+	return p2;
+}
+
+static inline uint32_t median_kernel_7(const uint32_t *p)
+{
+	uint32_t p0 = p[0], p1 = p[1], p2 = p[2], p3 = p[3], p4 = p[4], p5 = p[5], p6 = p[6];
+
+	MEDIAN_SORT2(p0, p5); MEDIAN_SORT2(p0, p3); MEDIAN_SORT2(p1, p6);
+	MEDIAN_SORT2(p2, p4); MEDIAN_SORT2(p0, p1); MEDIAN_SORT2(p3, p5);
+	MEDIAN_SORT2(p2, p6); MEDIAN_SORT2(p2, p3); MEDIAN_SORT2(p3, p6);
+	MEDIAN_SORT2(p4, p5); MEDIAN_SORT2(p1, p4); MEDIAN_SORT2(p1, p3);
+	MEDIAN_SORT2(p3, p4);
+	(void)p0; (void)p5; (void)p6;
+	return p3;
+}
+
+static inline uint32_t median_kernel_9(const uint32_t *p)
+{
+	uint32_t p0 = p[0], p1 = p[1], p2 = p[2], p3 = p[3], p4 = p[4];
+	uint32_t p5 = p[5], p6 = p[6], p7 = p[7], p8 = p[8];
+
+	MEDIAN_SORT2(p1, p2); MEDIAN_SORT2(p4, p5); MEDIAN_SORT2(p7, p8);
+	MEDIAN_SORT2(p0, p1); MEDIAN_SORT2(p3, p4); MEDIAN_SORT2(p6, p7);
+	MEDIAN_SORT2(p1, p2); MEDIAN_SORT2(p4, p5); MEDIAN_SORT2(p7, p8);
+	MEDIAN_SORT2(p0, p3); MEDIAN_SORT2(p5, p8); MEDIAN_SORT2(p4, p7);
+	MEDIAN_SORT2(p3, p6); MEDIAN_SORT2(p1, p4); MEDIAN_SORT2(p2, p5);
+	MEDIAN_SORT2(p4, p7); MEDIAN_SORT2(p4, p2); MEDIAN_SORT2(p6, p4);
+	MEDIAN_SORT2(p4, p2);
+	(void)p0; (void)p8;
+	return p4;
+}
+
+/* Kernel passend zu MEDIAN_BUFFER_LENGTH, wird zur Compile-Zeit ausgewählt */
+#if MEDIAN_BUFFER_LENGTH == 3
+#define median_kernel_fixed(p)	median_kernel_3(p)
+#elif MEDIAN_BUFFER_LENGTH == 5
+#define median_kernel_fixed(p)	median_kernel_5(p)
+#elif MEDIAN_BUFFER_LENGTH == 7
+#define median_kernel_fixed(p)	median_kernel_7(p)
+#elif MEDIAN_BUFFER_LENGTH == 9
+#define median_kernel_fixed(p)	median_kernel_9(p)
+#endif
+
 /* Public functions (prototypes) */
 
 uint32_t median_get_median(uint32_t newElement);
 
+int8_t median_filter_init(median_filter_t *filter, uint32_t *buffer, uint16_t length);
+uint32_t median_filter_update(median_filter_t *filter, uint32_t newElement);
+uint32_t median_filter_get(const median_filter_t *filter);
+
+int8_t median_kernel(const uint32_t *values, uint16_t length, uint32_t *median);
+
+#if (MEDIAN_BUFFER_LENGTH != 3) && (MEDIAN_BUFFER_LENGTH != 5) && (MEDIAN_BUFFER_LENGTH != 7) && (MEDIAN_BUFFER_LENGTH != 9)
+/* Andere Längen: allgemeiner Kernel, MEDIAN_BUFFER_LENGTH muss <= MEDIAN_KERNEL_MAX_LENGTH sein */
+static inline uint32_t median_kernel_fixed(const uint32_t *p)
+{
+	uint32_t median = 0;
+
+	(void)median_kernel(p, MEDIAN_BUFFER_LENGTH, &median);
+	return median;
+}
+#endif
+
+uint16_t median_block_running(const uint32_t *src, uint16_t count, uint16_t stride,
+		uint16_t window, uint16_t decimation, uint32_t *dst);
+uint16_t median_block_hampel(const uint32_t *src, uint16_t count, uint16_t stride,
+		uint16_t window, uint16_t thresholdQ8, uint32_t *dst);
+uint32_t median_block_trimmed_mean(const uint32_t *src, uint16_t count, uint16_t stride,
+		uint16_t trim);
+
+void median_benchmark(uint16_t samples, uint32_t *cyclesBubbleSort, uint32_t *cyclesSortedWindow,
+		uint32_t *cyclesNetwork);
+
 #endif /* MEDIAN_MEDIAN_H_ */
@@ -23,6 +23,9 @@ No Input | Output Channel has been used. LCD Screen is embedded on the chip.
 
 (#) Call "my_lcd_draw_x" Use it to draw a cross with the dimensions 100x100 pixels
 
+(#) Call "my_lcd_draw_digit()" to draw a large seven segment digit. With the previously
+	drawn digit only the segments, that have changed, are sent to the display.
+
 
 @endverbatim
 **************************************************
@@ -33,6 +36,46 @@ No Input | Output Channel has been used. LCD Screen is embedded on the chip.
 #include "stm32f4xx.h"
 #include "my_lcd.h"
 #include <stdio.h>
+#include <timebase/timebase.h>
+
+/* Preprocessor macros */
+/* Line width of the segments */
+#define MY_LCD_SEGMENT_WIDTH 4
+#define MY_LCD_SEGMENT_LENGTH (MY_LCD_DIGIT_WIDTH - 2 * MY_LCD_SEGMENT_WIDTH)
+#define MY_LCD_SEGMENT_HALF ((MY_LCD_DIGIT_HEIGHT - 3 * MY_LCD_SEGMENT_WIDTH) / 2)
+
+/* Module types */
+/* One segment as rectangle relative to the upper left corner of the digit */
+typedef struct {
+	uint8_t x;
+	uint8_t y;
+	uint8_t width;
+	uint8_t height;
+} my_lcd_segment_t;
+
+/* Module variables */
+/* Segments a ... g, every segment is one rectangle, so it is one burst to the display */
+static const my_lcd_segment_t my_lcd_segments[7] = {
+	/* a: top */
+	{ MY_LCD_SEGMENT_WIDTH, 0, MY_LCD_SEGMENT_LENGTH, MY_LCD_SEGMENT_WIDTH },
+	/* b: top right */
+	{ MY_LCD_DIGIT_WIDTH - MY_LCD_SEGMENT_WIDTH, MY_LCD_SEGMENT_WIDTH, MY_LCD_SEGMENT_WIDTH, MY_LCD_SEGMENT_HALF },
+	/* c: bottom right */
+	{ MY_LCD_DIGIT_WIDTH - MY_LCD_SEGMENT_WIDTH, 2 * MY_LCD_SEGMENT_WIDTH + MY_LCD_SEGMENT_HALF, MY_LCD_SEGMENT_WIDTH, MY_LCD_SEGMENT_HALF },
+	/* d: bottom */
+	{ MY_LCD_SEGMENT_WIDTH, MY_LCD_DIGIT_HEIGHT - MY_LCD_SEGMENT_WIDTH, MY_LCD_SEGMENT_LENGTH, MY_LCD_SEGMENT_WIDTH },
+	/* e: bottom left */
+	{ 0, 2 * MY_LCD_SEGMENT_WIDTH + MY_LCD_SEGMENT_HALF, MY_LCD_SEGMENT_WIDTH, MY_LCD_SEGMENT_HALF },
+	/* f: top left */
+	{ 0, MY_LCD_SEGMENT_WIDTH, MY_LCD_SEGMENT_WIDTH, MY_LCD_SEGMENT_HALF },
+	/* g: middle */
+	{ MY_LCD_SEGMENT_WIDTH, MY_LCD_SEGMENT_WIDTH + MY_LCD_SEGMENT_HALF, MY_LCD_SEGMENT_LENGTH, MY_LCD_SEGMENT_WIDTH },
+};
+
+/* Segments of the digits 0 ... 9 and MY_LCD_DIGIT_BLANK, bit 0 is segment a */
+static const uint8_t my_lcd_digit_segments[11] = {
+	0x3F, 0x06, 0x5B, 0x4F, 0x66, 0x6D, 0x7D, 0x07, 0x7F, 0x6F, 0x00,
+};
 
 /**
   * @brief Function for counting down from 10 to 0 and display it to LCD screen that embedded on the chip.
@@ -45,7 +88,7 @@ void my_lcd_countdown(int input) {
 		lcd_fill_screen(WHITE);
 		sprintf(buffer, "Zahl = %3d", i);
 		lcd_draw_text_at_line(buffer, 4, BLACK, 2, WHITE);
-		HAL_Delay(800);
+		timebase_sleep_ms(800);
 	}
 }
 
@@ -133,3 +176,54 @@ void my_lcd_draw_x(int size) {
 	}
 }
 
+
+/**
+  * @brief Draws a seven segment digit (MY_LCD_DIGIT_WIDTH x MY_LCD_DIGIT_HEIGHT pixels).
+  * Only the segments, that differ from the previous digit, are drawn: switched on segments
+  * with the color, switched off ones with the background color.
+  * @param x, y Upper left corner of the digit.
+  * @param digit 0 ... 9 or MY_LCD_DIGIT_BLANK.
+  * @param previous Digit, that is on the display at this place, MY_LCD_DIGIT_NONE if unknown.
+  * @param color Color of the segments.
+  * @param bgcolor Background color.
+  * @return none
+  */
+void my_lcd_draw_digit(uint16_t x, uint16_t y, uint8_t digit, uint8_t previous,
+		uint16_t color, uint16_t bgcolor) {
+	uint8_t segments;
+	uint8_t changed;
+
+	if (digit > MY_LCD_DIGIT_BLANK) {
+		digit = MY_LCD_DIGIT_BLANK;
+	}
+	segments = my_lcd_digit_segments[digit];
+
+	if (previous > MY_LCD_DIGIT_BLANK) {
+		/* Unknown content: every segment has to be drawn */
+		changed = 0x7F;
+	} else {
+		changed = segments ^ my_lcd_digit_segments[previous];
+	}
+
+	for (uint8_t i = 0; i < 7; i++) {
+		if (changed & (1 << i)) {
+			ILI9341_Draw_Rectangle(x + my_lcd_segments[i].x, y + my_lcd_segments[i].y,
+					my_lcd_segments[i].width, my_lcd_segments[i].height,
+					(segments & (1 << i)) ? color : bgcolor);
+		}
+	}
+}
+
+/**
+  * @brief Draws a colon for the seven segment digits, it is MY_LCD_SEGMENT_WIDTH pixels wide
+  * and MY_LCD_DIGIT_HEIGHT pixels high.
+  * @param x, y Upper left corner.
+  * @param color Color of the dots.
+  * @return none
+  */
+void my_lcd_draw_colon(uint16_t x, uint16_t y, uint16_t color) {
+	ILI9341_Draw_Rectangle(x, y + MY_LCD_DIGIT_HEIGHT / 4, MY_LCD_SEGMENT_WIDTH,
+			MY_LCD_SEGMENT_WIDTH, color);
+	ILI9341_Draw_Rectangle(x, y + (3 * MY_LCD_DIGIT_HEIGHT) / 4 - MY_LCD_SEGMENT_WIDTH,
+			MY_LCD_SEGMENT_WIDTH, MY_LCD_SEGMENT_WIDTH, color);
+}
@@ -11,10 +11,24 @@
 #ifndef MY_LCD_MY_LCD_H_
 #define MY_LCD_MY_LCD_H_
 
+/* Includes */
+#include <stdint.h>
+
+/* Public preprocessor macros */
+/* Size of a seven segment digit of my_lcd_draw_digit() in pixels */
+#define MY_LCD_DIGIT_WIDTH 20
+#define MY_LCD_DIGIT_HEIGHT 36
+/* Digit without segments */
+#define MY_LCD_DIGIT_BLANK 10
+/* Previous digit unknown, all segments are drawn */
+#define MY_LCD_DIGIT_NONE 0xFF
+
 /* Public functions (prototypes) */
 void my_lcd_countdown(int input);
 void my_lcd_draw_baargraph(uint16_t x, uint16_t y, uint16_t width, uint16_t height, uint16_t value, uint16_t color, uint16_t bgcolor);
 void my_lcd_draw_x(int size);
+void my_lcd_draw_digit(uint16_t x, uint16_t y, uint8_t digit, uint8_t previous, uint16_t color, uint16_t bgcolor);
+void my_lcd_draw_colon(uint16_t x, uint16_t y, uint16_t color);
 
 
 #endif /* MY_LCD_MY_LCD_H_ */
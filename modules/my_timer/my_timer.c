@@ -2,7 +2,7 @@
  **************************************************
  * @file my_timer.c
  * @author Berkay Özgür, C. Arda Sengenc
- * @version v1.0
+ * @version v1.1
  * @date 19.06.2023
  * @brief: Helper module for initialising and using timers.
  ******************************************************************************
@@ -10,30 +10,47 @@
  * ### Description ###
  * This file contains the implementation of a timer control module, which provides
  * functions for initializing and configuring timers, enabling interrupts, setting
- * compare values, starting timers, and retrieving timer handle structures. It also
- * includes functions for initializing and configuring timer output compare channels.
+ * compare values and starting timers. It also includes functions for initializing
+ * and configuring timer output compare channels.
  *
  * @note This file depends on the HAL library and the HAL_TIM module.
- * The my_timer_handle_struct and my_timer_oc_handle_struct variables are used internally
- * for storing the timer handle and output compare handle structures, respectively.
+ * The module has no state of its own. Every user owns a my_timer_t, which holds the
+ * HAL timer handle, the output compare configuration and the input clock of the timer,
+ * so several modules can use different timers at the same time.
+ *
+ * All timers of the STM32F429 are supported (TIM1 - TIM14). The input clock is read from
+ * RCC: timers on APB1 (TIM2-7, TIM12-14) run at PCLK1, timers on APB2 (TIM1, TIM8-11) at
+ * PCLK2, both times two if the APB prescaler is not 1 (times four with TIMPRE).
  *
  * ### Usage ###
  *
- * (#) Call "my_timer_init()" to initialize the timer and set the desired parameters.
+ * (#) Declare a "my_timer_t" for each timer, e.g. "my_timer_t dot_control_timer;".
+ *
+ * (#) Call "my_timer_init()" to initialize the timer with the desired counter frequency and period.
  *
  * (#) Call "my_timer_enable_interrupt()" to enable interrupts for the timer.
  *
  * (#) Call "my_timer_oc_init()" to initialize and configure the output compare channel.
  *
+ * (#) Call "my_timer_ic_init()" to configure an input capture channel (timer initialized with
+ * TIMER_MODE_IC), then start it with the HAL, e.g. "HAL_TIM_IC_Start_DMA(&timer.handle, ...)".
+ *
  * (#) Call "my_timer_start()" to start the timer in the desired mode and channel.
  *
  * (#) Call "my_timer_set_prescaler()" to set the prescaler value for the timer.
  *
  * (#) Call "my_timer_set_compare()" to set the compare value for the timer channel.
  *
- * (#) Call "my_timer_get_struct()" to retrieve the timer handle structure.
+ * (#) Call "my_timer_get_tick_hz()" or "my_timer_get_frequency_mhz()" to get the frequency,
+ * that the timer actually runs at (the prescaler is an integer, so it can differ from the requested one).
  *
- * (#) Call "my_timer_get_oc_struct()" to retrieve the output compare handle structure.
+ * (#) Call "my_timer_solve()" to find the prescaler and period for a frequency, e.g. once at init
+ * for a lookup table. Call "my_timer_enable_preload()" once, then change the frequency with
+ * "my_timer_begin_update()", "my_timer_apply()", "my_timer_set_compare()", "my_timer_end_update()".
+ * With preload all new values are taken over together at the next update event, so the running
+ * period is never cut short or stretched (no glitches).
+ *
+ * (#) Use "timer.handle" for all other HAL functions (e.g. in the IRQ handler).
  *
  * @endverbatim
  ******************************************************************************
@@ -43,117 +60,72 @@
 #include "stm32f4xx.h"
 #include <my_timer.h>
 
-/* Module variables */
-TIM_HandleTypeDef my_timer_handle_struct;
-TIM_OC_InitTypeDef my_timer_oc_handle_struct;
+/* Module functions (prototypes) */
+static void my_timer_enable_clock(TIM_TypeDef *instance);
 
 /**
  * @brief Initializes a timer with the specified parameters.
  *
  * This function initializes a timer with the specified parameters by performing the following steps:
- * - Calls HAL_Init() to initialize the HAL library.
- * - Configures the timer instance, clock source, prescaler, period, counter mode, clock division, auto-reload preload,
- *   and repetition counter based on the provided parameters.
- * - Enables the clock for the corresponding timer instance (TIM1, TIM2, or TIM3).
- * - Initializes the timer with the configured handle structure using either HAL_TIM_Base_Init() or HAL_TIM_PWM_Init()
- *   depending on the specified mode.
- *
- * @param instance The timer instance to be initialized (TIMER_INSTANCE_1, TIMER_INSTANCE_2, or TIMER_INSTANCE_3).
- * @param mode The mode of operation for the timer (TIMER_MODE_BASE or TIMER_MODE_PWM).
- * @param prescaler The prescaler value to divide the timer clock.
- * @param period The period value to determine the time before the timer resets.
+ * - Enables the clock for the timer instance and reads its input clock from RCC.
+ * - Calculates the prescaler for the requested counter frequency (rounded to the nearest possible one).
+ * - Configures the timer instance, prescaler, period, counter mode, clock division, auto-reload preload,
+ *   and repetition counter.
+ * - Initializes the timer with HAL_TIM_Base_Init(), HAL_TIM_PWM_Init() or HAL_TIM_IC_Init() depending on the specified mode.
+ *
+ * @param timer The timer to be initialized.
+ * @param instance The timer instance (TIM1 - TIM14).
+ * @param mode The mode of operation for the timer (TIMER_MODE_BASE, TIMER_MODE_PWM or TIMER_MODE_IC).
+ * @param tick_hz The frequency the counter should count with, e.g. 10000 for 10 kHz.
+ * @param period The number of ticks before the timer resets (at most 65536, 2^32 for TIM2 and TIM5),
+ *        0 for the full range of the counter (e.g. free-running for input capture).
  *
  * @return None
  */
-void my_timer_init(timer_instance instance, timer_mode mode, uint32_t prescaler,
-		uint32_t period) {
+void my_timer_init(my_timer_t *timer, TIM_TypeDef *instance, timer_mode mode,
+		uint32_t tick_hz, uint32_t period) {
+	uint32_t prescaler;
 
-	// Initialize the HAL library.
-	HAL_Init();
-	switch (instance) {
-	case TIMER_INSTANCE_1:
-		__HAL_RCC_TIM1_CLK_ENABLE();
-		my_timer_handle_struct.Instance = TIM1;
-
-		/* Upper defined prescaler will be assigned here. */
-		my_timer_handle_struct.Init.Prescaler = (SystemCoreClock / prescaler)
-				- 1;
-		/**
-		 * This allows you to set the value to which the timer will count. (how much time elapses)
-		 * before it is reset and starts again from the beginning. Assuming that the prescaler has been
-		 * set as described above so that the timer is supplied with a 10 kHz clock, a setting of Period = 9999
-		 * (i.e. 10000-1) would cause the counter to always count from 0-9999 and then reset to 0.
-		 */
-		my_timer_handle_struct.Init.Period = period - 1;
-
-		/* Counter mode is assigned to count up */
-		my_timer_handle_struct.Init.CounterMode = TIM_COUNTERMODE_UP;
-		my_timer_handle_struct.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
-		my_timer_handle_struct.Init.AutoReloadPreload =
-		TIM_AUTORELOAD_PRELOAD_DISABLE;
-		/* Here you specify after how many overflows an event should be generated */
-		my_timer_handle_struct.Init.RepetitionCounter = 0;
-		break;
+	my_timer_enable_clock(instance);
+	timer->clock = my_timer_get_clock(instance);
 
-	case TIMER_INSTANCE_2:
-		/* Clock for Timer2 */
-		__HAL_RCC_TIM2_CLK_ENABLE();
-		my_timer_handle_struct.Instance = TIM2;
-
-		/* Upper defined prescaler will be assigned here. */
-		/* Timer2 has a different maximum clock, so it must be divided by two again. */
-		my_timer_handle_struct.Init.Prescaler =
-				(SystemCoreClock / 2 / prescaler) - 1;
-		/**
-		 * This allows you to set the value to which the timer will count. (how much time elapses)
-		 * before it is reset and starts again from the beginning. Assuming that the prescaler has been
-		 * set as described above so that the timer is supplied with a 10 kHz clock, a setting of Period = 9999
-		 * (i.e. 10000-1) would cause the counter to always count from 0-9999 and then reset to 0.
-		 */
-		my_timer_handle_struct.Init.Period = period - 1;
-
-		/* Counter mode is assigned to count up */
-		my_timer_handle_struct.Init.CounterMode = TIM_COUNTERMODE_UP;
-		my_timer_handle_struct.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
-		my_timer_handle_struct.Init.AutoReloadPreload =
-		TIM_AUTORELOAD_PRELOAD_DISABLE;
-		/* Here you specify after how many overflows an event should be generated */
-		my_timer_handle_struct.Init.RepetitionCounter = 0;
-		break;
+	/* Nearest possible prescaler, the prescaler register has 16 bits */
+	prescaler = (timer->clock + tick_hz / 2) / tick_hz;
+	if (prescaler < 1) {
+		prescaler = 1;
+	} else if (prescaler > 0x10000) {
+		prescaler = 0x10000;
+	}
 
-	case TIMER_INSTANCE_3:
-		/* Clock for Timer3 */
-		__HAL_RCC_TIM3_CLK_ENABLE();
-		my_timer_handle_struct.Instance = TIM3;
-
-		/* Upper defined prescaler will be assigned here. */
-		/* Timer3 has a different maximum clock, so it must be divided by two again. */
-		my_timer_handle_struct.Init.Prescaler =
-				(SystemCoreClock / 2 / prescaler) - 1;
-		/**
-		 * This allows you to set the value to which the timer will count. (how much time elapses)
-		 * before it is reset and starts again from the beginning. Assuming that the prescaler has been
-		 * set as described above so that the timer is supplied with a 10 kHz clock, a setting of Period = 9999
-		 * (i.e. 10000-1) would cause the counter to always count from 0-9999 and then reset to 0.
-		 */
-		my_timer_handle_struct.Init.Period = period - 1;
-
-		/* Counter mode is assigned to count up */
-		my_timer_handle_struct.Init.CounterMode = TIM_COUNTERMODE_UP;
-		my_timer_handle_struct.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
-		my_timer_handle_struct.Init.AutoReloadPreload =
-		TIM_AUTORELOAD_PRELOAD_DISABLE;
-		/* Here you specify after how many overflows an event should be generated */
-		my_timer_handle_struct.Init.RepetitionCounter = 0;
-		break;
+	timer->handle.Instance = instance;
+	timer->handle.Init.Prescaler = prescaler - 1;
+	/**
+	 * This allows you to set the value to which the timer will count. (how much time elapses)
+	 * before it is reset and starts again from the beginning. Assuming that the prescaler has been
+	 * set as described above so that the timer is supplied with a 10 kHz clock, a setting of Period = 9999
+	 * (i.e. 10000-1) would cause the counter to always count from 0-9999 and then reset to 0.
+	 */
+	timer->handle.Init.Period = period - 1;
+	if (!IS_TIM_32B_COUNTER_INSTANCE(instance) && (period == 0 || period > 0x10000)) {
+		timer->handle.Init.Period = 0xFFFF;
 	}
 
+	/* Counter mode is assigned to count up */
+	timer->handle.Init.CounterMode = TIM_COUNTERMODE_UP;
+	timer->handle.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
+	timer->handle.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_DISABLE;
+	/* Here you specify after how many overflows an event should be generated */
+	timer->handle.Init.RepetitionCounter = 0;
+
 	if (mode == TIMER_MODE_BASE) {
 		/* Initialization of the Timer for base. */
-		HAL_TIM_Base_Init(&my_timer_handle_struct);
+		HAL_TIM_Base_Init(&timer->handle);
 	} else if (mode == TIMER_MODE_PWM) {
 		/* Initialization of the Timer for PWM. */
-		HAL_TIM_PWM_Init(&my_timer_handle_struct);
+		HAL_TIM_PWM_Init(&timer->handle);
+	} else if (mode == TIMER_MODE_IC) {
+		/* Initialization of the Timer for input capture. */
+		HAL_TIM_IC_Init(&timer->handle);
 	}
 }
 
@@ -164,11 +136,11 @@ void my_timer_init(timer_instance instance, timer_mode mode, uint32_t prescaler,
  * with the timer handle structure and the TIM_IT_UPDATE flag as arguments.
  * This allows the timer to generate interrupt events on update.
  *
- * @param none
+ * @param timer The timer.
  * @return none
  */
-void my_timer_enable_interrupt() {
-	__HAL_TIM_ENABLE_IT(&my_timer_handle_struct, TIM_IT_UPDATE);
+void my_timer_enable_interrupt(my_timer_t *timer) {
+	__HAL_TIM_ENABLE_IT(&timer->handle, TIM_IT_UPDATE);
 }
 
 /**
@@ -181,6 +153,7 @@ void my_timer_enable_interrupt() {
  * - Calls either HAL_TIM_OC_ConfigChannel() or HAL_TIM_PWM_ConfigChannel() depending on the specified mode to configure
  *   the timer channel with the configured output compare handle structure.
  *
+ * @param timer The timer, that the channel belongs to.
  * @param instance The output compare instance to be initialized (INSTANCE_PWM_1 or INSTANCE_PWM_2).
  * @param mode The mode of operation for the output compare (MODE_OC or MODE_PWM).
  * @param pulse The pulse value for the output compare mode.
@@ -188,44 +161,59 @@ void my_timer_enable_interrupt() {
  *
  * @return none
  */
-void my_timer_oc_init(timer_oc_instance instance, timer_oc_mode mode,
-		uint32_t pulse, uint32_t channel) {
+void my_timer_oc_init(my_timer_t *timer, timer_oc_instance instance,
+		timer_oc_mode mode, uint32_t pulse, uint32_t channel) {
 	switch (instance) {
 	case INSTANCE_PWM_1:
 		// Configure output compare mode for PWM1
-		my_timer_oc_handle_struct.OCMode = TIM_OCMODE_PWM1;
-		/* Must be in period, compare-value*/
-		my_timer_oc_handle_struct.Pulse = pulse;
-		my_timer_oc_handle_struct.OCIdleState = TIM_OCIDLESTATE_SET;
-		/* Here we have set it to low. This is because the pins are activated at low level. */
-		my_timer_oc_handle_struct.OCPolarity = TIM_OCPOLARITY_LOW;
-		my_timer_oc_handle_struct.OCNIdleState = TIM_OCNIDLESTATE_RESET;
-		my_timer_oc_handle_struct.OCNPolarity = TIM_OCNPOLARITY_HIGH;
+		timer->oc.OCMode = TIM_OCMODE_PWM1;
 		break;
 
 	case INSTANCE_PWM_2:
 		// Configure output compare mode for PWM2
-		my_timer_oc_handle_struct.OCMode = TIM_OCMODE_PWM2;
-		/* Must be in period, compare-value*/
-		my_timer_oc_handle_struct.Pulse = pulse;
-		my_timer_oc_handle_struct.OCIdleState = TIM_OCIDLESTATE_SET;
-		/* Here we have set it to low. This is because the pins are activated at low level. */
-		my_timer_oc_handle_struct.OCPolarity = TIM_OCPOLARITY_LOW;
-		my_timer_oc_handle_struct.OCNIdleState = TIM_OCNIDLESTATE_RESET;
-		my_timer_oc_handle_struct.OCNPolarity = TIM_OCNPOLARITY_HIGH;
+		timer->oc.OCMode = TIM_OCMODE_PWM2;
 		break;
 	}
 
+	/* Must be in period, compare-value*/
+	timer->oc.Pulse = pulse;
+	timer->oc.OCIdleState = TIM_OCIDLESTATE_SET;
+	/* Here we have set it to low. This is because the pins are activated at low level. */
+	timer->oc.OCPolarity = TIM_OCPOLARITY_LOW;
+	timer->oc.OCNIdleState = TIM_OCNIDLESTATE_RESET;
+	timer->oc.OCNPolarity = TIM_OCNPOLARITY_HIGH;
+	timer->oc.OCFastMode = TIM_OCFAST_DISABLE;
+
 	if (mode == MODE_OC) {
 		// Configure timer channel with output compare handle structure for output compare mode
-		HAL_TIM_OC_ConfigChannel(&my_timer_handle_struct,
-				&my_timer_oc_handle_struct, channel);
+		HAL_TIM_OC_ConfigChannel(&timer->handle, &timer->oc, channel);
 	} else if (mode == MODE_PWM) {
 		// Configure timer channel with output compare handle structure for PWM mode
-		HAL_TIM_PWM_ConfigChannel(&my_timer_handle_struct,
-				&my_timer_oc_handle_struct, channel);
+		HAL_TIM_PWM_ConfigChannel(&timer->handle, &timer->oc, channel);
 	}
+}
+
+/**
+ * @brief Configures an input capture channel. The counter value is stored in the compare
+ *        register of the channel at every selected edge of its own pin (TI1 for channel 1 ...).
+ *
+ * @param timer The timer, that the channel belongs to (initialized with TIMER_MODE_IC).
+ * @param channel The timer channel to be configured.
+ * @param polarity TIM_INPUTCHANNELPOLARITY_RISING, _FALLING or _BOTHEDGE.
+ * @param filter Digital input filter (0 ... 15, see ICxF in RM0090), suppresses short spikes.
+ *
+ * @return none
+ */
+void my_timer_ic_init(my_timer_t *timer, uint32_t channel, uint32_t polarity,
+		uint32_t filter) {
+	TIM_IC_InitTypeDef ic;
 
+	ic.ICPolarity = polarity;
+	ic.ICSelection = TIM_ICSELECTION_DIRECTTI;
+	/* Every edge is captured */
+	ic.ICPrescaler = TIM_ICPSC_DIV1;
+	ic.ICFilter = filter;
+	HAL_TIM_IC_ConfigChannel(&timer->handle, &ic, channel);
 }
 
 /**
@@ -235,18 +223,19 @@ void my_timer_oc_init(timer_oc_instance instance, timer_oc_mode mode,
  * The function checks the mode and calls either HAL_TIM_OC_Start() or HAL_TIM_PWM_Start()
  * to start the timer channel.
  *
+ * @param timer The timer, that the channel belongs to.
  * @param mode The mode of operation for the timer channel (MODE_OC or MODE_PWM).
  * @param channel The timer channel to be started.
  *
  * @return none
  */
-void my_timer_start(timer_oc_mode mode, uint32_t channel) {
+void my_timer_start(my_timer_t *timer, timer_oc_mode mode, uint32_t channel) {
 	if (mode == MODE_OC) {
 		// Start the timer channel in output compare mode
-		HAL_TIM_OC_Start(&my_timer_handle_struct, channel);
+		HAL_TIM_OC_Start(&timer->handle, channel);
 	} else if (mode == MODE_PWM) {
 		// Start the timer channel in PWM mode
-		HAL_TIM_PWM_Start(&my_timer_handle_struct, channel);
+		HAL_TIM_PWM_Start(&timer->handle, channel);
 	}
 }
 
@@ -255,13 +244,16 @@ void my_timer_start(timer_oc_mode mode, uint32_t channel) {
  *
  * This function sets the prescaler value for the timer based on the provided value.
  * It uses the __HAL_TIM_SET_PRESCALER macro to update the prescaler value of the timer handle.
+ * The handle is updated too, so the reported frequency stays correct.
  *
+ * @param timer The timer.
  * @param value The prescaler value to be set.
  *
  * @return none
  */
-void my_timer_set_prescaler(uint32_t value) {
-	__HAL_TIM_SET_PRESCALER(&my_timer_handle_struct, value);
+void my_timer_set_prescaler(my_timer_t *timer, uint32_t value) {
+	__HAL_TIM_SET_PRESCALER(&timer->handle, value);
+	timer->handle.Init.Prescaler = value;
 }
 
 /**
@@ -271,37 +263,206 @@ void my_timer_set_prescaler(uint32_t value) {
  * channel and value. It uses the __HAL_TIM_SET_COMPARE macro to update the compare value
  * of the timer handle.
  *
+ * @param timer The timer, that the channel belongs to.
  * @param channel The timer channel for which the compare value should be set.
  * @param value The compare value to be set.
  *
  * @return none
  */
-void my_timer_set_compare(uint32_t channel, uint32_t value) {
-	__HAL_TIM_SET_COMPARE(&my_timer_handle_struct, channel, value);
+void my_timer_set_compare(my_timer_t *timer, uint32_t channel, uint32_t value) {
+	__HAL_TIM_SET_COMPARE(&timer->handle, channel, value);
 }
 
 /**
- * @brief Retrieves the timer handle structure.
+ * @brief Returns the input clock of a timer instance, as it is configured in RCC.
  *
- * This function returns the timer handle structure, which contains the configuration and
- * state information of the timer. It simply returns the `my_timer_handle_struct` variable.
+ * The timers get the clock of their APB bus. If the APB prescaler is not 1, the timer clock
+ * is twice the bus clock. With TIMPRE set, it is four times the bus clock, but at most HCLK.
  *
- * @return The timer handle structure.
+ * @param instance The timer instance (TIM1 - TIM14).
+ * @return The timer clock in Hz.
  */
-TIM_HandleTypeDef my_timer_get_struct() {
-	return my_timer_handle_struct;
+uint32_t my_timer_get_clock(TIM_TypeDef *instance) {
+	uint32_t pclk;
+	uint32_t apb_divided;
+
+	if (instance == TIM1 || instance == TIM8 || instance == TIM9
+			|| instance == TIM10 || instance == TIM11) {
+		pclk = HAL_RCC_GetPCLK2Freq();
+		apb_divided = (RCC->CFGR & RCC_CFGR_PPRE2) != RCC_CFGR_PPRE2_DIV1;
+	} else {
+		pclk = HAL_RCC_GetPCLK1Freq();
+		apb_divided = (RCC->CFGR & RCC_CFGR_PPRE1) != RCC_CFGR_PPRE1_DIV1;
+	}
+
+	if (!apb_divided) {
+		return pclk;
+	}
+	if (RCC->DCKCFGR & RCC_DCKCFGR_TIMPRE) {
+		pclk *= 4;
+		return (pclk < HAL_RCC_GetHCLKFreq()) ? pclk : HAL_RCC_GetHCLKFreq();
+	}
+	return pclk * 2;
 }
 
 /**
- * @brief Retrieves the timer output compare handle structure.
- *
- * This function returns the timer output compare handle structure, which contains the configuration
- * and state information of the timer output compare channel. It simply returns the `my_timer_oc_handle_struct` variable.
- *
- * @return The timer output compare handle structure.
- *
+ * @brief Returns the frequency, that the counter of the timer actually counts with.
+ * @param timer The timer.
+ * @return Counter frequency in Hz (rounded down).
+ */
+uint32_t my_timer_get_tick_hz(const my_timer_t *timer) {
+	return timer->clock / (timer->handle.Init.Prescaler + 1);
+}
+
+/**
+ * @brief Returns the exact update (overflow) frequency of the timer, e.g. the PWM frequency.
+ * @param timer The timer.
+ * @return Update frequency in millihertz (rounded to the nearest).
+ */
+uint64_t my_timer_get_frequency_mhz(const my_timer_t *timer) {
+	uint64_t divider = (uint64_t) (timer->handle.Init.Prescaler + 1)
+			* ((uint64_t) timer->handle.Init.Period + 1);
+
+	return ((uint64_t) timer->clock * 1000 + divider / 2) / divider;
+}
+
+/**
+ * @brief Finds the prescaler and period, whose product is closest to clock / frequency.
+ *
+ * The smallest prescaler, that lets the period fit into the counter, gives the finest period
+ * resolution. The next MY_TIMER_SOLVE_SPAN prescalers are tried as well, because one of them
+ * may divide the clock exactly. The search stops at the first exact match.
+ * Uses only integer math, but many divisions, so it belongs in the initialisation.
+ *
+ * @param clock Input clock of the timer in Hz (see my_timer_get_clock()).
+ * @param frequency_mhz Desired update frequency in millihertz.
+ * @param max_period Largest possible ARR value (0xFFFF, 0xFFFFFFFF for TIM2 and TIM5).
+ * @param setting Result.
+ * @return 0 on success, -1 if the frequency is 0 or not reachable.
+ */
+int8_t my_timer_solve(uint32_t clock, uint32_t frequency_mhz,
+		uint32_t max_period, my_timer_setting_t *setting) {
+	uint64_t ticks;
+	uint64_t product;
+	uint64_t error;
+	uint64_t best_error = UINT64_MAX;
+	uint64_t divider;
+	uint64_t divider_max;
+	uint64_t period;
+
+	if (frequency_mhz == 0) {
+		return -1;
+	}
+
+	/* Timer clocks per update, rounded */
+	ticks = ((uint64_t) clock * 1000 + frequency_mhz / 2) / frequency_mhz;
+	if (ticks < 2 || ticks > (uint64_t) 0x10000 * ((uint64_t) max_period + 1)) {
+		return -1;
+	}
+
+	divider = (ticks + max_period) / ((uint64_t) max_period + 1);
+	if (divider < 1) {
+		divider = 1;
+	}
+	divider_max = divider + MY_TIMER_SOLVE_SPAN;
+	if (divider_max > 0x10000) {
+		divider_max = 0x10000;
+	}
+
+	for (; divider <= divider_max; divider++) {
+		period = (ticks + divider / 2) / divider;
+		if (period < 1 || period > (uint64_t) max_period + 1) {
+			continue;
+		}
+		product = divider * period;
+		error = (product > ticks) ? product - ticks : ticks - product;
+		if (error < best_error) {
+			best_error = error;
+			setting->prescaler = divider - 1;
+			setting->period = period - 1;
+			if (error == 0) {
+				break;
+			}
+		}
+	}
+	return (best_error == UINT64_MAX) ? -1 : 0;
+}
+
+/**
+ * @brief Enables the preload of the auto-reload register and of the compare register of a channel.
+ *        New values are then only taken over at the next update event.
+ * @param timer The timer.
+ * @param channel The timer channel, whose compare register is preloaded.
+ * @return none
+ */
+void my_timer_enable_preload(my_timer_t *timer, uint32_t channel) {
+	timer->handle.Instance->CR1 |= TIM_CR1_ARPE;
+	timer->handle.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_ENABLE;
+	__HAL_TIM_ENABLE_OCxPRELOAD(&timer->handle, channel);
+}
+
+/**
+ * @brief Holds back the update event, so that the following register writes are taken over together.
+ * @param timer The timer.
+ * @return none
+ */
+void my_timer_begin_update(my_timer_t *timer) {
+	timer->handle.Instance->CR1 |= TIM_CR1_UDIS;
+}
+
+/**
+ * @brief Writes prescaler and period (from my_timer_solve()) into the preload registers.
+ * @param timer The timer.
+ * @param setting Prescaler and period.
+ * @return none
  */
-TIM_OC_InitTypeDef my_timer_get_oc_struct() {
-	return my_timer_oc_handle_struct;
+void my_timer_apply(my_timer_t *timer, const my_timer_setting_t *setting) {
+	my_timer_set_prescaler(timer, setting->prescaler);
+	__HAL_TIM_SET_AUTORELOAD(&timer->handle, setting->period);
 }
 
+/**
+ * @brief Allows the update event again, the new values are used from the next period on.
+ * @param timer The timer.
+ * @return none
+ */
+void my_timer_end_update(my_timer_t *timer) {
+	timer->handle.Instance->CR1 &= ~TIM_CR1_UDIS;
+}
+
+/**
+ * @brief Enables the clock of a timer instance.
+ * @param instance The timer instance (TIM1 - TIM14).
+ * @return none
+ */
+static void my_timer_enable_clock(TIM_TypeDef *instance) {
+	if (instance == TIM1) {
+		__HAL_RCC_TIM1_CLK_ENABLE();
+	} else if (instance == TIM2) {
+		__HAL_RCC_TIM2_CLK_ENABLE();
+	} else if (instance == TIM3) {
+		__HAL_RCC_TIM3_CLK_ENABLE();
+	} else if (instance == TIM4) {
+		__HAL_RCC_TIM4_CLK_ENABLE();
+	} else if (instance == TIM5) {
+		__HAL_RCC_TIM5_CLK_ENABLE();
+	} else if (instance == TIM6) {
+		__HAL_RCC_TIM6_CLK_ENABLE();
+	} else if (instance == TIM7) {
+		__HAL_RCC_TIM7_CLK_ENABLE();
+	} else if (instance == TIM8) {
+		__HAL_RCC_TIM8_CLK_ENABLE();
+	} else if (instance == TIM9) {
+		__HAL_RCC_TIM9_CLK_ENABLE();
+	} else if (instance == TIM10) {
+		__HAL_RCC_TIM10_CLK_ENABLE();
+	} else if (instance == TIM11) {
+		__HAL_RCC_TIM11_CLK_ENABLE();
+	} else if (instance == TIM12) {
+		__HAL_RCC_TIM12_CLK_ENABLE();
+	} else if (instance == TIM13) {
+		__HAL_RCC_TIM13_CLK_ENABLE();
+	} else if (instance == TIM14) {
+		__HAL_RCC_TIM14_CLK_ENABLE();
+	}
+}
@@ -2,7 +2,7 @@
 **************************************************
 * @file my_timer.h
 * @author Berkay Özgür, C. Arda Sengenc
-* @version v1.0
+* @version v1.1
 * @date 19.06.2023
 * @brief: Header file for the custom timer module.
 **************************************************
@@ -10,22 +10,17 @@
 #ifndef MY_TIMER_MY_TIMER_H_
 #define MY_TIMER_MY_TIMER_H_
 
-/* In order to meet the requirements given on the paper, we are required to create an Interval Value between 1 to 10 */
-#define MAX_INTERVAL(x) (x*(10-1))
-#define CORE_CLOCK(x) ((SystemCoreClock / (10000*x)) - 1)
+#include "stm32f4xx.h"
 
-
-/* Public enums as shortcuts for instances */
-typedef enum {
-	TIMER_INSTANCE_1,
-	TIMER_INSTANCE_2,
-	TIMER_INSTANCE_3,
-} timer_instance;
+/* Public preprocessor macros */
+/* Number of prescalers, that my_timer_solve() tries above the smallest possible one */
+#define MY_TIMER_SOLVE_SPAN 64
 
 /* Public enums as shortcuts for mode bases */
 typedef enum {
 	TIMER_MODE_BASE,
 	TIMER_MODE_PWM,
+	TIMER_MODE_IC,
 } timer_mode;
 
 /* Public enums as shortcuts for output compare */
@@ -40,13 +35,34 @@ typedef enum {
 	MODE_PWM,
 } timer_oc_mode;
 
+/* Result of my_timer_solve(): register values for one frequency */
+typedef struct {
+	uint16_t prescaler;			/* PSC register value, counter clock = clock / (prescaler + 1) */
+	uint32_t period;			/* ARR register value, frequency = counter clock / (period + 1) */
+} my_timer_setting_t;
+
+/* One timer, every module that uses a timer owns one of these */
+typedef struct {
+	TIM_HandleTypeDef handle;	/* HAL handle, can be used directly with the HAL functions */
+	TIM_OC_InitTypeDef oc;		/* Last output compare configuration */
+	uint32_t clock;				/* Input clock of the timer in Hz, read from RCC */
+} my_timer_t;
+
 /* Public functions (prototypes) */
-void my_timer_init(timer_instance instance, timer_mode mode, uint32_t prescaler, uint32_t period);
-void my_timer_oc_init(timer_oc_instance instance, timer_oc_mode mode, uint32_t pulse, uint32_t channel);
-void my_timer_start(timer_oc_mode mode, uint32_t channel);
-void my_timer_set_compare(uint32_t channel, uint32_t value);
-void my_timer_set_prescaler(uint32_t value);
-TIM_HandleTypeDef my_timer_get_struct();
-TIM_OC_InitTypeDef my_timer_get_oc_struct();
+void my_timer_init(my_timer_t *timer, TIM_TypeDef *instance, timer_mode mode, uint32_t tick_hz, uint32_t period);
+void my_timer_enable_interrupt(my_timer_t *timer);
+void my_timer_oc_init(my_timer_t *timer, timer_oc_instance instance, timer_oc_mode mode, uint32_t pulse, uint32_t channel);
+void my_timer_ic_init(my_timer_t *timer, uint32_t channel, uint32_t polarity, uint32_t filter);
+void my_timer_start(my_timer_t *timer, timer_oc_mode mode, uint32_t channel);
+void my_timer_set_compare(my_timer_t *timer, uint32_t channel, uint32_t value);
+void my_timer_set_prescaler(my_timer_t *timer, uint32_t value);
+uint32_t my_timer_get_clock(TIM_TypeDef *instance);
+uint32_t my_timer_get_tick_hz(const my_timer_t *timer);
+uint64_t my_timer_get_frequency_mhz(const my_timer_t *timer);
+int8_t my_timer_solve(uint32_t clock, uint32_t frequency_mhz, uint32_t max_period, my_timer_setting_t *setting);
+void my_timer_enable_preload(my_timer_t *timer, uint32_t channel);
+void my_timer_begin_update(my_timer_t *timer);
+void my_timer_apply(my_timer_t *timer, const my_timer_setting_t *setting);
+void my_timer_end_update(my_timer_t *timer);
 
 #endif /* MY_TIMER_MY_TIMER_H_ */
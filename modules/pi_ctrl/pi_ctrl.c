@@ -0,0 +1,222 @@
+/**
+ **************************************************
+ * @file pi_ctrl.c
+ * @author Berkay Özgür, C. Arda Sengenc
+ * @version v1.0
+ * @date 17.10.2026
+ * @brief: PI controller in Q16 fixed point for a fixed sample time, without floats,
+ * so it is cheap enough to run in an interrupt.
+ @verbatim
+ ==================================================
+ ### Resources used ###
+
+ None, the caller provides the pi_ctrl_t and calls "pi_ctrl_update()" once per sample time
+ (e.g. from a periodic soft_timer with SOFT_TIMER_ISR).
+
+ ==================================================
+ ### Principle ###
+
+ output = kp * (weight * setpoint - measurement) + integral
+ integral += ki * Ts * (setpoint - measurement)
+
+ Anti-windup: while the output is at a limit, the integral is not moved further into
+ that limit (conditional integration). So the controller reacts at once, when the error
+ changes its sign. The integral is not clamped to the output range, with the setpoint
+ weight below 1 it also carries the share of the setpoint, that the proportional term lacks.
+
+ Bumpless changes: with the default setpoint weight 0, the proportional term only sees
+ the measurement, so a setpoint step does not kick the output, the integral moves it
+ smoothly. "pi_ctrl_set_gains()" and "pi_ctrl_reset()" recalculate the integral, so the
+ output continues from where it was (or from the given value).
+
+ Feed-forward: when the output for a new setpoint is known (e.g. from a table), "pi_ctrl_preset()"
+ and "pi_ctrl_feed_forward()" move the integral to where it settles for that setpoint. So the
+ output jumps at once and the controller only corrects the error of the known output.
+
+ Ranges: outputs within +-32767, setpoint and measurement within +-2^20, kp below 256,
+ ki below 32768.
+
+ ==================================================
+ ### Usage ###
+
+ (#) Call "pi_ctrl_init()" with the gains (PI_CTRL_Q16(0.98), ...), the sample time and
+ the output limits.
+
+ (#) Call "pi_ctrl_update()" every sample time with the setpoint and the measurement,
+ it returns the new output.
+
+ (#) Optional: "pi_ctrl_set_setpoint_weight()" (PI_CTRL_ONE for the classic error form),
+ "pi_ctrl_set_gains()" to retune while running, "pi_ctrl_reset()" to continue from a
+ given output, "pi_ctrl_preset()" and "pi_ctrl_feed_forward()" for a new setpoint with a known
+ output (feed-forward).
+
+ @endverbatim
+ **************************************************
+ */
+
+/* Includes */
+#include "pi_ctrl.h"
+
+/* Module functions (prototypes) */
+static int64_t pi_ctrl_proportional(const pi_ctrl_t *pi, int32_t setpoint,
+		int32_t measurement);
+
+/**
+ * @brief Initializes a controller. The output starts at the lower limit.
+ *
+ * @param pi The controller.
+ * @param kp Proportional gain (Q16).
+ * @param ki Integral gain per second (Q16).
+ * @param sample_us Time between two calls of pi_ctrl_update() in microseconds.
+ * @param out_min Lower output limit.
+ * @param out_max Upper output limit.
+ * @return none
+ */
+void pi_ctrl_init(pi_ctrl_t *pi, int32_t kp, int32_t ki, uint32_t sample_us,
+		int32_t out_min, int32_t out_max) {
+	pi->sample_us = sample_us;
+	pi->out_min = out_min;
+	pi->out_max = out_max;
+	pi->setpoint_weight = 0;
+	pi->setpoint = 0;
+	pi->measurement = 0;
+	pi->kp = kp;
+	pi->ki = ki;
+	pi->ki_ts = (int32_t) (((int64_t) ki * sample_us + 500000) / 1000000);
+	pi->integral = (int64_t) out_min * PI_CTRL_ONE;
+	pi->output = out_min;
+}
+
+/**
+ * @brief Changes the gains. The integral is recalculated, so the output does not jump.
+ *
+ * @param pi The controller.
+ * @param kp Proportional gain (Q16).
+ * @param ki Integral gain per second (Q16).
+ * @return none
+ */
+void pi_ctrl_set_gains(pi_ctrl_t *pi, int32_t kp, int32_t ki) {
+	pi->kp = kp;
+	pi->ki = ki;
+	pi->ki_ts = (int32_t) (((int64_t) ki * pi->sample_us + 500000) / 1000000);
+	pi_ctrl_reset(pi, pi->output);
+}
+
+/**
+ * @brief Sets the share of the setpoint in the proportional term. 0 (default) gives bumpless
+ *        setpoint changes, PI_CTRL_ONE the classic form with the error in both terms.
+ *        The integral is recalculated, so the output does not jump.
+ *
+ * @param pi The controller.
+ * @param weight 0 ... PI_CTRL_ONE (Q16).
+ * @return none
+ */
+void pi_ctrl_set_setpoint_weight(pi_ctrl_t *pi, int32_t weight) {
+	pi->setpoint_weight = weight;
+	pi_ctrl_reset(pi, pi->output);
+}
+
+/**
+ * @brief Lets the controller continue from the given output: the integral is set, so that the
+ *        next update with the last setpoint and measurement returns this output.
+ *
+ * @param pi The controller.
+ * @param output Output to continue from (clamped to the limits).
+ * @return none
+ */
+void pi_ctrl_reset(pi_ctrl_t *pi, int32_t output) {
+	if (output > pi->out_max) {
+		output = pi->out_max;
+	} else if (output < pi->out_min) {
+		output = pi->out_min;
+	}
+
+	pi->integral = (int64_t) output * PI_CTRL_ONE
+			- pi_ctrl_proportional(pi, pi->setpoint, pi->measurement);
+	pi->output = output;
+}
+
+/**
+ * @brief Sets the controller into the steady state for a setpoint: the integral is set, so that a
+ *        measurement equal to the setpoint returns the given output.
+ *
+ * @param pi The controller.
+ * @param setpoint New setpoint.
+ * @param output Output, that holds the measurement at the setpoint.
+ * @return none
+ */
+void pi_ctrl_preset(pi_ctrl_t *pi, int32_t setpoint, int32_t output) {
+	pi->integral = (int64_t) output * PI_CTRL_ONE
+			- pi_ctrl_proportional(pi, setpoint, setpoint);
+	pi->setpoint = setpoint;
+	pi->output = output;
+}
+
+/**
+ * @brief Moves the controller to a new setpoint, whose output differs by delta from the one of the
+ *        last setpoint. The integral keeps its correction of the last output, so only the residual
+ *        error is left for the controller.
+ *
+ * @param pi The controller.
+ * @param setpoint New setpoint.
+ * @param delta Output for the new setpoint minus the output for the last one.
+ * @return none
+ */
+void pi_ctrl_feed_forward(pi_ctrl_t *pi, int32_t setpoint, int32_t delta) {
+	pi->integral += (int64_t) delta * PI_CTRL_ONE
+			+ pi_ctrl_proportional(pi, pi->setpoint, pi->setpoint)
+			- pi_ctrl_proportional(pi, setpoint, setpoint);
+	pi->setpoint = setpoint;
+}
+
+/**
+ * @brief Calculates the output for one sample.
+ *
+ * @param pi The controller.
+ * @param setpoint Desired value.
+ * @param measurement Measured value.
+ * @return New output within the limits.
+ */
+int32_t pi_ctrl_update(pi_ctrl_t *pi, int32_t setpoint, int32_t measurement) {
+	int32_t error = setpoint - measurement;
+	int64_t proportional = pi_ctrl_proportional(pi, setpoint, measurement);
+	int64_t step = (int64_t) pi->ki_ts * error;
+	int64_t integral = pi->integral + step;
+	int64_t output = proportional + integral;
+
+	/* Anti-windup: do not integrate further into a limit */
+	if ((output > (int64_t) pi->out_max * PI_CTRL_ONE && step > 0)
+			|| (output < (int64_t) pi->out_min * PI_CTRL_ONE && step < 0)) {
+		integral = pi->integral;
+		output = proportional + integral;
+	}
+	pi->integral = integral;
+
+	/* Round to output units */
+	output = (output + PI_CTRL_ONE / 2) >> 16;
+	if (output > pi->out_max) {
+		output = pi->out_max;
+	} else if (output < pi->out_min) {
+		output = pi->out_min;
+	}
+
+	pi->setpoint = setpoint;
+	pi->measurement = measurement;
+	pi->output = (int32_t) output;
+	return pi->output;
+}
+
+/**
+ * @brief Calculates the proportional term.
+ * @param pi The controller.
+ * @param setpoint Desired value.
+ * @param measurement Measured value.
+ * @return kp * (weight * setpoint - measurement) in output units (Q16).
+ */
+static int64_t pi_ctrl_proportional(const pi_ctrl_t *pi, int32_t setpoint,
+		int32_t measurement) {
+	int64_t weighted_error = (int64_t) pi->setpoint_weight * setpoint
+			- (int64_t) measurement * PI_CTRL_ONE;
+
+	return ((int64_t) pi->kp * weighted_error) >> 16;
+}
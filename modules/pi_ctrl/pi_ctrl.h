@@ -0,0 +1,47 @@
+/**
+**************************************************
+* @file pi_ctrl.h
+* @author Berkay Özgür, C. Arda Sengenc
+* @version v1.0
+* @date 17.10.2026
+* @brief: Header file for the fixed-point PI controller.
+**************************************************
+*/
+
+#ifndef PI_CTRL_PI_CTRL_H_
+#define PI_CTRL_PI_CTRL_H_
+
+/* Includes */
+#include <stdint.h>
+
+/* Public preprocessor macros */
+/* Q16 fixed-point value from a constant, e.g. PI_CTRL_Q16(0.98) */
+#define PI_CTRL_Q16(x) ((int32_t) ((x) * 65536.0 + (((x) < 0) ? -0.5 : 0.5)))
+#define PI_CTRL_ONE 65536
+
+/* Public types */
+/* One controller, all gains are Q16 (value * 65536) */
+typedef struct {
+	int32_t kp;					// proportional gain, output units per measurement unit
+	int32_t ki;					// integral gain, output units per measurement unit and second
+	int32_t ki_ts;				// ki multiplied by the sample time
+	int32_t setpoint_weight;	// share of the setpoint in the proportional term (0 ... PI_CTRL_ONE)
+	int32_t out_min;			// output limits in output units
+	int32_t out_max;
+	int32_t output;				// last output
+	int32_t setpoint;			// last setpoint and measurement, for the bumpless changes
+	int32_t measurement;
+	uint32_t sample_us;			// sample time in microseconds
+	int64_t integral;			// integral term in output units (Q16)
+} pi_ctrl_t;
+
+/* Public functions (prototypes) */
+void pi_ctrl_init(pi_ctrl_t *pi, int32_t kp, int32_t ki, uint32_t sample_us, int32_t out_min, int32_t out_max);
+void pi_ctrl_set_gains(pi_ctrl_t *pi, int32_t kp, int32_t ki);
+void pi_ctrl_set_setpoint_weight(pi_ctrl_t *pi, int32_t weight);
+void pi_ctrl_reset(pi_ctrl_t *pi, int32_t output);
+void pi_ctrl_preset(pi_ctrl_t *pi, int32_t setpoint, int32_t output);
+void pi_ctrl_feed_forward(pi_ctrl_t *pi, int32_t setpoint, int32_t delta);
+int32_t pi_ctrl_update(pi_ctrl_t *pi, int32_t setpoint, int32_t measurement);
+
+#endif /* PI_CTRL_PI_CTRL_H_ */
@@ -10,8 +10,18 @@
 ### Resources used ###
 DMA: DMA2_Stream0 and DMA_CHANNEL_0.
 GPIO: GPIO_PIN_6 and GPIO_PIN_7.
-ADC: ADC1.
+ADC: ADC1, one scan of both channels per trigger.
 ADC-Channels: ADC_CHANNEL_6 and ADC_CHANNEL_7.
+TIM8: Paces the ADC, its update event (TRGO) starts a scan POTIS_DMA_SAMPLE_HZ times per second.
+ADC_IRQHandler: Analog watchdog interrupt, fires as soon as a conversion of the supervised
+	channel leaves the hysteresis band around its last reported value.
+	The watchdog supervises one channel at a time (AWDSGL), the channel changes with every
+	completed half of the DMA buffer, so each channel has a window of its own.
+DMA2_Stream0_IRQHandler: Half and full transfer interrupt, each completed half of the
+	buffer is filtered once (see median_block_running() and median_block_trimmed_mean()).
+	Afterwards a fired watchdog is reported to potis_dma_poll_events() and the watchdog
+	moves on to the next channel.
+TIMEBASE: potis_dma_wait_events() sleeps in timebase_idle(), so the time is counted.
 ==================================================
 ### Usage ###
 
@@ -19,7 +29,16 @@ ADC-Channels: ADC_CHANNEL_6 and ADC_CHANNEL_7.
 	necessary channels for using DMA.
 
 (#) Call "potis_dma_get_avg(uint8_t input)" to get the value of the desired potentiometer.
-	For input see potis_dma.h to use macros.
+	For input see potis_dma.h to use macros. The value is the outlier free result
+	of the last completed half of the DMA buffer, so single ADC spikes do not bias it.
+
+(#) Event driven usage: Call "potis_dma_subscribe(input, callback)" once for every consumer,
+	then call "potis_dma_wait_events()" (sleeps until a knob moves) or
+	"potis_dma_poll_events()" (returns immediately) in main-function's while-loop.
+	A callback only runs when the value of its channel moved further than the
+	hysteresis band (see "potis_dma_set_hysteresis()"). There is no periodic check,
+	a change is reported at the end of the next half buffer, in which the watchdog
+	supervises its channel, i.e. after at most two halves of the buffer.
 
 @endverbatim
 **************************************************
@@ -28,10 +47,54 @@ ADC-Channels: ADC_CHANNEL_6 and ADC_CHANNEL_7.
 /* Includes */
 #include "stm32f4xx.h"
 #include <potis_dma.h>
+#include <median/median.h>
+#include <my_timer/my_timer.h>
+#include <timebase/timebase.h>
+
+/* Module functions (prototypes) */
+void ADC_IRQHandler(void);
+void DMA2_Stream0_IRQHandler(void);
+static void potis_dma_filter_block(const uint32_t *block);
+static void potis_dma_check_channels(void);
+static void potis_dma_arm_watchdog(uint8_t index);
+static void potis_dma_next_watchdog(void);
 
 /* Module variable */
 uint32_t dma_address[200];
 
+/* The handles must outlive potis_dma_init(), because the interrupt handler still uses them. */
+ADC_HandleTypeDef potis_dma_adc_handle_struct;
+DMA_HandleTypeDef potis_dma_dma_handle_struct;
+/* Trigger of the ADC */
+static my_timer_t potis_dma_trigger;
+
+/* Last values handed to the subscribers, index 0 is POTIS_DMA_1, index 1 is POTIS_DMA_2 */
+static uint32_t potis_dma_last_value[POTIS_DMA_CHANNELS];
+/* Software hysteresis band for each channel in ADC counts */
+static uint16_t potis_dma_hysteresis[POTIS_DMA_CHANNELS] = { POTIS_DMA_HYSTERESIS,
+		POTIS_DMA_HYSTERESIS };
+
+/* ADC channel behind each index, the watchdog is moved over them one after the other */
+static const uint32_t potis_dma_adc_channels[POTIS_DMA_CHANNELS] = { ADC_CHANNEL_6,
+		ADC_CHANNEL_7 };
+/* Index of the channel the watchdog supervises at the moment */
+static uint8_t potis_dma_awd_index = 0;
+/* Set by the watchdog interrupt, the filtered values do not contain the movement yet */
+static volatile uint8_t potis_dma_awd_pending = 0;
+/* Set at the end of the half buffer after the watchdog has fired, cleared by the check */
+static volatile uint8_t potis_dma_awd_flag = 0;
+
+/* Registered consumers and the channels they are interested in */
+static potis_dma_callback_t potis_dma_callbacks[POTIS_DMA_MAX_SUBSCRIBERS];
+static uint8_t potis_dma_callback_inputs[POTIS_DMA_MAX_SUBSCRIBERS];
+static uint8_t potis_dma_callback_count = 0;
+
+/* Channels that have changed but were not dispatched yet */
+static uint8_t potis_dma_changed = 0;
+
+/* Filtered value of each channel, updated once per completed half of the buffer */
+static volatile uint32_t potis_dma_clean_value[POTIS_DMA_CHANNELS];
+
 /**
   * @brief Initializes the module and all the necessary periphery
   * @param None
@@ -41,10 +104,12 @@ void potis_dma_init() {
 	HAL_Init();
 
 	/* Structures for initializing corresponding unit. */
-	ADC_HandleTypeDef ADC_handle_structure;
-	DMA_HandleTypeDef DMA_handle_structure;
+	ADC_HandleTypeDef *ADC_handle_structure = &potis_dma_adc_handle_struct;
+	DMA_HandleTypeDef *DMA_handle_structure = &potis_dma_dma_handle_struct;
 	ADC_ChannelConfTypeDef ADC_channel_structure1;
 	ADC_ChannelConfTypeDef ADC_channel_structure2;
+	ADC_AnalogWDGConfTypeDef ADC_watchdog_structure;
+	TIM_MasterConfigTypeDef trigger_structure;
 
 	/* The pins to which the potentiometers are connected must also be initialized */
 	__HAL_RCC_GPIOA_CLK_ENABLE();
@@ -61,88 +126,336 @@ void potis_dma_init() {
 	__HAL_RCC_DMA2_CLK_ENABLE();
 
 	/* For ADC1 we need according to Table 44 DMA2_Stream0 and DMA_CHANNEL_0. */
-	DMA_handle_structure.Instance = DMA2_Stream0;
-	DMA_handle_structure.Init.Channel = DMA_CHANNEL_0;
+	DMA_handle_structure->Instance = DMA2_Stream0;
+	DMA_handle_structure->Init.Channel = DMA_CHANNEL_0;
 	/* We are reading the values from peripheral and transporting them to memory*/
-	DMA_handle_structure.Init.Direction = DMA_PERIPH_TO_MEMORY;
-	DMA_handle_structure.Init.PeriphInc = DMA_PINC_DISABLE;
+	DMA_handle_structure->Init.Direction = DMA_PERIPH_TO_MEMORY;
+	DMA_handle_structure->Init.PeriphInc = DMA_PINC_DISABLE;
 	/* Memory increment is enabled, because we need to write the values to the memory
 	 * and increment the address in each iteration. */
-	DMA_handle_structure.Init.MemInc = DMA_MINC_ENABLE;
+	DMA_handle_structure->Init.MemInc = DMA_MINC_ENABLE;
 	/* 32 bit words */
-	DMA_handle_structure.Init.PeriphDataAlignment = DMA_PDATAALIGN_WORD;
-	DMA_handle_structure.Init.MemDataAlignment = DMA_MDATAALIGN_WORD;
+	DMA_handle_structure->Init.PeriphDataAlignment = DMA_PDATAALIGN_WORD;
+	DMA_handle_structure->Init.MemDataAlignment = DMA_MDATAALIGN_WORD;
 
 	/* We read two inputs one after the other, therefore circular*/
-	DMA_handle_structure.Init.Mode = DMA_CIRCULAR;
-	DMA_handle_structure.Init.Priority = DMA_PRIORITY_HIGH;
-	DMA_handle_structure.Init.FIFOMode = DMA_FIFOMODE_DISABLE;
-	HAL_DMA_Init(&DMA_handle_structure);
+	DMA_handle_structure->Init.Mode = DMA_CIRCULAR;
+	DMA_handle_structure->Init.Priority = DMA_PRIORITY_HIGH;
+	DMA_handle_structure->Init.FIFOMode = DMA_FIFOMODE_DISABLE;
+	HAL_DMA_Init(DMA_handle_structure);
 
 	/* Initialization of ADC1 */
 	__HAL_RCC_ADC1_CLK_ENABLE();
-	ADC_handle_structure.Instance = ADC1;
-	ADC_handle_structure.Init.ClockPrescaler = ADC_CLOCK_SYNC_PCLK_DIV4;
-	ADC_handle_structure.Init.Resolution = ADC_RESOLUTION_12B;
-	ADC_handle_structure.Init.DataAlign = ADC_DATAALIGN_RIGHT;
-	ADC_handle_structure.Init.DiscontinuousConvMode = DISABLE;
+	ADC_handle_structure->Instance = ADC1;
+	ADC_handle_structure->Init.ClockPrescaler = ADC_CLOCK_SYNC_PCLK_DIV4;
+	ADC_handle_structure->Init.Resolution = ADC_RESOLUTION_12B;
+	ADC_handle_structure->Init.DataAlign = ADC_DATAALIGN_RIGHT;
+	ADC_handle_structure->Init.DiscontinuousConvMode = DISABLE;
 
 
-	/* ScanConv, SequentialConversion and ContinuousMode must be enabled,
-	 * because we have two different channels to read */
-	ADC_handle_structure.Init.ScanConvMode = ENABLE;
-	ADC_handle_structure.Init.EOCSelection = ADC_EOC_SEQ_CONV;
-	ADC_handle_structure.Init.ContinuousConvMode = ENABLE;
+	/* ScanConv and SequentialConversion must be enabled, because we have two different
+	 * channels to read. Instead of the continuous mode, TIM8 starts each scan, otherwise
+	 * the DMA interrupt would come every 2.4 ms (see POTIS_DMA_SAMPLE_HZ). */
+	ADC_handle_structure->Init.ScanConvMode = ENABLE;
+	ADC_handle_structure->Init.EOCSelection = ADC_EOC_SEQ_CONV;
+	ADC_handle_structure->Init.ContinuousConvMode = DISABLE;
 
 	/* It is set to 2, because we have 2 channels to read */
-	ADC_handle_structure.Init.NbrOfConversion = 2;
-	ADC_handle_structure.Init.ExternalTrigConv = ADC_SOFTWARE_START;
+	ADC_handle_structure->Init.NbrOfConversion = 2;
+	ADC_handle_structure->Init.ExternalTrigConv = ADC_EXTERNALTRIGCONV_T8_TRGO;
+	ADC_handle_structure->Init.ExternalTrigConvEdge = ADC_EXTERNALTRIGCONVEDGE_RISING;
 
 	/* ADC needs to know, how the conversion will be made*/
-	ADC_handle_structure.DMA_Handle = &DMA_handle_structure;
-	ADC_handle_structure.Init.DMAContinuousRequests = ENABLE;
-	HAL_ADC_Init(&ADC_handle_structure);
+	__HAL_LINKDMA(ADC_handle_structure, DMA_Handle, *DMA_handle_structure);
+	ADC_handle_structure->Init.DMAContinuousRequests = ENABLE;
+	HAL_ADC_Init(ADC_handle_structure);
 
 	/* DMA for Channel 6 */
 	ADC_channel_structure1.Channel = ADC_CHANNEL_6;
 	ADC_channel_structure1.Rank = 1;
 	ADC_channel_structure1.SamplingTime = ADC_SAMPLETIME_84CYCLES;
-	HAL_ADC_ConfigChannel(&ADC_handle_structure, &ADC_channel_structure1);
+	HAL_ADC_ConfigChannel(ADC_handle_structure, &ADC_channel_structure1);
 
 	/*  DMA for Channel 7 */
 	ADC_channel_structure2.Channel = ADC_CHANNEL_7;
 	ADC_channel_structure2.Rank = 2;
 	ADC_channel_structure2.SamplingTime = ADC_SAMPLETIME_84CYCLES;
-	HAL_ADC_ConfigChannel(&ADC_handle_structure, &ADC_channel_structure2);
+	HAL_ADC_ConfigChannel(ADC_handle_structure, &ADC_channel_structure2);
+
+	/* The analog watchdog supervises a single regular channel. The channel and the thresholds
+	 * are moved in potis_dma_arm_watchdog(). */
+	ADC_watchdog_structure.WatchdogMode = ADC_ANALOGWATCHDOG_SINGLE_REG;
+	ADC_watchdog_structure.HighThreshold = 4095;
+	ADC_watchdog_structure.LowThreshold = 0;
+	ADC_watchdog_structure.Channel = ADC_CHANNEL_6;
+	ADC_watchdog_structure.ITMode = DISABLE;
+	ADC_watchdog_structure.WatchdogNumber = 0;
+	HAL_ADC_AnalogWDGConfig(ADC_handle_structure, &ADC_watchdog_structure);
+
+	/* Every channel counts as changed, so each subscriber gets the first value. The first
+	 * half buffer reports it like a fired watchdog and arms the watchdog afterwards. */
+	potis_dma_last_value[0] = POTIS_DMA_NO_VALUE;
+	potis_dma_last_value[1] = POTIS_DMA_NO_VALUE;
+	potis_dma_awd_pending = 1;
+
+	/* potis_dma_wait_events() counts its sleep time */
+	timebase_init();
+
+	HAL_NVIC_SetPriority(ADC_IRQn, 2, 0);
+	HAL_NVIC_EnableIRQ(ADC_IRQn);
+
+	/* HAL_ADC_Start_DMA() enables the half and full transfer interrupts of the stream */
+	HAL_NVIC_SetPriority(DMA2_Stream0_IRQn, 2, 0);
+	HAL_NVIC_EnableIRQ(DMA2_Stream0_IRQn);
+
+	/* TIM8 counts microseconds, every update event starts a scan */
+	my_timer_init(&potis_dma_trigger, TIM8, TIMER_MODE_BASE, 1000000,
+			1000000 / POTIS_DMA_SAMPLE_HZ);
+	trigger_structure.MasterOutputTrigger = TIM_TRGO_UPDATE;
+	trigger_structure.MasterSlaveMode = TIM_MASTERSLAVEMODE_DISABLE;
+	HAL_TIMEx_MasterConfigSynchronization(&potis_dma_trigger.handle, &trigger_structure);
 
-	/* Starting the DMA */
-	HAL_ADC_Start_DMA(&ADC_handle_structure, dma_address, 200);
+	/* Starting the DMA, the first scan starts with the first update event of TIM8 */
+	HAL_ADC_Start_DMA(ADC_handle_structure, dma_address, 200);
+	HAL_TIM_Base_Start(&potis_dma_trigger.handle);
 }
 
 /**
-  * @brief Function for getting the average of 100 conversions for desired channel.
-  * @param input, desired channel we want to see it's average.
-  * @return average of 100 conversions for desired channel.
+  * @brief Function for getting the filtered value for desired channel.
+  * 	   The filtering itself is done once per half buffer in the DMA interrupt,
+  * 	   so this function only returns the last result.
+  * @param input, desired channel we want to see it's value.
+  * @return outlier free average of the last POTIS_DMA_BLOCK_LENGTH conversions for desired channel.
   */
 uint32_t potis_dma_get_avg(uint8_t input) {
-	/* Auxiliary variable for saving the average for desired channel */
-	uint32_t tmp = 0;
-
 	/* Macros for choosing the desired channel */
 	if (input == POTIS_DMA_1) {
-		for (int i = 0; i < 200; i = i + 2) {
-			tmp += dma_address[i];
-		}
+		return potis_dma_clean_value[0];
 	}
 
 	/* Macros for choosing the desired channel */
 	if (input == POTIS_DMA_2) {
-		for (int i = 0; i < 200; i = i + 2) {
-			tmp += dma_address[i + 1];
+		return potis_dma_clean_value[1];
+	}
+
+	return 0;
+}
+
+/**
+  * @brief Sets the software hysteresis band of a channel. A subscriber is only notified if
+  * 	   the average moves further than this band away from the last reported value.
+  * @param input, POTIS_DMA_1 or POTIS_DMA_2.
+  * @param band, width of the band in ADC counts.
+  * @return None
+  */
+void potis_dma_set_hysteresis(uint8_t input, uint16_t band) {
+	if (input == POTIS_DMA_1) {
+		potis_dma_hysteresis[0] = band;
+	}
+	if (input == POTIS_DMA_2) {
+		potis_dma_hysteresis[1] = band;
+	}
+}
+
+/**
+  * @brief Registers a callback, which is called from potis_dma_poll_events() whenever
+  * 	   one of the selected channels has changed.
+  * @param input, POTIS_DMA_1, POTIS_DMA_2 or POTIS_DMA_ALL.
+  * @param callback, function to call. It reads the new value with potis_dma_get_avg().
+  * @return 0 on success, -1 if there is no free slot left.
+  */
+int8_t potis_dma_subscribe(uint8_t input, potis_dma_callback_t callback) {
+	if (potis_dma_callback_count >= POTIS_DMA_MAX_SUBSCRIBERS) {
+		return -1;
+	}
+	potis_dma_callbacks[potis_dma_callback_count] = callback;
+	potis_dma_callback_inputs[potis_dma_callback_count] = input;
+	potis_dma_callback_count++;
+	/* A late subscriber still wants to see the current value once. */
+	potis_dma_changed |= input;
+	return 0;
+}
+
+/**
+  * @brief Checks the channels and calls the subscribers of every changed channel.
+  * 	   The averages are only compared if the analog watchdog has fired during the
+  * 	   last completed half of the buffer.
+  * @param None
+  * @return Bit mask of the channels, which have been dispatched (0 if nothing changed).
+  */
+uint8_t potis_dma_poll_events(void) {
+	if (potis_dma_awd_flag) {
+		potis_dma_check_channels();
+	}
+
+	uint8_t changed = potis_dma_changed;
+	potis_dma_changed = 0;
+	if (changed) {
+		for (uint8_t i = 0; i < potis_dma_callback_count; i++) {
+			if (potis_dma_callback_inputs[i] & changed) {
+				potis_dma_callbacks[i]();
+			}
 		}
 	}
+	return changed;
+}
 
-	return (tmp / 100);
+/**
+  * @brief Puts the core to sleep until one of the channels has changed, then dispatches the
+  * 	   event. The core is woken up by the DMA interrupt at the end of each half buffer.
+  * 	   It sleeps in timebase_idle(), so the time shows up in timebase_get_sleep_us().
+  * @param None
+  * @return Bit mask of the channels, which have been dispatched.
+  */
+uint8_t potis_dma_wait_events(void) {
+	uint8_t changed;
+	while ((changed = potis_dma_poll_events()) == 0) {
+		timebase_idle();
+	}
+	return changed;
 }
 
+/**
+  * @brief Compares the current averages with the last reported values. Channels outside
+  * 	   of their hysteresis band are marked as changed. The watchdog is armed again
+  * 	   with the new values by the DMA interrupt.
+  * @param None
+  * @return None
+  */
+static void potis_dma_check_channels(void) {
+	potis_dma_awd_flag = 0;
+
+	for (uint8_t i = 0; i < POTIS_DMA_CHANNELS; i++) {
+		/* POTIS_DMA_1 and POTIS_DMA_2 are the bits 0 and 1 */
+		uint8_t input = 1 << i;
+		uint32_t avg = potis_dma_get_avg(input);
+		uint32_t last = potis_dma_last_value[i];
+		uint32_t diff = (avg > last) ? (avg - last) : (last - avg);
+
+		if (last == POTIS_DMA_NO_VALUE || diff > potis_dma_hysteresis[i]) {
+			potis_dma_last_value[i] = avg;
+			potis_dma_changed |= input;
+		}
+	}
+}
 
+/**
+  * @brief Lets the watchdog supervise a channel and moves the window around its last reported
+  * 	   value, then enables the watchdog interrupt again. Only called from the DMA interrupt.
+  * @param index, index of the channel (0 for POTIS_DMA_1, 1 for POTIS_DMA_2).
+  * @return None
+  */
+static void potis_dma_arm_watchdog(uint8_t index) {
+	ADC_TypeDef *adc = potis_dma_adc_handle_struct.Instance;
+	int32_t last = (int32_t) potis_dma_last_value[index];
+	int32_t low = last - potis_dma_hysteresis[index];
+	int32_t high = last + potis_dma_hysteresis[index];
+
+	if (low < 0) {
+		low = 0;
+	}
+	if (high > 4095) {
+		high = 4095;
+	}
+
+	potis_dma_awd_index = index;
+	MODIFY_REG(adc->CR1, ADC_CR1_AWDCH, potis_dma_adc_channels[index]);
+	adc->LTR = low;
+	adc->HTR = high;
+	__HAL_ADC_CLEAR_FLAG(&potis_dma_adc_handle_struct, ADC_FLAG_AWD);
+	__HAL_ADC_ENABLE_IT(&potis_dma_adc_handle_struct, ADC_IT_AWD);
+}
+
+/**
+  * @brief Runs at the end of each half buffer, after the filter. A fired watchdog is handed to
+  * 	   potis_dma_poll_events() now, because only now the filtered values contain the
+  * 	   movement. Then the watchdog moves on to the next channel.
+  * @param None
+  * @return None
+  */
+static void potis_dma_next_watchdog(void) {
+	if (potis_dma_awd_pending) {
+		potis_dma_awd_pending = 0;
+		potis_dma_awd_flag = 1;
+	}
+	potis_dma_arm_watchdog((potis_dma_awd_index + 1) % POTIS_DMA_CHANNELS);
+}
+
+/**
+  * @brief Interrupt handler for ADC1-3, forwards to the HAL which calls
+  * 	   HAL_ADC_LevelOutOfWindowCallback() for the analog watchdog.
+  * @param None
+  * @return None
+  */
+void ADC_IRQHandler(void) {
+	HAL_ADC_IRQHandler(&potis_dma_adc_handle_struct);
+}
+
+/**
+  * @brief Called when a conversion has left the watchdog window. The interrupt stays
+  * 	   disabled until the end of the half buffer, otherwise every following
+  * 	   conversion would trigger it again.
+  * @param hadc, pointer to the ADC handle.
+  * @return None
+  */
+void HAL_ADC_LevelOutOfWindowCallback(ADC_HandleTypeDef *hadc) {
+	if (hadc == &potis_dma_adc_handle_struct) {
+		__HAL_ADC_DISABLE_IT(hadc, ADC_IT_AWD);
+		potis_dma_awd_pending = 1;
+	}
+}
+
+/**
+  * @brief Filters a completed half of the DMA buffer. For each channel a running median
+  * 	   over POTIS_DMA_MEDIAN_WINDOW samples is taken at every POTIS_DMA_DECIMATION-th
+  * 	   sample, the trimmed mean of these medians is the new value of the channel.
+  * 	   A single spike is removed by the median, the remaining noise is averaged.
+  * @param block, first entry of the completed half, both channels are interleaved.
+  * @return None
+  */
+static void potis_dma_filter_block(const uint32_t *block) {
+	uint32_t medians[POTIS_DMA_BLOCK_LENGTH / POTIS_DMA_DECIMATION];
+	uint16_t count;
+
+	for (uint8_t i = 0; i < POTIS_DMA_CHANNELS; i++) {
+		count = median_block_running(block + i, POTIS_DMA_BLOCK_LENGTH,
+				POTIS_DMA_CHANNELS, POTIS_DMA_MEDIAN_WINDOW, POTIS_DMA_DECIMATION,
+				medians);
+		potis_dma_clean_value[i] = median_block_trimmed_mean(medians, count, 1,
+				POTIS_DMA_TRIM);
+	}
+}
+
+/**
+  * @brief Interrupt handler for DMA2 Stream0, forwards to the HAL which calls
+  * 	   HAL_ADC_ConvHalfCpltCallback() and HAL_ADC_ConvCpltCallback().
+  * @param None
+  * @return None
+  */
+void DMA2_Stream0_IRQHandler(void) {
+	HAL_DMA_IRQHandler(&potis_dma_dma_handle_struct);
+}
+
+/**
+  * @brief Called when the first half of the buffer is filled, the DMA now writes the second half.
+  * @param hadc, pointer to the ADC handle.
+  * @return None
+  */
+void HAL_ADC_ConvHalfCpltCallback(ADC_HandleTypeDef *hadc) {
+	if (hadc == &potis_dma_adc_handle_struct) {
+		potis_dma_filter_block(&dma_address[0]);
+		potis_dma_next_watchdog();
+	}
+}
+
+/**
+  * @brief Called when the second half of the buffer is filled, the DMA starts again at the beginning.
+  * @param hadc, pointer to the ADC handle.
+  * @return None
+  */
+void HAL_ADC_ConvCpltCallback(ADC_HandleTypeDef *hadc) {
+	if (hadc == &potis_dma_adc_handle_struct) {
+		potis_dma_filter_block(&dma_address[POTIS_DMA_BLOCK_LENGTH * POTIS_DMA_CHANNELS]);
+		potis_dma_next_watchdog();
+	}
+}
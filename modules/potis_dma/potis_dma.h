@@ -13,10 +13,38 @@
 /* Public preprocessor macros */
 #define POTIS_DMA_1 1
 #define POTIS_DMA_2 2
+/* Both channels, e.g. for potis_dma_subscribe() */
+#define POTIS_DMA_ALL (POTIS_DMA_1 | POTIS_DMA_2)
+
+#define POTIS_DMA_CHANNELS 2
+/* Default hysteresis band in ADC counts (12 bit) */
+#define POTIS_DMA_HYSTERESIS 16
+#define POTIS_DMA_MAX_SUBSCRIBERS 4
+/* Marks a channel that has not been reported yet */
+#define POTIS_DMA_NO_VALUE 0xFFFFFFFF
+
+/* Scans of both channels per second, started by TIM8. A half of the DMA buffer takes
+ * POTIS_DMA_BLOCK_LENGTH scans, so the DMA interrupt comes 2000 / 50 = 40 times per second
+ * (every 25 ms) and the watchdog interrupt at most as often. In continuous mode it would
+ * be about 420 times per second (96 ADC clocks of 0.25 us per conversion). */
+#define POTIS_DMA_SAMPLE_HZ 2000
+/* Conversions per channel in each half of the DMA buffer */
+#define POTIS_DMA_BLOCK_LENGTH 50
+/* Block filter: median window, every n-th median is kept, medians dropped at each end */
+#define POTIS_DMA_MEDIAN_WINDOW 5
+#define POTIS_DMA_DECIMATION 5
+#define POTIS_DMA_TRIM 2
+
+/* Public types */
+typedef void (*potis_dma_callback_t)(void);
 
 /* Public functions (prototypes) */
 void potis_dma_init(void);
 uint32_t potis_dma_get_avg(uint8_t input);
+void potis_dma_set_hysteresis(uint8_t input, uint16_t band);
+int8_t potis_dma_subscribe(uint8_t input, potis_dma_callback_t callback);
+uint8_t potis_dma_poll_events(void);
+uint8_t potis_dma_wait_events(void);
 
 
 #endif /* POTIS_DMA_POTIS_DMA_H_ */
@@ -0,0 +1,230 @@
+/**
+ **************************************************
+ * @file relay_tune.c
+ * @author Berkay Özgür, C. Arda Sengenc
+ * @version v1.0
+ * @date 17.10.2026
+ * @brief: Relay feedback auto-tuning (Åström-Hägglund): the output is switched between two
+ * levels around the setpoint, the loop oscillates at its ultimate period and the amplitude
+ * gives the ultimate gain. PI gains for pi_ctrl follow from a tuning rule.
+ @verbatim
+ ==================================================
+ ### Resources used ###
+
+ None, the caller calls "relay_tune_update()" once per sample time instead of "pi_ctrl_update()".
+
+ ==================================================
+ ### Principle ###
+
+ Relay: out_high while the measurement is below setpoint - hysteresis, out_low when it
+ rises above setpoint + hysteresis. One cycle lasts from one switch to out_high to the next.
+
+ Ultimate gain: Ku = 4 * d / (pi * sqrt(a^2 - h^2)) with the relay amplitude
+ d = (out_high - out_low) / 2, the oscillation amplitude a (half peak to peak) and the
+ hysteresis h. Ultimate period Tu: the length of one cycle.
+
+ The first RELAY_TUNE_SKIP_CYCLES cycles are not measured, the next RELAY_TUNE_CYCLES are
+ averaged. If this does not happen within the time limit, the run fails. It also fails, if
+ the gains are outside the ranges of pi_ctrl (RELAY_TUNE_MAX_KP, RELAY_TUNE_MAX_KI), e.g. for a
+ tiny amplitude or a very short period, so a controller never gets wrapped gains.
+
+ Rules (Ki = Kp / Ti):
+ Ziegler-Nichols:	Kp = 0.45 * Ku, Ti = Tu / 1.2
+ Tyreus-Luyben:		Kp = Ku / 3.2,  Ti = 2.2 * Tu
+
+ ==================================================
+ ### Usage ###
+
+ (#) Call "relay_tune_start()" with the setpoint, the two output levels, the sample time,
+ the time limit and the rule.
+
+ (#) Call "relay_tune_update()" every sample time with the measurement and use the returned
+ output, until "relay_tune_get_state()" is no longer RELAY_TUNE_RUNNING.
+
+ (#) RELAY_TUNE_DONE: apply the gains with "pi_ctrl_set_gains(pi, tune.kp, tune.ki)".
+
+ @endverbatim
+ **************************************************
+ */
+
+/* Includes */
+#include "relay_tune.h"
+
+/* Module functions (prototypes) */
+static void relay_tune_finish(relay_tune_t *tune);
+static uint32_t relay_tune_sqrt(uint64_t value);
+
+/**
+ * @brief Starts a tuning run, the relay begins with out_high.
+ *
+ * @param tune The tuning run.
+ * @param setpoint Value, around which the loop oscillates.
+ * @param hysteresis Switching band around the setpoint (a bit more than the noise of the measurement).
+ * @param out_low Lower output level.
+ * @param out_high Upper output level.
+ * @param sample_us Time between two calls of relay_tune_update() in microseconds.
+ * @param max_ms Time limit for the run.
+ * @param rule Rule for the calculation of the gains.
+ * @return none
+ */
+void relay_tune_start(relay_tune_t *tune, int32_t setpoint, int32_t hysteresis, int32_t out_low,
+		int32_t out_high, uint32_t sample_us, uint32_t max_ms, relay_tune_rule rule) {
+	tune->setpoint = setpoint;
+	tune->hysteresis = (hysteresis > 0) ? hysteresis : 0;
+	tune->out_low = out_low;
+	tune->out_high = out_high;
+	tune->sample_us = sample_us;
+	tune->max_samples = (uint32_t) (((uint64_t) max_ms * 1000) / sample_us);
+	tune->rule = rule;
+
+	tune->relay_high = 1;
+	tune->cycles = 0;
+	tune->samples = 0;
+	tune->last_rise = 0;
+	tune->peak_max = setpoint;
+	tune->peak_min = setpoint;
+	tune->period_sum = 0;
+	tune->amplitude_sum = 0;
+	tune->ku = 0;
+	tune->tu_us = 0;
+	tune->kp = 0;
+	tune->ki = 0;
+	tune->state = RELAY_TUNE_RUNNING;
+}
+
+/**
+ * @brief Processes one sample of the relay experiment.
+ *
+ * @param tune The tuning run.
+ * @param measurement Measured value.
+ * @return Output for this sample (out_low or out_high, out_low when the run is over).
+ */
+int32_t relay_tune_update(relay_tune_t *tune, int32_t measurement) {
+	if (tune->state != RELAY_TUNE_RUNNING) {
+		return tune->out_low;
+	}
+
+	tune->samples++;
+	if (tune->samples > tune->max_samples) {
+		tune->state = RELAY_TUNE_FAILED;
+		return tune->out_low;
+	}
+
+	if (measurement > tune->peak_max) {
+		tune->peak_max = measurement;
+	}
+	if (measurement < tune->peak_min) {
+		tune->peak_min = measurement;
+	}
+
+	if (tune->relay_high && measurement > tune->setpoint + tune->hysteresis) {
+		tune->relay_high = 0;
+	} else if (!tune->relay_high && measurement < tune->setpoint - tune->hysteresis) {
+		tune->relay_high = 1;
+
+		/* One full cycle since the last switch to out_high (the first one starts at the start) */
+		tune->cycles++;
+		if (tune->cycles > RELAY_TUNE_SKIP_CYCLES) {
+			tune->period_sum += tune->samples - tune->last_rise;
+			tune->amplitude_sum += (uint32_t) (tune->peak_max - tune->peak_min) / 2;
+		}
+		tune->last_rise = tune->samples;
+		tune->peak_max = measurement;
+		tune->peak_min = measurement;
+
+		if (tune->cycles >= RELAY_TUNE_SKIP_CYCLES + RELAY_TUNE_CYCLES) {
+			relay_tune_finish(tune);
+			return tune->out_low;
+		}
+	}
+
+	return tune->relay_high ? tune->out_high : tune->out_low;
+}
+
+/**
+ * @brief Returns the state of a tuning run.
+ * @param tune The tuning run.
+ * @return RELAY_TUNE_RUNNING while the experiment runs, RELAY_TUNE_DONE when kp and ki are valid.
+ */
+relay_tune_state relay_tune_get_state(const relay_tune_t *tune) {
+	return tune->state;
+}
+
+/**
+ * @brief Calculates the ultimate gain and period and the PI gains from the measured cycles.
+ *        The run fails, if a gain is not positive or outside the range of pi_ctrl.
+ * @param tune The tuning run.
+ * @return none
+ */
+static void relay_tune_finish(relay_tune_t *tune) {
+	uint32_t amplitude = tune->amplitude_sum / RELAY_TUNE_CYCLES;
+	uint32_t hysteresis = (uint32_t) tune->hysteresis;
+	int64_t relay = ((int64_t) tune->out_high - tune->out_low) / 2;
+	uint32_t effective;
+	int64_t ku;
+	int64_t kp;
+	int64_t ki;
+
+	/* Amplitude without the share of the hysteresis */
+	if (amplitude <= hysteresis) {
+		tune->state = RELAY_TUNE_FAILED;
+		return;
+	}
+	effective = relay_tune_sqrt((uint64_t) amplitude * amplitude
+			- (uint64_t) hysteresis * hysteresis);
+
+	tune->tu_us = (uint32_t) (((uint64_t) tune->period_sum * tune->sample_us)
+			/ RELAY_TUNE_CYCLES);
+	if (effective == 0 || tune->tu_us == 0) {
+		tune->state = RELAY_TUNE_FAILED;
+		return;
+	}
+
+	/* Ku = 4 * d / (pi * a) in Q16, pi as 31416 / 10000. d < 2^31, so the product stays below 2^63 */
+	ku = (4 * relay * 65536 * 10000) / (31416 * (int64_t) effective);
+	if (ku <= 0 || ku > INT32_MAX) {
+		tune->state = RELAY_TUNE_FAILED;
+		return;
+	}
+	tune->ku = (int32_t) ku;
+
+	/* Ki per second = Kp / Ti with Ti in microseconds. kp < 2^31, so kp * 10^7 stays below 2^63 */
+	if (tune->rule == RELAY_TUNE_TYREUS_LUYBEN) {
+		kp = (ku * 10) / 32;
+		ki = (kp * 10000000) / (22 * (int64_t) tune->tu_us);
+	} else {
+		kp = (ku * 45) / 100;
+		ki = (kp * 1200000) / tune->tu_us;
+	}
+	if (kp <= 0 || kp >= RELAY_TUNE_MAX_KP || ki >= RELAY_TUNE_MAX_KI) {
+		tune->state = RELAY_TUNE_FAILED;
+		return;
+	}
+	tune->kp = (int32_t) kp;
+	tune->ki = (int32_t) ki;
+	tune->state = RELAY_TUNE_DONE;
+}
+
+/**
+ * @brief Integer square root (rounded down), bit by bit without division.
+ * @param value Radicand.
+ * @return floor(sqrt(value)).
+ */
+static uint32_t relay_tune_sqrt(uint64_t value) {
+	uint64_t root = 0;
+	uint64_t bit = (uint64_t) 1 << 62;
+
+	while (bit > value) {
+		bit >>= 2;
+	}
+	while (bit != 0) {
+		if (value >= root + bit) {
+			value -= root + bit;
+			root = (root >> 1) + bit;
+		} else {
+			root >>= 1;
+		}
+		bit >>= 2;
+	}
+	return (uint32_t) root;
+}
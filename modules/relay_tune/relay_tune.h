@@ -0,0 +1,74 @@
+/**
+**************************************************
+* @file relay_tune.h
+* @author Berkay Özgür, C. Arda Sengenc
+* @version v1.0
+* @date 17.10.2026
+* @brief: Header file for the relay feedback auto-tuning of PI controllers.
+**************************************************
+*/
+
+#ifndef RELAY_TUNE_RELAY_TUNE_H_
+#define RELAY_TUNE_RELAY_TUNE_H_
+
+/* Includes */
+#include <stdint.h>
+
+/* Public preprocessor macros */
+/* Oscillation cycles at the start, that are not measured (the loop is still settling) */
+#define RELAY_TUNE_SKIP_CYCLES 2
+/* Oscillation cycles, that are averaged */
+#define RELAY_TUNE_CYCLES 4
+/* Gains (Q16) must stay below the ranges of pi_ctrl (kp below 256, ki below 32768), otherwise the run fails */
+#define RELAY_TUNE_MAX_KP ((int64_t) 256 * 65536)
+#define RELAY_TUNE_MAX_KI ((int64_t) 32768 * 65536)
+
+/* Public enums for the tuning rule */
+typedef enum {
+	RELAY_TUNE_ZIEGLER_NICHOLS,	/* Kp = 0.45 Ku, Ti = Tu / 1.2: fast, some overshoot */
+	RELAY_TUNE_TYREUS_LUYBEN,	/* Kp = Ku / 3.2, Ti = 2.2 Tu: slower, little overshoot */
+} relay_tune_rule;
+
+/* Public enums for the state of a tuning run */
+typedef enum {
+	RELAY_TUNE_IDLE,
+	RELAY_TUNE_RUNNING,
+	RELAY_TUNE_DONE,
+	RELAY_TUNE_FAILED,			/* no steady oscillation within the time limit or gains out of range */
+} relay_tune_state;
+
+/* Public types */
+/* One tuning run, the gains are Q16 like in pi_ctrl */
+typedef struct {
+	/* Configuration */
+	int32_t setpoint;
+	int32_t hysteresis;			// the relay switches at setpoint +- hysteresis (against noise)
+	int32_t out_low;
+	int32_t out_high;
+	uint32_t sample_us;
+	uint32_t max_samples;		// time limit in samples
+	relay_tune_rule rule;
+	/* State */
+	relay_tune_state state;
+	uint8_t relay_high;
+	uint8_t cycles;
+	uint32_t samples;
+	uint32_t last_rise;			// sample of the last switch to out_high
+	int32_t peak_max;
+	int32_t peak_min;
+	uint32_t period_sum;		// in samples
+	uint32_t amplitude_sum;
+	/* Result */
+	int32_t ku;					// ultimate gain (Q16)
+	uint32_t tu_us;				// ultimate period
+	int32_t kp;					// gains for pi_ctrl (Q16)
+	int32_t ki;
+} relay_tune_t;
+
+/* Public functions (prototypes) */
+void relay_tune_start(relay_tune_t *tune, int32_t setpoint, int32_t hysteresis, int32_t out_low, int32_t out_high,
+		uint32_t sample_us, uint32_t max_ms, relay_tune_rule rule);
+int32_t relay_tune_update(relay_tune_t *tune, int32_t measurement);
+relay_tune_state relay_tune_get_state(const relay_tune_t *tune);
+
+#endif /* RELAY_TUNE_RELAY_TUNE_H_ */
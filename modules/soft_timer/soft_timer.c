@@ -0,0 +1,382 @@
+/**
+ **************************************************
+ * @file soft_timer.c
+ * @author Berkay Özgür, C. Arda Sengenc
+ * @version v1.0
+ * @date 17.10.2026
+ * @brief: Software timers (one-shot and periodic) in a hierarchical timer wheel,
+ * all driven by the periodic tick of the timebase, so no hardware timer is needed per feature.
+ @verbatim
+ ==================================================
+ ### Resources used ###
+
+ TIM5: Compare channel 2 of the timebase generates the tick (see timebase.c).
+ No other timer is used.
+
+ ==================================================
+ ### Principle ###
+
+ The wheel has SOFT_TIMER_LEVELS levels with SOFT_TIMER_SLOTS slots each. Level 0 holds
+ the timers, that expire in the next 64 ticks, one slot per tick. Level 1 holds the
+ timers of the next 64*64 ticks, one slot per 64 ticks, and so on.
+
+ Starting a timer calculates its slot from the remaining ticks and puts it at the front
+ of the slot list: O(1). Stopping unlinks it: O(1). On every tick the slot of level 0 is
+ expired. Every 64 ticks the next slot of level 1 is redistributed to level 0 (and every
+ 64*64 ticks level 2 to level 1 ...), so every timer is moved at most SOFT_TIMER_LEVELS - 1
+ times during its life.
+
+ Periodic timers are restarted relative to their last expiry, so they do not drift.
+
+ ==================================================
+ ### Usage ###
+
+ (#) Call "soft_timer_init()" once with the tick period in microseconds (0 for 1 ms).
+
+ (#) Call "soft_timer_setup()" for every timer with its callback. By default the callback
+ only runs in "soft_timer_process()". With SOFT_TIMER_ISR it runs in the tick interrupt,
+ that should only be used for short functions like control loops.
+
+ (#) Call "soft_timer_start()" with the delay and the period in ticks (period 0 for a one-shot),
+ "soft_timer_ms_to_ticks()" converts milliseconds. Call "soft_timer_stop()" to cancel it.
+
+ (#) Call "soft_timer_process()" in the main loop, e.g.
+ while (1) {
+ 	soft_timer_process();
+ 	timebase_idle();
+ }
+
+ A delay of n ticks expires after at least n and at most n + 1 tick periods.
+ If a deferred timer expires again before it was processed, it runs only once.
+
+ @endverbatim
+ **************************************************
+ */
+
+/* Includes */
+#include "stm32f4xx.h"
+#include "soft_timer.h"
+#include <timebase/timebase.h>
+
+/* Preprocessor macros */
+#define SOFT_TIMER_SLOT_MASK (SOFT_TIMER_SLOTS - 1)
+/* Slot of a tick on the given level */
+#define SOFT_TIMER_INDEX(ticks, level) (((ticks) >> ((level) * SOFT_TIMER_SLOT_BITS)) & SOFT_TIMER_SLOT_MASK)
+
+/* Internal flags, the user flags are in the low bits */
+#define SOFT_TIMER_QUEUED 0x40	// in the deferred queue
+#define SOFT_TIMER_PENDING 0x80	// callback still has to be called
+
+/* Module functions (prototypes) */
+static void soft_timer_tick(void);
+static void soft_timer_add(soft_timer_t *timer);
+static void soft_timer_unlink(soft_timer_t *timer);
+static void soft_timer_cascade(uint8_t level);
+static void soft_timer_expire(soft_timer_t *timer);
+static uint32_t soft_timer_lock(void);
+static void soft_timer_unlock(uint32_t primask);
+
+/* Module variables */
+static soft_timer_t *soft_timer_wheel[SOFT_TIMER_LEVELS][SOFT_TIMER_SLOTS];
+/* Next tick, that is processed by the interrupt */
+static volatile uint32_t soft_timer_ticks = 0;
+static uint32_t soft_timer_tick_us = SOFT_TIMER_DEFAULT_TICK_US;
+/* Deferred callbacks (FIFO) */
+static soft_timer_t *soft_timer_queue_head = 0;
+static soft_timer_t *soft_timer_queue_tail = 0;
+
+/**
+ * @brief Initializes the wheel and starts the tick of the timebase.
+ * @param tick_us Tick period in microseconds, 0 for SOFT_TIMER_DEFAULT_TICK_US.
+ * @return none
+ */
+void soft_timer_init(uint32_t tick_us) {
+	soft_timer_tick_us = tick_us ? tick_us : SOFT_TIMER_DEFAULT_TICK_US;
+	timebase_start_tick(soft_timer_tick_us, soft_timer_tick);
+}
+
+/**
+ * @brief Prepares a timer. Must not be called while the timer is running.
+ * @param timer Timer provided by the caller.
+ * @param callback Function, that is called when the timer expires.
+ * @param arg Argument for the callback.
+ * @param flags 0 or SOFT_TIMER_ISR.
+ * @return none
+ */
+void soft_timer_setup(soft_timer_t *timer, soft_timer_callback_t callback,
+		void *arg, uint8_t flags) {
+	timer->next = 0;
+	timer->pprev = 0;
+	timer->queue_next = 0;
+	timer->expires = 0;
+	timer->period = 0;
+	timer->callback = callback;
+	timer->arg = arg;
+	timer->flags = flags & SOFT_TIMER_ISR;
+}
+
+/**
+ * @brief Starts (or restarts) a timer.
+ * @param timer The timer.
+ * @param delay_ticks Ticks until the first expiry.
+ * @param period_ticks Ticks between the following expiries, 0 for a one-shot timer.
+ * @return none
+ */
+void soft_timer_start(soft_timer_t *timer, uint32_t delay_ticks,
+		uint32_t period_ticks) {
+	uint32_t primask = soft_timer_lock();
+
+	soft_timer_unlink(timer);
+	if (delay_ticks > SOFT_TIMER_MAX_DELAY) {
+		delay_ticks = SOFT_TIMER_MAX_DELAY;
+	}
+	if (period_ticks > SOFT_TIMER_MAX_DELAY) {
+		period_ticks = SOFT_TIMER_MAX_DELAY;
+	}
+	timer->expires = soft_timer_ticks + delay_ticks;
+	timer->period = period_ticks;
+	soft_timer_add(timer);
+
+	soft_timer_unlock(primask);
+}
+
+/**
+ * @brief Stops a timer. A deferred callback, that has not run yet, is cancelled too.
+ * @param timer The timer.
+ * @return none
+ */
+void soft_timer_stop(soft_timer_t *timer) {
+	uint32_t primask = soft_timer_lock();
+
+	soft_timer_unlink(timer);
+	timer->flags &= ~SOFT_TIMER_PENDING;
+
+	soft_timer_unlock(primask);
+}
+
+/**
+ * @brief Checks if a timer is waiting for its expiry.
+ * @param timer The timer.
+ * @return 1 if the timer is in the wheel, 0 otherwise.
+ */
+uint8_t soft_timer_is_active(const soft_timer_t *timer) {
+	return timer->pprev != 0;
+}
+
+/**
+ * @brief Calls the deferred callbacks of all expired timers. Must be called in the main loop.
+ * @param none
+ * @return Number of callbacks, that have been called.
+ */
+uint32_t soft_timer_process(void) {
+	uint32_t count = 0;
+	uint32_t primask;
+	soft_timer_t *timer;
+	uint8_t run;
+
+	while (soft_timer_queue_head) {
+		primask = soft_timer_lock();
+		timer = soft_timer_queue_head;
+		soft_timer_queue_head = timer->queue_next;
+		if (!soft_timer_queue_head) {
+			soft_timer_queue_tail = 0;
+		}
+		run = timer->flags & SOFT_TIMER_PENDING;
+		timer->flags &= ~(SOFT_TIMER_QUEUED | SOFT_TIMER_PENDING);
+		soft_timer_unlock(primask);
+
+		/* The callback runs with interrupts enabled and may start or stop timers */
+		if (run) {
+			timer->callback(timer->arg);
+			count++;
+		}
+	}
+	return count;
+}
+
+/**
+ * @brief Converts milliseconds to ticks (rounded up, so the delay is never shorter).
+ * @param ms Time in milliseconds.
+ * @return Time in ticks.
+ */
+uint32_t soft_timer_ms_to_ticks(uint32_t ms) {
+	return (uint32_t) (((uint64_t) ms * 1000 + soft_timer_tick_us - 1)
+			/ soft_timer_tick_us);
+}
+
+/**
+ * @brief Returns the number of ticks since soft_timer_init().
+ * @param none
+ * @return Tick counter.
+ */
+uint32_t soft_timer_get_ticks(void) {
+	return soft_timer_ticks;
+}
+
+/**
+ * @brief Returns the configured tick period.
+ * @param none
+ * @return Tick period in microseconds.
+ */
+uint32_t soft_timer_get_tick_us(void) {
+	return soft_timer_tick_us;
+}
+
+/**
+ * @brief Tick callback of the timebase (interrupt context). Redistributes the higher levels
+ *        when level 0 has wrapped and expires all timers in the current slot.
+ * @param none
+ * @return none
+ */
+static void soft_timer_tick(void) {
+	uint32_t ticks = soft_timer_ticks;
+	uint32_t index = ticks & SOFT_TIMER_SLOT_MASK;
+	uint8_t level = 1;
+	soft_timer_t *head;
+	soft_timer_t *timer;
+
+	/* Level n is only redistributed, when all lower levels have wrapped at the same time */
+	while (index == 0 && level < SOFT_TIMER_LEVELS) {
+		index = SOFT_TIMER_INDEX(ticks, level);
+		soft_timer_cascade(level);
+		level++;
+	}
+
+	/* Take the whole slot into a local list, so periodic timers can be added again while
+	 * walking through it and ISR callbacks can still stop the timers, that are left in it */
+	head = soft_timer_wheel[0][ticks & SOFT_TIMER_SLOT_MASK];
+	soft_timer_wheel[0][ticks & SOFT_TIMER_SLOT_MASK] = 0;
+	if (head) {
+		head->pprev = &head;
+	}
+	soft_timer_ticks = ticks + 1;
+
+	while (head) {
+		timer = head;
+		head = timer->next;
+		if (head) {
+			head->pprev = &head;
+		}
+		timer->next = 0;
+		timer->pprev = 0;
+		soft_timer_expire(timer);
+	}
+}
+
+/**
+ * @brief Handles one expired timer: restarts a periodic timer and calls or queues the callback.
+ * @param timer The expired timer, already removed from the wheel.
+ * @return none
+ */
+static void soft_timer_expire(soft_timer_t *timer) {
+	if (timer->period) {
+		timer->expires += timer->period;
+		soft_timer_add(timer);
+	}
+
+	if (timer->flags & SOFT_TIMER_ISR) {
+		timer->callback(timer->arg);
+		return;
+	}
+
+	timer->flags |= SOFT_TIMER_PENDING;
+	if (!(timer->flags & SOFT_TIMER_QUEUED)) {
+		timer->flags |= SOFT_TIMER_QUEUED;
+		timer->queue_next = 0;
+		if (soft_timer_queue_tail) {
+			soft_timer_queue_tail->queue_next = timer;
+		} else {
+			soft_timer_queue_head = timer;
+		}
+		soft_timer_queue_tail = timer;
+	}
+}
+
+/**
+ * @brief Moves all timers of the current slot of a level one level down (or further).
+ * @param level Level, that is redistributed (1 ... SOFT_TIMER_LEVELS - 1).
+ * @return none
+ */
+static void soft_timer_cascade(uint8_t level) {
+	uint32_t index = SOFT_TIMER_INDEX(soft_timer_ticks, level);
+	soft_timer_t *timer = soft_timer_wheel[level][index];
+	soft_timer_t *next;
+
+	soft_timer_wheel[level][index] = 0;
+	while (timer) {
+		next = timer->next;
+		soft_timer_add(timer);
+		timer = next;
+	}
+}
+
+/**
+ * @brief Puts a timer into the slot, that belongs to its expiry tick. Interrupts must be locked.
+ * @param timer The timer, expires must be set.
+ * @return none
+ */
+static void soft_timer_add(soft_timer_t *timer) {
+	uint32_t delta = timer->expires - soft_timer_ticks;
+	soft_timer_t **slot;
+	uint8_t level = 0;
+
+	if ((int32_t) delta < 0) {
+		/* Already expired, run it with the next tick */
+		timer->expires = soft_timer_ticks;
+		delta = 0;
+	}
+
+	/* Smallest level, whose range covers the remaining ticks */
+	while (level < SOFT_TIMER_LEVELS - 1
+			&& delta >= (1UL << ((level + 1) * SOFT_TIMER_SLOT_BITS))) {
+		level++;
+	}
+
+	slot = &soft_timer_wheel[level][SOFT_TIMER_INDEX(timer->expires, level)];
+	timer->next = *slot;
+	if (timer->next) {
+		timer->next->pprev = &timer->next;
+	}
+	timer->pprev = slot;
+	*slot = timer;
+}
+
+/**
+ * @brief Removes a timer from its slot, if it is in the wheel. Interrupts must be locked.
+ * @param timer The timer.
+ * @return none
+ */
+static void soft_timer_unlink(soft_timer_t *timer) {
+	if (!timer->pprev) {
+		return;
+	}
+	*timer->pprev = timer->next;
+	if (timer->next) {
+		timer->next->pprev = timer->pprev;
+	}
+	timer->next = 0;
+	timer->pprev = 0;
+}
+
+/**
+ * @brief Disables the interrupts, the tick interrupt changes the same lists.
+ * @param none
+ * @return Previous interrupt mask, for soft_timer_unlock().
+ */
+static uint32_t soft_timer_lock(void) {
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	return primask;
+}
+
+/**
+ * @brief Restores the interrupt mask of soft_timer_lock(), so locks may be nested
+ *        (e.g. starting a timer from an ISR callback).
+ * @param primask Value returned by soft_timer_lock().
+ * @return none
+ */
+static void soft_timer_unlock(uint32_t primask) {
+	if (!primask) {
+		__enable_irq();
+	}
+}
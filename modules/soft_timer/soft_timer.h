@@ -0,0 +1,57 @@
+/**
+**************************************************
+* @file soft_timer.h
+* @author Berkay Özgür, C. Arda Sengenc
+* @version v1.0
+* @date 17.10.2026
+* @brief: Header file for the software timer wheel.
+**************************************************
+*/
+
+#ifndef SOFT_TIMER_SOFT_TIMER_H_
+#define SOFT_TIMER_SOFT_TIMER_H_
+
+/* Includes */
+#include <stdint.h>
+
+/* Public preprocessor macros */
+/* Tick period, if soft_timer_init() is called with 0 */
+#define SOFT_TIMER_DEFAULT_TICK_US 1000
+/* Wheel geometry: SOFT_TIMER_LEVELS levels with 2^SOFT_TIMER_SLOT_BITS slots each */
+#define SOFT_TIMER_SLOT_BITS 6
+#define SOFT_TIMER_SLOTS (1 << SOFT_TIMER_SLOT_BITS)
+#define SOFT_TIMER_LEVELS 4
+/* Longest delay in ticks (2^24 - 1, about 4.6 hours with 1 ms ticks), longer ones are clamped */
+#define SOFT_TIMER_MAX_DELAY ((1UL << (SOFT_TIMER_SLOT_BITS * SOFT_TIMER_LEVELS)) - 1)
+
+/* Flags for soft_timer_setup() */
+/* Run the callback directly in the tick interrupt instead of in soft_timer_process() */
+#define SOFT_TIMER_ISR 0x01
+
+/* Public types */
+typedef void (*soft_timer_callback_t)(void *arg);
+
+/* One timer, the memory is provided by the user (usually a global variable of the module) */
+typedef struct soft_timer {
+	struct soft_timer *next;	// next timer in the same slot
+	struct soft_timer **pprev;	// pointer, that points to this timer, 0 if not in the wheel
+	struct soft_timer *queue_next;	// next timer in the deferred queue
+	uint32_t expires;			// tick, at which the timer expires
+	uint32_t period;			// period in ticks, 0 for a one-shot timer
+	soft_timer_callback_t callback;
+	void *arg;
+	volatile uint8_t flags;		// SOFT_TIMER_ISR and internal state
+} soft_timer_t;
+
+/* Public functions (prototypes) */
+void soft_timer_init(uint32_t tick_us);
+void soft_timer_setup(soft_timer_t *timer, soft_timer_callback_t callback, void *arg, uint8_t flags);
+void soft_timer_start(soft_timer_t *timer, uint32_t delay_ticks, uint32_t period_ticks);
+void soft_timer_stop(soft_timer_t *timer);
+uint8_t soft_timer_is_active(const soft_timer_t *timer);
+uint32_t soft_timer_process(void);
+uint32_t soft_timer_ms_to_ticks(uint32_t ms);
+uint32_t soft_timer_get_ticks(void);
+uint32_t soft_timer_get_tick_us(void);
+
+#endif /* SOFT_TIMER_SOFT_TIMER_H_ */
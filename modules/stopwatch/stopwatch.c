@@ -9,10 +9,10 @@
  ==================================================
  ### Resources used ###
  GPIO: GPIOA_PIN_0 for button
- TIMER: Timer 2 for precise counting.
+ TIMEBASE: TIM5 counts microseconds, extended to 64 bit by its overflow interrupt (see timebase).
+ It is the only clock of the stopwatch, no timer of its own is needed.
  EXTI: EXTIO Interrupt Request Handler in order to send interrupt signal when button is pressed.
- TIM2_IRQHandler: Interrupt Request Handler for Timer 2 so it will send an interrupt signal each second (10Khz), so we will be able
- to capture time.
+ It only takes a timestamp from the timebase and puts it into the lap queue.
 
  ==================================================
  ### Usage ###
@@ -21,7 +21,33 @@
  necessary peripheries.
 
  (#) Call "stopwatch_start" at the main-function in while loop for using
- our "stopwatch".
+ our "stopwatch". It also draws the laps, that were taken since the last call.
+
+ (#) Optional: call "stopwatch_set_render()" after "stopwatch_init" to choose text or large
+ digits and the highest frame rate of the running time. With a frame rate the main loop
+ can call "timebase_idle()" after "stopwatch_start", the time between the frames is then
+ spent sleeping (see "stopwatch_get_idle_count()" and "timebase_get_sleep_us()").
+
+ ### Rendering ###
+
+ The running time is only drawn, when the next frame is due. The characters, that are on
+ the display, are cached, so a frame only draws the cells, that have changed (usually the
+ fractions), and large digits only the segments, that have changed. Laps are drawn right
+ away, they do not wait for the next frame.
+
+ ### Time model ###
+
+ The stopwatch only stores microsecond timestamps (start and laps). Minutes, seconds
+ and 1/10000 seconds are derived from the difference when it is drawn, with one 64 bit
+ division and 32 bit arithmetic afterwards. So a lap is exact to the microsecond, no
+ matter when the display is updated.
+
+ ### Lap queue ###
+
+ The button interrupt is the only writer (head), the main loop the only reader (tail),
+ so the ring buffer needs no lock: each side only writes its own index and the
+ timestamp is stored before the head is moved on. If the main loop falls behind by more
+ than STOPWATCH_LAP_QUEUE_SIZE laps, the newest laps are dropped and counted.
 
  @endverbatim
  **************************************************
@@ -30,32 +56,66 @@
 #include <lcd/lcd.h>
 #include "stm32f4xx.h"
 #include <stdio.h>
-#include <my_timer.h>
+#include <my_lcd.h>
 #include <stopwatch.h>
+#include <timebase/timebase.h>
+
+/* Preprocessor macros */
+/* Laps, that can wait for the display, must be a power of two */
+#define STOPWATCH_LAP_QUEUE_SIZE 16
+/* Cells of the running time, that are cached ("mm:ss:ffff" and three digit minutes) */
+#define STOPWATCH_CELLS 12
+/* Position and size of the running time */
+#define STOPWATCH_TIME_X 10
+#define STOPWATCH_TIME_Y 10
+#define STOPWATCH_TEXT_SIZE 2
+/* Character cell of the font of the lcd module (6 pixels wide) in text size 2 */
+#define STOPWATCH_CHAR_CELL (6 * STOPWATCH_TEXT_SIZE)
+/* Cell widths of the large digits, including the gap to the next cell */
+#define STOPWATCH_DIGIT_CELL (MY_LCD_DIGIT_WIDTH + 4)
+#define STOPWATCH_COLON_CELL 10
+/* First line of the laps below the running time */
+#define STOPWATCH_TEXT_FIRST_LAP 1
+#define STOPWATCH_DIGITS_FIRST_LAP 3
+#define STOPWATCH_LAST_LAP 15
 
 /* Module functions (prototypes) */
 void EXTI0_IRQHandler(void);
-void TIM2_IRQHandler(void);
-static void LCD_DisplayTime();
-static void stopwatch_init_timer();
-static void stopwatch_enable_interrupt();
+static void stopwatch_format(char *text, uint64_t elapsed_us);
+static void stopwatch_render(const char *text);
+static void stopwatch_clear(void);
+static void LCD_DisplayTime(uint64_t lap_us);
+static uint8_t stopwatch_lap_push(uint64_t timestamp);
+static uint8_t stopwatch_lap_pop(uint64_t *timestamp);
 static void stopwatch_enable_button();
 
 /* Module variables */
-TIM_HandleTypeDef timer_stopwatch_handle_struct;
-
 /* The variable "start_flag" acts as a flag and checks to see if the timer has been started or not. */
 /* Volatile tells the compiler that the value of the variable may change at any time*/
 volatile uint8_t start_flag = 0;
 
-/* Auxiliary variables for the configuration and the calculation of the time */
-volatile uint8_t minutes = 0;
-volatile uint8_t seconds = 0;
-volatile uint32_t milliseconds = 0;
-
-/* When the key is pressed and an external interrupt is triggered,
- * this variable is incremented by one value to indicate where to write next on LCD. */
-volatile uint8_t line_num = 1;
+/* When a lap is drawn, this variable is incremented by one value to indicate where to write next on LCD. */
+uint8_t line_num = STOPWATCH_TEXT_FIRST_LAP;
+
+/* Rendering of the running time, 0 frames per second means every call draws */
+static stopwatch_render_mode stopwatch_mode = STOPWATCH_RENDER_TEXT;
+static uint32_t stopwatch_frame_us = 0;
+static uint64_t stopwatch_next_frame_us = 0;
+/* Characters on the display, 0 means the cell is unknown or empty */
+static char stopwatch_shown[STOPWATCH_CELLS];
+/* Frames drawn and calls of stopwatch_start(), that had nothing to draw */
+static uint32_t stopwatch_frames = 0;
+static uint32_t stopwatch_idle = 0;
+
+/* Timestamp of the first button press, the laps are measured from here.
+ * Only written by the interrupt before start_flag is set, so the main loop reads it consistently. */
+volatile uint64_t stopwatch_start_us = 0;
+
+/* Lap queue: timestamps in microseconds, head is written by the interrupt, tail by the main loop */
+static uint64_t stopwatch_lap_queue[STOPWATCH_LAP_QUEUE_SIZE];
+static volatile uint32_t stopwatch_lap_head = 0;
+static volatile uint32_t stopwatch_lap_tail = 0;
+volatile uint32_t stopwatch_laps_dropped = 0;
 
 /* Buffer array for printing numbers on the LCD-screen */
 char buf[32];
@@ -64,112 +124,107 @@ char buf[32];
  * @brief Initializes the stopwatch.
  *
  * This function initializes the stopwatch by performing the following steps:
- * - Initializes the timer.
+ * - Initializes the HAL library and the timebase.
  * - Initializes the LCD display.
- * - Enables interrupts for the stopwatch.
  * - Enables button functionality.
  *
  * @note This function calls the following overridden functions:
  * - EXTI0_IRQHandler() to handle external interrupt 0.
- * - TIM2_IRQHandler() to handle timer 2 interrupt.
  *
  * @param None
  * @return None
  */
 void stopwatch_init() {
-	stopwatch_init_timer(); // Initialize the timer.
+	HAL_Init(); // Initialize the HAL library.
 
-	lcd_init(); // Initialize the LCD display.
+	timebase_init(); // Initialize the microsecond timestamps for the time and the laps.
 
-	stopwatch_enable_interrupt(); // Enable interrupts for the stopwatch.
+	lcd_init(); // Initialize the LCD display.
 
 	stopwatch_enable_button(); // Enable button functionality.
 
 	/* Calling the overridden functions */
 	EXTI0_IRQHandler(); // Call the overridden EXTI0_IRQHandler() function to handle external interrupt 0.
-
-	TIM2_IRQHandler(); // Call the overridden TIM2_IRQHandler() function to handle timer 2 interrupt.
 }
 
 /**
  * @brief Starts the stopwatch.
  *
  * This function starts the stopwatch and updates the LCD display if the start flag is set to 1.
- * It retrieves the current milliseconds value from the timer and formats it along with minutes and seconds.
+ * First all laps from the queue are drawn. Then the time since the first button press is read
+ * from the timebase and formatted as minutes, seconds and 1/10000 seconds.
  * The formatted string is then displayed on the LCD.
  *
- * @note This function relies on the start_flag, timer_stopwatch_handle_struct, milliseconds, minutes,
- *       seconds, buf, and lcd_draw_text_at_line() variables.
+ * @note This function relies on the start_flag, stopwatch_start_us, buf, and
+ *       lcd_draw_text_at_line() variables.
  *
  * @param None
  * @return None
  */
 void stopwatch_start() {
+	uint64_t timestamp;
+	uint8_t drawn = 0;
+
+	while (stopwatch_lap_pop(&timestamp)) {
+		LCD_DisplayTime(timestamp - stopwatch_start_us);
+		drawn = 1;
+	}
+
 	if (start_flag == 1) {
-		milliseconds = __HAL_TIM_GET_COUNTER(&timer_stopwatch_handle_struct);
+		timestamp = timebase_now_us64();
+
+		if (stopwatch_frame_us == 0 || timestamp >= stopwatch_next_frame_us) {
+			/* After a long break the frames are not caught up, the next one is one period away */
+			stopwatch_next_frame_us = timestamp + stopwatch_frame_us;
 
-		// Format the time string with minutes, seconds, and milliseconds
-		sprintf(buf, "%2d:%2d:%4lu", minutes, seconds, milliseconds);
+			// Format the time string with minutes, seconds, and 1/10000 seconds
+			stopwatch_format(buf, timestamp - stopwatch_start_us);
 
-		// Update the LCD display with the formatted time string
-		lcd_draw_text_at_line(buf, 0, BLACK, 2, WHITE);
+			// Update the changed cells of the time on the LCD display
+			stopwatch_render(buf);
+			stopwatch_frames++;
+			drawn = 1;
+		}
+	}
+
+	if (!drawn) {
+		stopwatch_idle++;
 	}
 }
 
 /**
- * @brief Initializes the timer for the stopwatch.
- *
- * This function initializes the timer for the stopwatch by performing the following steps:
- * - Calls HAL_Init() to initialize the HAL library.
- * - Initializes Timer2 with a specified mode, period, and prescaler using the my_timer_init() function.
- * - Retrieves the timer handle structure using the my_timer_get_struct() function.
- * - Calls HAL_TIM_Base_Init() to initialize the timer with the retrieved handle structure.
+ * @brief Chooses how the running time is drawn. The screen is cleared, so it should be
+ *        called before the first button press.
  *
- * @note This function relies on the HAL library, my_timer_init(), my_timer_get_struct(), and the
- *       timer_stopwatch_handle_struct variable.
- *
- * @param None
+ * @param mode STOPWATCH_RENDER_TEXT or STOPWATCH_RENDER_DIGITS.
+ * @param max_fps Highest number of frames per second, 0 to draw on every call of stopwatch_start().
  * @return None
  */
-static void stopwatch_init_timer() {
-    HAL_Init(); // Initialize the HAL library.
-
-    // Initialize Timer2 with a specified mode, period, and prescaler using my_timer_init() function.
-    my_timer_init(TIMER_INSTANCE_2, TIMER_MODE_BASE, 10000, 10000);
-
-    // Retrieve the timer handle structure using my_timer_get_struct() function.
-    timer_stopwatch_handle_struct = my_timer_get_struct();
-
-    // Initialize the timer with the retrieved handle structure using HAL_TIM_Base_Init().
-    HAL_TIM_Base_Init(&timer_stopwatch_handle_struct);
+void stopwatch_set_render(stopwatch_render_mode mode, uint16_t max_fps) {
+	stopwatch_mode = mode;
+	stopwatch_frame_us = (max_fps > 0) ? (1000000 + max_fps / 2) / max_fps : 0;
+	stopwatch_next_frame_us = 0;
+	stopwatch_clear();
 }
 
-
 /**
- * @brief Enables interrupts for the stopwatch timer.
- *
- * This function enables interrupts for the stopwatch timer by performing the following steps:
- * - Sets the interrupt priority for Timer2 using the HAL_NVIC_SetPriority() function.
- * - Enables the interrupts for Timer2 using the HAL_NVIC_EnableIRQ() function.
- * - Enables the interrupt update event for the stopwatch timer using the __HAL_TIM_ENABLE_IT() function.
- *
- * @note This function relies on the HAL_NVIC_SetPriority(), HAL_NVIC_EnableIRQ(), and the
- *       timer_stopwatch_handle_struct variable.
- *
+ * @brief Returns the number of frames of the running time, that have been drawn.
  * @param None
- * @return None
+ * @return Frames since the start.
  */
-static void stopwatch_enable_interrupt() {
-    // Set the interrupt priority for Timer2 using HAL_NVIC_SetPriority().
-    HAL_NVIC_SetPriority(TIM2_IRQn, 1, 6);
-
-    // Enable the interrupts for Timer2 using HAL_NVIC_EnableIRQ().
-    HAL_NVIC_EnableIRQ(TIM2_IRQn);
-
-    // Enable the interrupt update event for the stopwatch timer using __HAL_TIM_ENABLE_IT().
-    __HAL_TIM_ENABLE_IT(&timer_stopwatch_handle_struct, TIM_IT_UPDATE);
+uint32_t stopwatch_get_frame_count(void) {
+	return stopwatch_frames;
 }
 
+/**
+ * @brief Returns the number of calls of stopwatch_start(), that had nothing to draw.
+ *        Compared with the frames it shows how much time the frame rate limit has freed.
+ * @param None
+ * @return Idle calls since the start.
+ */
+uint32_t stopwatch_get_idle_count(void) {
+	return stopwatch_idle;
+}
 
 /**
  * @brief Enables interrupts for the user button.
@@ -218,58 +273,28 @@ void EXTI0_IRQHandler(void) {
 	}
 }
 
-/**
- * @brief TIM2_IRQHandler means a Timer2 for Interrupt-Request Handler. Here we check if timer2 has caused any interrupt signal.
- * Timer2 supposed to trigger an interrupt for each second. Because of the timer configuration where period is set 10Khz, which
- * corresponds to 1 second. So we are able to measure time.
- * The Function will call HAL_TIM_IRQHandler which  handles interrupts requests for Timer 2.
- * That is also the reason why we assigned the address of tim_handle_struct here. The general IRQ_Handler will call
- * HAL_TIM_PeriodElapsedCallback method when CALLBACK is set 1.
- *
- * @param None
- * @return None
- */
-void TIM2_IRQHandler(void) {
-	HAL_TIM_IRQHandler(&timer_stopwatch_handle_struct);
-}
-
-/**
- * @brief When the timer triggers an interrupt, the program jumps here and executes the function.
- * The function basically works when the defined timer handler instance(htim) is called with the corresponding
- * timer structure and the start flag is set to 1. When the above conditions are met, we increment the seconds by one, and
- * when the seconds reach 60, as expected, the seconds are reset and the minutes are incremented.
- *
- * @param htim, the pointer for our Timer-Handler, it is declared as global variable.
- * @return none
- */
-void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim) {
-	if (htim == &timer_stopwatch_handle_struct && start_flag == 1) {
-		seconds++;
-		if (seconds >= 60) {
-			seconds = 0;
-			minutes++;
-		}
-	}
-}
-
 /**
  * @brief If the button causes an interrupt(when pressed), the program jumps here and executes the function. The
- * first time the button is pressed, the timer is started. Because the starting flag is set to 0.
+ * first time the button is pressed, its timestamp becomes the start. Because the starting flag is set to 0.
  * It will set to 1 first, after the button is pressed.
- * After that, each time the button is pressed, the lap time is displayed.
- * Once the starting_flag is set to 1, will always call LCD_DisplayTime method to display round time.
+ * After that, each time the button is pressed, the timestamp of the lap is put into the lap queue.
+ * Drawing is left to stopwatch_start() in the main loop, so the interrupt only takes a few microseconds.
  *
  * @param GPIO_Pin, function controls the pin, from which the interrupt comes.
  * @return none
  */
 void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin) {
+	uint64_t timestamp = timebase_now_us64();
+
 	switch (GPIO_Pin) {
 	case GPIO_PIN_0:
 		if (start_flag == 0) {
-			HAL_TIM_Base_Start_IT(&timer_stopwatch_handle_struct);
+			stopwatch_start_us = timestamp;
+			/* The start must be written, before the main loop sees the flag */
+			__DMB();
 			start_flag = 1;
-		} else {
-			LCD_DisplayTime();
+		} else if (!stopwatch_lap_push(timestamp)) {
+			stopwatch_laps_dropped++;
 		}
 		break;
 	default:
@@ -278,23 +303,130 @@ void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin) {
 }
 
 /**
- * @brief Shows the current time on the display.
+ * @brief Formats a time as minutes, seconds and 1/10000 seconds ("mm:ss:ffff").
+ *        Only one 64 bit division is needed, the rest fits into 32 bit.
+ * @param text Buffer for the text (at least 16 characters).
+ * @param elapsed_us Time in microseconds.
+ * @return none
+ */
+static void stopwatch_format(char *text, uint64_t elapsed_us) {
+	uint32_t total_seconds = (uint32_t) (elapsed_us / 1000000);
+	uint32_t fraction = (uint32_t) (elapsed_us - (uint64_t) total_seconds * 1000000);
+
+	sprintf(text, "%2lu:%2lu:%4lu", total_seconds / 60, total_seconds % 60,
+			fraction / 100);
+}
+
+/**
+ * @brief Draws the cells of the running time, that differ from the cache.
+ * @param text Formatted time (see stopwatch_format()).
+ * @return none
+ */
+static void stopwatch_render(const char *text) {
+	uint16_t x = STOPWATCH_TIME_X;
+	uint8_t previous;
+
+	for (uint8_t i = 0; i < STOPWATCH_CELLS && text[i] != '\0'; i++) {
+		char c = text[i];
+
+		if (stopwatch_mode == STOPWATCH_RENDER_TEXT) {
+			if (c != stopwatch_shown[i]) {
+				ILI9341_Draw_Char(c, x, STOPWATCH_TIME_Y, BLACK, STOPWATCH_TEXT_SIZE, WHITE);
+			}
+			x += STOPWATCH_CHAR_CELL;
+		} else if (c == ':') {
+			if (c != stopwatch_shown[i]) {
+				/* The cell may have held a digit before (e.g. three digit minutes) */
+				ILI9341_Draw_Rectangle(x, STOPWATCH_TIME_Y, STOPWATCH_COLON_CELL,
+						MY_LCD_DIGIT_HEIGHT, WHITE);
+				my_lcd_draw_colon(x + 3, STOPWATCH_TIME_Y, BLACK);
+			}
+			x += STOPWATCH_COLON_CELL;
+		} else {
+			if (c != stopwatch_shown[i]) {
+				if (stopwatch_shown[i] >= '0' && stopwatch_shown[i] <= '9') {
+					previous = stopwatch_shown[i] - '0';
+				} else if (stopwatch_shown[i] == ' ') {
+					previous = MY_LCD_DIGIT_BLANK;
+				} else {
+					previous = MY_LCD_DIGIT_NONE;
+				}
+				my_lcd_draw_digit(x, STOPWATCH_TIME_Y,
+						(c >= '0' && c <= '9') ? c - '0' : MY_LCD_DIGIT_BLANK, previous,
+						BLACK, WHITE);
+			}
+			x += STOPWATCH_DIGIT_CELL;
+		}
+		stopwatch_shown[i] = c;
+	}
+}
+
+/**
+ * @brief Clears the screen, forgets the cached cells and starts the laps in the first lap line.
+ * @param none
+ * @return none
+ */
+static void stopwatch_clear(void) {
+	lcd_fill_screen(WHITE);
+	for (uint8_t i = 0; i < STOPWATCH_CELLS; i++) {
+		stopwatch_shown[i] = 0;
+	}
+	line_num = (stopwatch_mode == STOPWATCH_RENDER_DIGITS) ?
+			STOPWATCH_DIGITS_FIRST_LAP : STOPWATCH_TEXT_FIRST_LAP;
+}
+
+/**
+ * @brief Shows a lap time on the display.
  * Each time method is called, number of lines will be increased by one
  * in order to record the timelapse.
  *
- * @param none
+ * @param lap_us Time from the start to the lap in microseconds.
  * @return none
  */
-static void LCD_DisplayTime() {
+static void LCD_DisplayTime(uint64_t lap_us) {
 	char buf[32];
-	sprintf(buf, "%2d:%2d:%4lu", minutes, seconds, milliseconds);
+	/* Same format as the running time: minutes, seconds and 1/10000 seconds */
+	stopwatch_format(buf, lap_us);
 	lcd_draw_text_at_line(buf, line_num, BLACK, 2, WHITE);
 	line_num++;
 	/* If there is no place to write the newest timelapse, the program will
 	 * delete all timelapses and begin from the first line. */
-	if (line_num > 15) {
-		line_num = 1;
-		lcd_fill_screen(WHITE);
+	if (line_num > STOPWATCH_LAST_LAP) {
+		stopwatch_clear();
 	}
 }
 
+/**
+ * @brief Puts a lap timestamp into the queue (only called from the button interrupt).
+ * @param timestamp Timestamp in microseconds.
+ * @return 1 on success, 0 if the queue is full.
+ */
+static uint8_t stopwatch_lap_push(uint64_t timestamp) {
+	uint32_t head = stopwatch_lap_head;
+
+	if (head - stopwatch_lap_tail >= STOPWATCH_LAP_QUEUE_SIZE) {
+		return 0;
+	}
+	stopwatch_lap_queue[head & (STOPWATCH_LAP_QUEUE_SIZE - 1)] = timestamp;
+	/* The entry must be written, before the reader can see the new head */
+	__DMB();
+	stopwatch_lap_head = head + 1;
+	return 1;
+}
+
+/**
+ * @brief Takes the oldest lap timestamp from the queue (only called from the main loop).
+ * @param timestamp Timestamp in microseconds.
+ * @return 1 if there was a lap, 0 if the queue is empty.
+ */
+static uint8_t stopwatch_lap_pop(uint64_t *timestamp) {
+	uint32_t tail = stopwatch_lap_tail;
+
+	if (tail == stopwatch_lap_head) {
+		return 0;
+	}
+	__DMB();
+	*timestamp = stopwatch_lap_queue[tail & (STOPWATCH_LAP_QUEUE_SIZE - 1)];
+	stopwatch_lap_tail = tail + 1;
+	return 1;
+}
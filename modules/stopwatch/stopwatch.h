@@ -13,9 +13,21 @@
 #define STOPWATCH_STOPWATCH_H_
 
 
+/* Includes */
+#include <stdint.h>
+
+/* Public enums for the display of the running time */
+typedef enum {
+	STOPWATCH_RENDER_TEXT,		/* Text of size 2 in the first line */
+	STOPWATCH_RENDER_DIGITS,	/* Large seven segment digits (see my_lcd_draw_digit()) */
+} stopwatch_render_mode;
+
 /* Public functions (prototypes) */
 void stopwatch_init();
 void stopwatch_start();
+void stopwatch_set_render(stopwatch_render_mode mode, uint16_t max_fps);
+uint32_t stopwatch_get_frame_count(void);
+uint32_t stopwatch_get_idle_count(void);
 
 
 
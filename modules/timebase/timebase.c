@@ -0,0 +1,334 @@
+/**
+ **************************************************
+ * @file timebase.c
+ * @author Berkay Özgür, C. Arda Sengenc
+ * @version v1.0
+ * @date 17.10.2026
+ * @brief: One free-running timebase for the whole firmware.
+ @verbatim
+ ==================================================
+ ### Resources used ###
+
+ TIM5: 32 bit timer, counts microseconds from timebase_init() on and is never
+ stopped, reset or reconfigured afterwards. It wraps after about 71 minutes, the update
+ interrupt counts the wraps, so timebase_now_us64() never wraps.
+ Channel 1 (output compare, no pin) wakes the core up at the end of a sleep.
+ Channel 2 (output compare, no pin) generates the periodic tick (e.g. for soft_timer).
+
+ TIM5_IRQHandler: Counts the overflows, acknowledges the wake-up of channel 1, moves the
+ compare value of channel 2 on by one tick period and calls the tick callback.
+
+ DWT: Cycle counter of the Cortex-M4 core (CYCCNT), counts core clock cycles.
+
+ ==================================================
+ ### Usage ###
+
+ (#) Call "timebase_init()" once, every module that needs time may call it, only the
+ first call configures the hardware.
+
+ (#) Call "timebase_now_us()" or "timebase_now_cycles()" to get a timestamp.
+ Durations are always calculated as (now - start) with unsigned 32 bit values,
+ then the result is correct even if the counter has wrapped in between.
+ Call "timebase_now_us64()" for durations, that may be longer than 71 minutes.
+
+ (#) Call "timebase_delay_us()" or "timebase_delay_ms()" to wait (busy wait).
+
+ (#) Call "timebase_sleep_us()" or "timebase_sleep_ms()" to wait with the core in sleep mode (WFI).
+ The compare channel is armed with the deadline, other interrupts (e.g. SysTick) wake
+ the core up too, then it simply goes back to sleep until the deadline has passed.
+
+ (#) Call "timebase_idle()" in a main loop, that has nothing to do until the next interrupt.
+
+ (#) Call "timebase_get_sleep_us()" or "timebase_get_sleep_cycles()" to see how long
+ the core has actually slept.
+
+ (#) Call "timebase_start_tick()" to get a callback in interrupt context every period.
+ There is only one tick, it is meant for a scheduler like soft_timer, not for single features.
+
+ The timestamp and delay functions only read the counters, so they can also be used
+ in interrupts. The sleep functions must only be called from the main loop.
+
+ @endverbatim
+ **************************************************
+ */
+
+/* Includes */
+#include "stm32f4xx.h"
+#include "timebase.h"
+#include <my_timer/my_timer.h>
+
+/* Module functions (prototypes) */
+void TIM5_IRQHandler(void);
+
+/* Module variables */
+TIM_HandleTypeDef timebase_tim_handle_struct;
+static volatile uint8_t timebase_initialized = 0;
+/* Upper 32 bits of the 64 bit microsecond counter, counted by the update interrupt */
+static volatile uint32_t timebase_overflows = 0;
+/* Time the core has spent in WFI */
+static uint64_t timebase_sleep_us_total = 0;
+/* Periodic tick on compare channel 2 */
+static volatile uint32_t timebase_tick_period_us = 0;
+static volatile timebase_tick_callback_t timebase_tick_callback = 0;
+
+/**
+ * @brief Initializes TIM5 as free-running microsecond counter and enables the DWT cycle counter.
+ *        The timer clock is read from RCC (see my_timer_get_clock()).
+ *
+ * @param none
+ * @return none
+ */
+void timebase_init(void) {
+	uint32_t timer_clock;
+
+	if (timebase_initialized) {
+		return;
+	}
+
+	timer_clock = my_timer_get_clock(TIM5);
+
+	__HAL_RCC_TIM5_CLK_ENABLE();
+	timebase_tim_handle_struct.Instance = TIM5;
+	timebase_tim_handle_struct.Init.Prescaler = (timer_clock / TIMEBASE_TICK_HZ) - 1;
+	/* Full 32 bit range, so differences of two timestamps wrap correctly */
+	timebase_tim_handle_struct.Init.Period = 0xFFFFFFFF;
+	timebase_tim_handle_struct.Init.CounterMode = TIM_COUNTERMODE_UP;
+	timebase_tim_handle_struct.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
+	timebase_tim_handle_struct.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_DISABLE;
+	timebase_tim_handle_struct.Init.RepetitionCounter = 0;
+	HAL_TIM_Base_Init(&timebase_tim_handle_struct);
+	HAL_TIM_Base_Start(&timebase_tim_handle_struct);
+	/* The init has set the update flag, from now on it only means an overflow */
+	__HAL_TIM_CLEAR_FLAG(&timebase_tim_handle_struct, TIM_FLAG_UPDATE);
+	__HAL_TIM_ENABLE_IT(&timebase_tim_handle_struct, TIM_IT_UPDATE);
+
+	/* Compare channels 1 and 2 in frozen mode: no pin, only the flag */
+	TIM5->CCMR1 &= ~(TIM_CCMR1_OC1M | TIM_CCMR1_OC2M);
+	HAL_NVIC_SetPriority(TIM5_IRQn, 0, 0);
+	HAL_NVIC_EnableIRQ(TIM5_IRQn);
+
+	/* Cycle counter of the core */
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CYCCNT = 0;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+	timebase_initialized = 1;
+}
+
+/**
+ * @brief Returns the microseconds since timebase_init().
+ * @param none
+ * @return Microsecond counter, wraps after 2^32 us.
+ */
+uint32_t timebase_now_us(void) {
+	return TIM5->CNT;
+}
+
+/**
+ * @brief Returns the microseconds since timebase_init() as 64 bit value, that does not wrap.
+ *        The read is repeated, if the overflow interrupt has run in between. An overflow, whose
+ *        interrupt could not run yet (e.g. interrupts disabled), is seen at the update flag.
+ * @param none
+ * @return Microseconds since timebase_init().
+ */
+uint64_t timebase_now_us64(void) {
+	uint32_t high;
+	uint32_t low;
+	uint32_t pending;
+
+	do {
+		high = timebase_overflows;
+		low = TIM5->CNT;
+		pending = __HAL_TIM_GET_FLAG(&timebase_tim_handle_struct, TIM_FLAG_UPDATE);
+	} while (high != timebase_overflows);
+
+	/* A small value with pending flag was read after the overflow, a large one before it */
+	if (pending && low < 0x80000000) {
+		high++;
+	}
+	return ((uint64_t) high << 32) | low;
+}
+
+/**
+ * @brief Returns the core clock cycles since timebase_init().
+ * @param none
+ * @return Cycle counter, wraps after 2^32 cycles.
+ */
+uint32_t timebase_now_cycles(void) {
+	return DWT->CYCCNT;
+}
+
+/**
+ * @brief Waits for the given number of microseconds.
+ * @param us Time to wait in microseconds.
+ * @return none
+ */
+void timebase_delay_us(uint32_t us) {
+	timebase_init();
+
+	uint32_t start = timebase_now_us();
+	/* Unsigned difference is also correct across the wraparound */
+	while ((timebase_now_us() - start) < us) {
+	}
+}
+
+/**
+ * @brief Waits for the given number of milliseconds.
+ * @param ms Time to wait in milliseconds.
+ * @return none
+ */
+void timebase_delay_ms(uint32_t ms) {
+	/* Millisecond by millisecond, so even long delays do not overflow */
+	while (ms > 0) {
+		timebase_delay_us(1000);
+		ms--;
+	}
+}
+
+/**
+ * @brief Sleeps for the given number of microseconds. The compare channel 1 of TIM5 is set to
+ *        the deadline, then the core waits in WFI. Interrupts are disabled while checking the
+ *        deadline and entering WFI, so a wake-up between the check and WFI cannot get lost
+ *        (a pending interrupt still ends WFI, it is handled after __enable_irq()).
+ * @param us Time to sleep in microseconds.
+ * @return none
+ */
+void timebase_sleep_us(uint32_t us) {
+	timebase_init();
+
+	if (us < TIMEBASE_MIN_SLEEP_US) {
+		timebase_delay_us(us);
+		return;
+	}
+
+	uint32_t start = timebase_now_us();
+	__HAL_TIM_SET_COMPARE(&timebase_tim_handle_struct, TIM_CHANNEL_1, start + us);
+	__HAL_TIM_CLEAR_FLAG(&timebase_tim_handle_struct, TIM_FLAG_CC1);
+	__HAL_TIM_ENABLE_IT(&timebase_tim_handle_struct, TIM_IT_CC1);
+
+	while ((timebase_now_us() - start) < us) {
+		timebase_idle();
+	}
+
+	__HAL_TIM_DISABLE_IT(&timebase_tim_handle_struct, TIM_IT_CC1);
+}
+
+/**
+ * @brief Sleeps for the given number of milliseconds.
+ * @param ms Time to sleep in milliseconds.
+ * @return none
+ */
+void timebase_sleep_ms(uint32_t ms) {
+	/* One second per step, so the microseconds do not overflow */
+	while (ms > 1000) {
+		timebase_sleep_us(1000000);
+		ms -= 1000;
+	}
+	timebase_sleep_us(ms * 1000);
+}
+
+/**
+ * @brief Puts the core to sleep until the next interrupt and counts the time spent sleeping.
+ *        The interrupt mask of the caller is restored afterwards, a caller with disabled
+ *        interrupts is still woken up by a pending interrupt, but it is not handled here.
+ * @param none
+ * @return none
+ */
+void timebase_idle(void) {
+	uint32_t primask = __get_PRIMASK();
+	uint32_t before;
+
+	__disable_irq();
+	before = timebase_now_us();
+	__WFI();
+	timebase_sleep_us_total += timebase_now_us() - before;
+	if (!primask) {
+		__enable_irq();
+	}
+}
+
+/**
+ * @brief Returns the total time the core has spent in timebase_idle() (and the sleep functions).
+ * @param none
+ * @return Sleep time in microseconds.
+ */
+uint64_t timebase_get_sleep_us(void) {
+	return timebase_sleep_us_total;
+}
+
+/**
+ * @brief Returns the total sleep time in core clock cycles, i.e. the cycles, that were not
+ *        spent on work. The DWT counter itself stops in sleep mode, so it is derived from TIM5.
+ * @param none
+ * @return Sleep time in core clock cycles.
+ */
+uint64_t timebase_get_sleep_cycles(void) {
+	return timebase_sleep_us_total * (SystemCoreClock / TIMEBASE_TICK_HZ);
+}
+
+/**
+ * @brief Starts the periodic tick on compare channel 2. The compare value is moved on by the period
+ *        in every interrupt, so the tick does not drift with the interrupt latency.
+ * @param period_us Tick period in microseconds.
+ * @param callback Function, that is called in interrupt context on every tick.
+ * @return none
+ */
+void timebase_start_tick(uint32_t period_us, timebase_tick_callback_t callback) {
+	timebase_init();
+
+	__HAL_TIM_DISABLE_IT(&timebase_tim_handle_struct, TIM_IT_CC2);
+	timebase_tick_period_us = period_us;
+	timebase_tick_callback = callback;
+	__HAL_TIM_SET_COMPARE(&timebase_tim_handle_struct, TIM_CHANNEL_2,
+			timebase_now_us() + period_us);
+	__HAL_TIM_CLEAR_FLAG(&timebase_tim_handle_struct, TIM_FLAG_CC2);
+	__HAL_TIM_ENABLE_IT(&timebase_tim_handle_struct, TIM_IT_CC2);
+}
+
+/**
+ * @brief Stops the periodic tick.
+ * @param none
+ * @return none
+ */
+void timebase_stop_tick(void) {
+	__HAL_TIM_DISABLE_IT(&timebase_tim_handle_struct, TIM_IT_CC2);
+	timebase_tick_callback = 0;
+}
+
+/**
+ * @brief Interrupt handler for TIM5. Counts the overflows. Clears the compare flag of a sleep, the
+ *        interrupt itself has already woken up the core. On the tick compare, it schedules the next tick and calls the
+ *        tick callback.
+ * @param none
+ * @return none
+ */
+void TIM5_IRQHandler(void) {
+	uint32_t next;
+
+	if (__HAL_TIM_GET_FLAG(&timebase_tim_handle_struct, TIM_FLAG_UPDATE)) {
+		__HAL_TIM_CLEAR_FLAG(&timebase_tim_handle_struct, TIM_FLAG_UPDATE);
+		timebase_overflows++;
+	}
+
+	if (__HAL_TIM_GET_FLAG(&timebase_tim_handle_struct, TIM_FLAG_CC1)) {
+		__HAL_TIM_CLEAR_FLAG(&timebase_tim_handle_struct, TIM_FLAG_CC1);
+	}
+
+	if (__HAL_TIM_GET_FLAG(&timebase_tim_handle_struct, TIM_FLAG_CC2)
+			&& __HAL_TIM_GET_IT_SOURCE(&timebase_tim_handle_struct, TIM_IT_CC2)) {
+		__HAL_TIM_CLEAR_FLAG(&timebase_tim_handle_struct, TIM_FLAG_CC2);
+
+		next = __HAL_TIM_GET_COMPARE(&timebase_tim_handle_struct, TIM_CHANNEL_2)
+				+ timebase_tick_period_us;
+		/* If the interrupt was blocked for longer than a period, skip the missed ticks
+		 * instead of waiting a full counter wrap (71 minutes) for the compare */
+		if ((int32_t) (next - timebase_now_us()) <= 0) {
+			next = timebase_now_us() + timebase_tick_period_us;
+		}
+		__HAL_TIM_SET_COMPARE(&timebase_tim_handle_struct, TIM_CHANNEL_2, next);
+
+		if (timebase_tick_callback) {
+			timebase_tick_callback();
+		}
+	}
+}
@@ -0,0 +1,42 @@
+/**
+**************************************************
+* @file timebase.h
+* @author Berkay Özgür, C. Arda Sengenc
+* @version v1.0
+* @date 17.10.2026
+* @brief: Header file for the global monotonic timebase.
+**************************************************
+*/
+
+#ifndef TIMEBASE_TIMEBASE_H_
+#define TIMEBASE_TIMEBASE_H_
+
+/* Includes */
+#include <stdint.h>
+
+/* Public preprocessor macros */
+/* Tick rate of the microsecond counter */
+#define TIMEBASE_TICK_HZ 1000000
+/* Shorter sleeps are busy waits, the wake-up would take longer than the sleep */
+#define TIMEBASE_MIN_SLEEP_US 20
+
+/* Public types */
+/* Called from the TIM5 interrupt on every periodic tick */
+typedef void (*timebase_tick_callback_t)(void);
+
+/* Public functions (prototypes) */
+void timebase_init(void);
+uint32_t timebase_now_us(void);
+uint64_t timebase_now_us64(void);
+uint32_t timebase_now_cycles(void);
+void timebase_delay_us(uint32_t us);
+void timebase_delay_ms(uint32_t ms);
+void timebase_sleep_us(uint32_t us);
+void timebase_sleep_ms(uint32_t ms);
+void timebase_idle(void);
+uint64_t timebase_get_sleep_us(void);
+uint64_t timebase_get_sleep_cycles(void);
+void timebase_start_tick(uint32_t period_us, timebase_tick_callback_t callback);
+void timebase_stop_tick(void);
+
+#endif /* TIMEBASE_TIMEBASE_H_ */
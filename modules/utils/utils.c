@@ -18,9 +18,7 @@
 /* Includes */
 #include "stm32f4xx.h"
 #include <utils.h>
-
-TIM_HandleTypeDef tim_handle_struct_utils;
-uint16_t moin = 0;
+#include <timebase/timebase.h>
 
 void utils_init_gpio(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, uint32_t mode,
 		uint32_t pull, uint32_t alternate, uint32_t speed) {
@@ -54,33 +52,6 @@ void utils_init_gpio(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, uint32_t mode,
 	HAL_GPIO_Init(GPIOx, &gpio_init);
 }
 
-/* Muss auch noch kommentiert werden. Stand: 23.05.23*/
-void utils_init_timer() {
-	HAL_Init();
-
-	__HAL_RCC_TIM1_CLK_ENABLE();
-
-	tim_handle_struct_utils.Instance = TIM1;
-	/* CoreClock ist 16000000 */
-	/* Prescaler ist in der Einleitung 16000000/10000 = 1600 - 1 Hz*/
-	/* Wenn wir 10KHz wollen, sollte nicht dann der Prescaler 10000 sein?? */
-	/* Funktionert der Prescaler so, dass es bei jedem Wert am Ende immer
-	 * CoreClock / Prescaler rauskommt?? Wenn ja, dann brauchen wir für 10KHz -> 1600,
-	 * dann bekommen wir 16000000/1600 = 10000. */
-	/* Wenn man aber 1599 reinschreibt, wird es nicht so wie bei unten!!!!*/
-	tim_handle_struct_utils.Init.Prescaler = (SystemCoreClock / 1000000) - 1;
-	/* Periodendauer ist 9999, entspricht bei 10KHz genau eine Sekunde */
-	tim_handle_struct_utils.Init.Period = 1000000 - 1;
-	/* Aufwärts zahlen lassen */
-	tim_handle_struct_utils.Init.CounterMode = TIM_COUNTERMODE_UP;
-	tim_handle_struct_utils.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
-	tim_handle_struct_utils.Init.AutoReloadPreload =
-			TIM_AUTORELOAD_PRELOAD_DISABLE;
-	/* Hier gibt man an, nach wievielen Überläufen ein Event generiert werden soll */
-	tim_handle_struct_utils.Init.RepetitionCounter = 0;
-	HAL_TIM_Base_Init(&tim_handle_struct_utils);
-}
-
 /**
  * @brief Function for turning just the bit pattern on, others off
  * @param utils_port port which we want to use
@@ -110,24 +81,11 @@ int utils_gpio_port_read(GPIO_TypeDef *utils_port, uint16_t utils_pin) {
 }
 
 /**
- * @brief Function for delay in milliseconds
+ * @brief Function for delay in milliseconds, uses the global timebase (TIM5),
+ * so no timer has to be initialised for each delay. The core sleeps while waiting.
  * @param t time to wait in milliseconds
  * @return none
  */
 void utils_delay_ms(uint32_t t) {
-	utils_init_timer(); /*mach den init woanders*/
-	uint32_t timer = 0;
-
-	//HAL_Delay(t);
-	HAL_TIM_Base_Start(&tim_handle_struct_utils);
-	while (__HAL_TIM_GET_COUNTER(&tim_handle_struct_utils) < t) {
-		timer = __HAL_TIM_GET_COUNTER(&tim_handle_struct_utils);
-		if (timer > 30000) {
-			moin++;
-		}
-
-	}
-	HAL_TIM_Base_Stop(&tim_handle_struct_utils);
-	__HAL_TIM_SET_COUNTER(&tim_handle_struct_utils, 0);
-
+	timebase_sleep_ms(t);
 }
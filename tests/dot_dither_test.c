@@ -0,0 +1,70 @@
+/**
+**************************************************
+* @file dot_dither_test.c
+* @author Berkay Özgür, C. Arda Sengenc
+* @version v1.0
+* @date 17.10.2026
+* @brief: Host test of the compare value dithering of dot_control.
+@verbatim
+==================================================
+### Checks ###
+(#) Every period gets the integer part of the compare value or one more.
+(#) After N periods the sum of the compare values differs from N times the fractional
+	compare value by less than one count, so the mean is exact to 16 bit.
+(#) After 65536 periods the sum is exactly 65536 times the compare value.
+The periods (ARR) and duty cycles are random, as dot_control_set() calculates them.
+The program returns 1 if a check fails.
+==================================================
+@endverbatim
+**************************************************
+*/
+
+/* Includes */
+#include <stdio.h>
+#include <stdlib.h>
+#include <dot_control/dot_control.h>
+
+/* Private preprocessor macros */
+#define DOT_DITHER_TEST_CASES 2000
+
+int main(void) {
+	int failures = 0;
+
+	srand(1);
+	for (int i = 0; i < DOT_DITHER_TEST_CASES; i++) {
+		/* Period (ARR + 1) and duty cycle like in dot_control_set() */
+		uint32_t period = 1 + (uint32_t) rand() % 0x10000;
+		uint32_t duty_q16 = (uint32_t) rand() % 0x10000;
+		uint32_t compare_q16 = period * duty_q16;
+		uint32_t periods = (i % 2) ? 0x10000 : 1 + (uint32_t) rand() % 5000;
+		uint32_t acc = 0;
+		uint64_t sum = 0;
+		int64_t error;
+
+		for (uint32_t n = 0; n < periods; n++) {
+			uint32_t compare = dot_control_dither_step(compare_q16, &acc);
+			if (compare != (compare_q16 >> 16) && compare != (compare_q16 >> 16) + 1) {
+				printf("FAIL: compare %u for %u/65536\n", compare, compare_q16);
+				failures++;
+				break;
+			}
+			sum += compare;
+		}
+
+		/* Difference of the sum to the exact value in Q16, must be below one count */
+		error = (int64_t) (sum << 16) - (int64_t) periods * compare_q16;
+		if (error > 0 || error <= -0x10000 || (periods == 0x10000 && error != 0)) {
+			printf("FAIL: period %u, duty %u/65536, %u periods: mean %.6f instead of %.6f\n",
+					period, duty_q16, periods, (double) sum / periods,
+					compare_q16 / 65536.0);
+			failures++;
+		}
+	}
+
+	if (failures) {
+		printf("dot_dither_test: %d checks failed\n", failures);
+		return 1;
+	}
+	printf("dot_dither_test: all checks passed\n");
+	return 0;
+}
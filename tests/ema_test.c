@@ -0,0 +1,213 @@
+/**
+**************************************************
+* @file ema_test.c
+* @author Berkay Özgür, C. Arda Sengenc
+* @version v1.0
+* @date 17.10.2026
+* @brief: Host test of the fixed-point exponential smoothing (ema.c).
+@verbatim
+==================================================
+### Checks ###
+(#) Step convergence: after a step up and a step down, the output must reach the input exactly,
+	for the slowest coefficients as well (tau = 1 s at 1 ms, shift 12 and 15, alpha 1/32768).
+	With 8 fractional bits they got stuck short of it (998 and 2 of 1000, 992 of 1000).
+(#) Time constant: after tau / T samples a step has covered 1 - (1 - alpha)^(tau / T) of its height
+	(about 1 - 1/e), alpha the Q15 coefficient, that ema_init_time_constant() calculates.
+(#) Rounding: for random inputs the output stays within 1/2 + EMA_TEST_ROUNDING of a double
+	reference with the same coefficient, also for inputs up to 2^32 - 1.
+(#) The first sample after the init and after ema_reset() is taken over directly, alpha 1.0 passes
+	every input unchanged.
+The program returns 1 if a check fails.
+==================================================
+@endverbatim
+**************************************************
+*/
+
+/* Includes */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <ema/ema.h>
+
+/* Private preprocessor macros */
+/* Tolerance of the rounded output against the double reference, beyond the 1/2 of the rounding */
+#define EMA_TEST_ROUNDING 0.02
+#define EMA_TEST_RANDOM_SAMPLES 100000
+
+/* Private types */
+/* One filter configuration */
+typedef struct {
+	const char *name;
+	uint32_t tau_us;			// ema_init_time_constant() if not 0
+	uint32_t sample_us;
+	uint8_t shift;				// ema_init_shift() if not 0
+	uint16_t alpha;				// ema_init_alpha() otherwise
+} ema_test_config_t;
+
+/* Private variables */
+static const ema_test_config_t ema_test_configs[] = {
+	{ "tau 1 s at 1 ms", 1000000, 1000, 0, 0 },
+	{ "tau 10 ms at 1 ms", 10000, 1000, 0, 0 },
+	{ "shift 3", 0, 0, 3, 0 },
+	{ "shift 12", 0, 0, 12, 0 },
+	{ "shift 15", 0, 0, 15, 0 },
+	{ "alpha 1/5", 0, 0, 0, EMA_ALPHA_Q15(1, 5) },
+	{ "alpha 1/32768", 0, 0, 0, 1 },
+};
+static int ema_test_failures = 0;
+
+/**
+ * @brief Initializes a filter with a configuration.
+ */
+static void ema_test_init(ema_t *filter, const ema_test_config_t *config) {
+	if (config->tau_us) {
+		ema_init_time_constant(filter, config->tau_us, config->sample_us);
+	} else if (config->shift) {
+		ema_init_shift(filter, config->shift);
+	} else {
+		ema_init_alpha(filter, config->alpha);
+	}
+}
+
+/**
+ * @brief Returns the coefficient of an initialized filter.
+ */
+static double ema_test_alpha(const ema_t *filter) {
+	return filter->shift ? 1.0 / (1 << filter->shift) : filter->alpha / 32768.0;
+}
+
+/**
+ * @brief Runs a step from one value to another and checks, that the output reaches it.
+ *
+ * @param config Filter configuration.
+ * @param from Start value, the filter is settled there.
+ * @param to Value after the step.
+ */
+static void ema_test_step(const ema_test_config_t *config, uint32_t from, uint32_t to) {
+	ema_t filter;
+	uint32_t output = from;
+	uint32_t samples;
+	uint32_t limit;
+
+	ema_test_init(&filter, config);
+	(void) ema_update(&filter, from);
+
+	/* The error falls by (1 - alpha) per sample, 40 / alpha samples are far beyond the step */
+	limit = (uint32_t) (40.0 / ema_test_alpha(&filter));
+	for (samples = 0; samples < limit && output != to; samples++) {
+		output = ema_update(&filter, to);
+	}
+	if (output != to) {
+		printf("FAIL: %s, step %lu -> %lu: stuck at %lu\n", config->name, (unsigned long) from,
+				(unsigned long) to, (unsigned long) output);
+		ema_test_failures++;
+	}
+}
+
+/**
+ * @brief Feeds random inputs and compares every output with a double reference.
+ *
+ * @param config Filter configuration.
+ * @param range Inputs 0 ... range - 1 (0 for the full 32 bit).
+ */
+static void ema_test_random(const ema_test_config_t *config, uint32_t range) {
+	ema_t filter;
+	double reference;
+	double alpha;
+	uint32_t input;
+	uint32_t output;
+
+	ema_test_init(&filter, config);
+	alpha = ema_test_alpha(&filter);
+	for (uint32_t n = 0; n < EMA_TEST_RANDOM_SAMPLES; n++) {
+		input = ((uint32_t) rand() << 16) ^ (uint32_t) rand();
+		if (range) {
+			input %= range;
+		}
+		output = ema_update(&filter, input);
+		reference = (n == 0) ? input : reference + alpha * (input - reference);
+		if (fabs(output - reference) > 0.5 + EMA_TEST_ROUNDING) {
+			printf("FAIL: %s, range %lu, sample %lu: %lu, reference %.3f\n", config->name,
+					(unsigned long) range, (unsigned long) n, (unsigned long) output, reference);
+			ema_test_failures++;
+			return;
+		}
+	}
+}
+
+/**
+ * @brief Checks the time constant: a step of 100000 after tau / T samples.
+ */
+static void ema_test_time_constant(void) {
+	ema_t filter;
+	uint32_t output = 0;
+	double expected;
+
+	ema_init_time_constant(&filter, 1000000, 1000);
+	if (filter.alpha != EMA_ALPHA_Q15(1000, 1001000)) {
+		printf("FAIL: time constant: alpha %u, expected %u\n", filter.alpha, EMA_ALPHA_Q15(1000, 1001000));
+		ema_test_failures++;
+	}
+	(void) ema_update(&filter, 0);
+	for (int i = 0; i < 1000; i++) {
+		output = ema_update(&filter, 100000);
+	}
+	expected = 100000 * (1.0 - pow(1.0 - ema_test_alpha(&filter), 1000));
+	if (fabs(output - expected) > 1 || fabs(output - 100000 * (1.0 - exp(-1.0))) > 500) {
+		printf("FAIL: time constant: %lu after tau, expected %.1f\n", (unsigned long) output, expected);
+		ema_test_failures++;
+	}
+}
+
+/**
+ * @brief Checks the start value and alpha 1.0.
+ */
+static void ema_test_start(void) {
+	ema_t filter;
+
+	ema_init_shift(&filter, 12);
+	if (ema_update(&filter, 1000) != 1000 || ema_get(&filter) != 1000) {
+		printf("FAIL: first sample not taken over\n");
+		ema_test_failures++;
+	}
+	ema_reset(&filter);
+	if (ema_update(&filter, 0xFFFFFFFF) != 0xFFFFFFFF) {
+		printf("FAIL: first sample after ema_reset() not taken over\n");
+		ema_test_failures++;
+	}
+
+	ema_init_alpha(&filter, 1 << 15);
+	for (uint32_t input = 0; input < 0xF0000000; input += 0x0F123457) {
+		(void) ema_update(&filter, 0xFFFFFFFF - input);
+		if (ema_update(&filter, input) != input) {
+			printf("FAIL: alpha 1.0 changes %lu\n", (unsigned long) input);
+			ema_test_failures++;
+			return;
+		}
+	}
+}
+
+int main(void) {
+	const ema_test_config_t *config;
+
+	srand(1);
+	for (uint32_t i = 0; i < sizeof(ema_test_configs) / sizeof(ema_test_configs[0]); i++) {
+		config = &ema_test_configs[i];
+		ema_test_step(config, 0, 1000);
+		ema_test_step(config, 1000, 0);
+		ema_test_step(config, 0, 1);
+		ema_test_step(config, 4000000000u, 4000000001u);
+		ema_test_step(config, 0xFFFFFFFF, 0);
+		ema_test_random(config, 4096);
+		ema_test_random(config, 0);
+	}
+	ema_test_time_constant();
+	ema_test_start();
+
+	if (ema_test_failures > 0) {
+		printf("ema_test: %d checks failed\n", ema_test_failures);
+		return 1;
+	}
+	printf("ema_test: all checks passed\n");
+	return 0;
+}
@@ -0,0 +1,93 @@
+/**
+**************************************************
+* @file fan_core_test.c
+* @author Berkay Özgür, C. Arda Sengenc
+* @version v1.0
+* @date 17.10.2026
+* @brief: Host test of the RPM calculation of fan_core (fan_core_rpm_from_period()).
+@verbatim
+==================================================
+### Checks ###
+(#) fan_core_rpm_from_period() against the rounded division tick_hz * 60 / (2 * period): every
+	period from 1 to 2^22 ticks, above in steps of 1/4096 up to 2^32 - 1, at most 1 RPM apart.
+	At 1 MHz (the capture timer of fan_control) 2^22 ticks are more than 4 s, far beyond the stall
+	time, and at 10 MHz, the highest counter frequency, for which fan_core documents the bound.
+(#) The period 0 gives 0 RPM.
+The program returns 1 if a check fails.
+==================================================
+@endverbatim
+**************************************************
+*/
+
+/* Includes */
+#include <stdio.h>
+#include <fan_core/fan_core.h>
+
+/* Private preprocessor macros */
+/* Counter frequency of the capture timer on the target (FAN_CONTROL_TACHO_HZ) */
+#define FAN_CORE_TEST_TICK_HZ 1000000
+/* Highest counter frequency with at most 1 RPM error */
+#define FAN_CORE_TEST_MAX_TICK_HZ 10000000
+/* Every period up to this one is checked, above only every 1/4096 */
+#define FAN_CORE_TEST_DENSE_PERIOD (1u << 22)
+
+/**
+ * @brief Sweeps the periods at one counter frequency.
+ *
+ * @param tick_hz Counter frequency of the timestamps.
+ * @return 1 if a period is more than 1 RPM away from the division, 0 otherwise.
+ */
+static int fan_core_test_sweep(uint32_t tick_hz) {
+	uint64_t factor = (uint64_t) tick_hz * 60 / 2;
+	uint64_t period = 1;
+	uint64_t reference;
+	uint32_t rpm;
+	int64_t error;
+	int64_t worst = 0;
+	uint64_t worst_period = 0;
+
+	while (period <= 0xFFFFFFFF) {
+		reference = (factor + period / 2) / period;
+		rpm = fan_core_rpm_from_period(tick_hz, (uint32_t) period);
+		error = (int64_t) rpm - (int64_t) reference;
+		if (error < 0) {
+			error = -error;
+		}
+		if (error > worst) {
+			worst = error;
+			worst_period = period;
+		}
+
+		if (period < FAN_CORE_TEST_DENSE_PERIOD) {
+			period++;
+		} else if (period < 0xFFFFFFFF && period + (period >> 12) + 1 > 0xFFFFFFFF) {
+			period = 0xFFFFFFFF;
+		} else {
+			period += (period >> 12) + 1;
+		}
+	}
+
+	printf("%9lu Hz: largest error %ld RPM (period %llu)  %s\n", (unsigned long) tick_hz,
+			(long) worst, (unsigned long long) worst_period, worst <= 1 ? "PASS" : "FAIL");
+	return worst > 1;
+}
+
+int main(void) {
+	int failures = 0;
+
+	failures += fan_core_test_sweep(FAN_CORE_TEST_TICK_HZ);
+	failures += fan_core_test_sweep(FAN_CORE_TEST_MAX_TICK_HZ);
+
+	if (fan_core_rpm_from_period(FAN_CORE_TEST_TICK_HZ, 0) != 0) {
+		printf("FAIL: period 0 gives %lu RPM\n",
+				(unsigned long) fan_core_rpm_from_period(FAN_CORE_TEST_TICK_HZ, 0));
+		failures++;
+	}
+
+	if (failures > 0) {
+		printf("fan_core_test: %d checks failed\n", failures);
+		return 1;
+	}
+	printf("fan_core_test: all checks passed\n");
+	return 0;
+}
@@ -0,0 +1,340 @@
+/**
+**************************************************
+* @file fan_sim_test.c
+* @author Berkay Özgür, C. Arda Sengenc
+* @version v1.0
+* @date 17.10.2026
+* @brief: Host test of the fan control (fan_core with pi_ctrl and relay_tune) against the simulated fan.
+@verbatim
+==================================================
+### Checks ###
+(#) The simulated fan (fan_sim.c) writes its tacho timestamps into the ring of fan_core like the
+	capture DMA, fan_core_sample() runs every FAN_CORE_SAMPLE_MS simulated milliseconds and its
+	duty goes to the simulated fan like to the PWM. The same code runs in the tick on the target.
+(#) Step responses up and down, large and small, with the default gains, after learning the
+	feed-forward table and after the auto-tuning (Tyreus-Luyben at 2000 RPM): rise time, overshoot,
+	settling time and steady state error of every step must meet the limits (fan_sim_metrics_check()).
+(#) Feed-forward against the same gains without it, step by step: it must settle at least
+	FAN_SIM_TEST_FF_FACTOR times as fast, or, where the duty is at its limit, within
+	FAN_SIM_TEST_FF_BOUND_PERCENT of the fastest settling, that the fan allows (first order from
+	the start speed towards the speed at the duty limit, plus the dead time).
+(#) The same steps with the gains, that P1_Fan_Control ends up with: it learns the table at the
+	idle target of its fan curve (1000 RPM) and starts the auto-tuning (Tyreus-Luyben), as soon as
+	the table is ready.
+(#) The learning of the feed-forward table and the auto-tuning must finish.
+The program returns 1 if a check fails.
+==================================================
+@endverbatim
+**************************************************
+*/
+
+/* Includes */
+#include <math.h>
+#include <stdio.h>
+#include <fan_core/fan_core.h>
+#include <fan_sim/fan_sim.h>
+
+/* Private preprocessor macros */
+/* Counter frequency of the capture timer on the target */
+#define FAN_SIM_TEST_TICK_HZ 1000000
+/* Time, that the fan gets to settle at the start speed before the step */
+#define FAN_SIM_TEST_SETTLE_MS 5000
+/* Simulated time after each step */
+#define FAN_SIM_TEST_STEP_MS 10000
+/* Limit for the learning of the feed-forward table (the sweep takes FAN_CORE_FF_POINTS * FAN_CORE_FF_SETTLE_MS) */
+#define FAN_SIM_TEST_LEARN_MAX_MS (2 * FAN_CORE_FF_POINTS * FAN_CORE_FF_SETTLE_MS)
+/* Feed-forward settles at least FAN_SIM_TEST_FF_FACTOR times as fast as the same gains without it,
+ * or within FAN_SIM_TEST_FF_BOUND_PERCENT of the fastest settling at the duty limit */
+#define FAN_SIM_TEST_FF_FACTOR 2
+#define FAN_SIM_TEST_FF_BOUND_PERCENT 10
+/* Target of P1_Fan_Control below 25 °C, while it learns the table and tunes */
+#define FAN_SIM_TEST_BOARD_RPM 1000
+
+/* Private types */
+/* One step response */
+typedef struct {
+	uint32_t start_rpm;
+	uint32_t target_rpm;
+} fan_sim_test_step_t;
+
+/* Private variables */
+/* A 4500 RPM fan at FAN_CORE_MAX_DUTY, that stands still below 5 % duty, with two tacho pulses
+ * per revolution. It gets the Q15 duty, the compare steps of the PWM are not simulated */
+static const fan_sim_params_t fan_sim_test_params = {
+	.gain = 4500.0f / (FAN_CORE_MAX_DUTY - FAN_CORE_DUTY_Q15(0.05)),
+	.offset_duty = FAN_CORE_DUTY_Q15(0.05),
+	.tau_ms = 800,
+	.dead_ms = 20,
+	.pulses_per_rev = 2,
+	.tick_hz = FAN_SIM_TEST_TICK_HZ,
+};
+
+/* Limits of every step */
+static const fan_sim_metrics_t fan_sim_test_limits = {
+	.rise_ms = 1500,
+	.settling_ms = 3000,
+	.overshoot_rpm = 100,
+	.steady_state_error_rpm = 30,
+};
+
+static const fan_sim_test_step_t fan_sim_test_steps[] = {
+	{ 1000, 3000 },
+	{ 3000, 1000 },
+	{ 500, 4000 },
+	{ 4000, 500 },
+	{ 2000, 2200 },
+	{ 2200, 2000 },
+};
+
+#define FAN_SIM_TEST_STEPS (sizeof(fan_sim_test_steps) / sizeof(fan_sim_test_steps[0]))
+
+static fan_core_t fan_sim_test_core;
+static fan_sim_t fan_sim_test_fan;
+
+/**
+ * @brief Lets the simulated fan and the control start again from rest. The gains and the
+ *        feed-forward table stay.
+ */
+static void fan_sim_test_restart(void) {
+	fan_sim_init(&fan_sim_test_fan, &fan_sim_test_params, fan_sim_test_core.tacho_ring,
+			FAN_CORE_TACHO_RING);
+	fan_core_restart(&fan_sim_test_core);
+}
+
+/**
+ * @brief Advances the simulated fan by one millisecond and runs the control every FAN_CORE_SAMPLE_MS.
+ *
+ * @param ms Simulated milliseconds so far.
+ */
+static void fan_sim_test_ms(uint32_t ms) {
+	fan_sim_step(&fan_sim_test_fan);
+	if (ms % FAN_CORE_SAMPLE_MS == FAN_CORE_SAMPLE_MS - 1) {
+		fan_sim_set_duty(&fan_sim_test_fan, (uint32_t) fan_core_sample(&fan_sim_test_core,
+				fan_sim_get_written(&fan_sim_test_fan)));
+	}
+}
+
+/**
+ * @brief Runs one step response: the fan settles at start_rpm, then the target jumps to target_rpm.
+ *
+ * @param step The step.
+ * @param metrics Result.
+ */
+static void fan_sim_test_step(const fan_sim_test_step_t *step, fan_sim_metrics_t *metrics) {
+	uint32_t ms = 0;
+
+	fan_sim_test_restart();
+	fan_core_set_target(&fan_sim_test_core, step->start_rpm);
+	for (uint32_t i = 0; i < FAN_SIM_TEST_SETTLE_MS; i++) {
+		fan_sim_test_ms(ms++);
+	}
+
+	fan_sim_metrics_start(metrics, fan_sim_get_rpm(&fan_sim_test_fan), step->target_rpm,
+			FAN_SIM_TEST_STEP_MS);
+	fan_core_set_target(&fan_sim_test_core, step->target_rpm);
+	for (uint32_t i = 0; i < FAN_SIM_TEST_STEP_MS; i++) {
+		fan_sim_test_ms(ms++);
+		fan_sim_metrics_add(metrics, fan_sim_get_rpm(&fan_sim_test_fan));
+	}
+}
+
+/**
+ * @brief Runs all steps and prints their metrics.
+ *
+ * @param name Name of the control in the output.
+ * @param metrics Result: metrics of every step (FAN_SIM_TEST_STEPS).
+ * @return Number of steps, that miss the limits.
+ */
+static int fan_sim_test_steps_run(const char *name, fan_sim_metrics_t *metrics) {
+	uint8_t pass;
+	int failures = 0;
+
+	for (uint32_t i = 0; i < FAN_SIM_TEST_STEPS; i++) {
+		fan_sim_test_step(&fan_sim_test_steps[i], &metrics[i]);
+		pass = fan_sim_metrics_check(&metrics[i], &fan_sim_test_limits);
+		printf("%-8s %4lu -> %4lu RPM: rise %5lu ms, overshoot %4lu RPM, settling %5lu ms, "
+				"error %4ld RPM  %s\n", name, (unsigned long) fan_sim_test_steps[i].start_rpm,
+				(unsigned long) fan_sim_test_steps[i].target_rpm, (unsigned long) metrics[i].rise_ms,
+				(unsigned long) metrics[i].overshoot_rpm, (unsigned long) metrics[i].settling_ms,
+				(long) metrics[i].steady_state_error_rpm,
+				pass ? "PASS" : "FAIL");
+		if (!pass) {
+			failures++;
+		}
+	}
+	return failures;
+}
+
+/**
+ * @brief Calculates the fastest settling of a step, that the simulated fan allows: the duty at its
+ *        limit from the step on, the speed follows after the dead time with the time constant
+ *        towards the speed at that duty, until it enters the settling band.
+ *
+ * @param metrics Metrics of the step (start speed and target).
+ * @return Settling time in ms.
+ */
+static uint32_t fan_sim_test_fastest_ms(const fan_sim_metrics_t *metrics) {
+	int32_t direction = (metrics->target_rpm >= metrics->start_rpm) ? 1 : -1;
+	int32_t step = (metrics->target_rpm - metrics->start_rpm) * direction;
+	int32_t band = (step * FAN_SIM_SETTLE_PERCENT) / 100;
+	float limit_duty = (direction > 0) ? FAN_CORE_MAX_DUTY : FAN_CORE_MIN_DUTY;
+	float limit_rpm = fan_sim_test_params.gain * (limit_duty - fan_sim_test_params.offset_duty);
+
+	if (band < FAN_SIM_SETTLE_MIN_RPM) {
+		band = FAN_SIM_SETTLE_MIN_RPM;
+	}
+	return fan_sim_test_params.dead_ms + (uint32_t) (fan_sim_test_params.tau_ms
+			* logf((limit_rpm - metrics->start_rpm) / (limit_rpm - (metrics->target_rpm
+			- direction * band))));
+}
+
+/**
+ * @brief Compares the settling of every step with and without feed-forward (same gains).
+ *
+ * @param without Metrics of the steps without feed-forward.
+ * @param with Metrics of the steps with feed-forward.
+ * @return Number of steps, that feed-forward does not speed up enough.
+ */
+static int fan_sim_test_ff_compare(const fan_sim_metrics_t *without, const fan_sim_metrics_t *with) {
+	uint32_t fastest;
+	uint8_t pass;
+	int failures = 0;
+
+	for (uint32_t i = 0; i < FAN_SIM_TEST_STEPS; i++) {
+		fastest = fan_sim_test_fastest_ms(&with[i]);
+		pass = with[i].settling_ms * FAN_SIM_TEST_FF_FACTOR <= without[i].settling_ms
+				|| with[i].settling_ms * 100 <= fastest * (100 + FAN_SIM_TEST_FF_BOUND_PERCENT);
+		printf("ff gain  %4lu -> %4lu RPM: settling %5lu ms -> %5lu ms (%.1f times as fast), "
+				"at the duty limit %5lu ms  %s\n", (unsigned long) fan_sim_test_steps[i].start_rpm,
+				(unsigned long) fan_sim_test_steps[i].target_rpm, (unsigned long) without[i].settling_ms,
+				(unsigned long) with[i].settling_ms, (double) without[i].settling_ms / with[i].settling_ms,
+				(unsigned long) fastest, pass ? "PASS" : "FAIL");
+		if (!pass) {
+			failures++;
+		}
+	}
+	return failures;
+}
+
+/**
+ * @brief Learns the feed-forward table with the simulated fan from rest.
+ *
+ * @param duration_ms Result: simulated time of the sweep.
+ * @return 1 if the table is used afterwards.
+ */
+static uint8_t fan_sim_test_learn(uint32_t *duration_ms) {
+	uint32_t ms = 0;
+
+	fan_sim_test_restart();
+	fan_core_learn_feedforward(&fan_sim_test_core);
+	do {
+		fan_sim_test_ms(ms++);
+	} while (!fan_core_feedforward_ready(&fan_sim_test_core) && ms < FAN_SIM_TEST_LEARN_MAX_MS);
+	*duration_ms = ms;
+	return fan_core_feedforward_ready(&fan_sim_test_core);
+}
+
+/**
+ * @brief Runs the auto-tuning with the simulated fan, after it has settled at rpm.
+ *
+ * @param rpm Target, around which the relay experiment runs.
+ * @param rule Tuning rule.
+ * @param duration_ms Result: simulated time of the relay experiment.
+ * @return State at the end (RELAY_TUNE_DONE or RELAY_TUNE_FAILED).
+ */
+static relay_tune_state fan_sim_test_autotune(uint32_t rpm, relay_tune_rule rule,
+		uint32_t *duration_ms) {
+	uint32_t ms = 0;
+	relay_tune_state state;
+
+	fan_sim_test_restart();
+	fan_core_set_target(&fan_sim_test_core, rpm);
+	for (uint32_t i = 0; i < FAN_SIM_TEST_SETTLE_MS; i++) {
+		fan_sim_test_ms(ms++);
+	}
+
+	fan_core_autotune(&fan_sim_test_core, rule);
+	*duration_ms = 0;
+	do {
+		fan_sim_test_ms(ms++);
+		(*duration_ms)++;
+		state = fan_core_get_autotune_state(&fan_sim_test_core);
+	} while (state == RELAY_TUNE_RUNNING);
+	return state;
+}
+
+/**
+ * @brief Runs the auto-tuning as soon as the feed-forward table has been learned, like P1_Fan_Control.
+ *
+ * @param duration_ms Result: simulated time of the relay experiment.
+ * @return State at the end (RELAY_TUNE_DONE or RELAY_TUNE_FAILED).
+ */
+static relay_tune_state fan_sim_test_board(uint32_t *duration_ms) {
+	relay_tune_state state;
+
+	fan_core_init(&fan_sim_test_core, FAN_SIM_TEST_TICK_HZ);
+	fan_core_set_target(&fan_sim_test_core, FAN_SIM_TEST_BOARD_RPM);
+	if (!fan_sim_test_learn(duration_ms)) {
+		return RELAY_TUNE_FAILED;
+	}
+
+	fan_core_autotune(&fan_sim_test_core, RELAY_TUNE_TYREUS_LUYBEN);
+	*duration_ms = 0;
+	do {
+		fan_sim_test_ms(*duration_ms);
+		(*duration_ms)++;
+		state = fan_core_get_autotune_state(&fan_sim_test_core);
+	} while (state == RELAY_TUNE_RUNNING && *duration_ms < 2 * FAN_CORE_TUNE_MAX_MS);
+	return state;
+}
+
+int main(void) {
+	fan_sim_metrics_t without_ff[FAN_SIM_TEST_STEPS];
+	fan_sim_metrics_t metrics[FAN_SIM_TEST_STEPS];
+	int failures = 0;
+	uint32_t duration_ms;
+	relay_tune_state state;
+
+	fan_core_init(&fan_sim_test_core, FAN_SIM_TEST_TICK_HZ);
+
+	failures += fan_sim_test_steps_run("default", without_ff);
+
+	if (fan_sim_test_learn(&duration_ms)) {
+		printf("feed-forward table learned in %lu ms\n", (unsigned long) duration_ms);
+		failures += fan_sim_test_steps_run("ff", metrics);
+		failures += fan_sim_test_ff_compare(without_ff, metrics);
+	} else {
+		printf("FAIL: feed-forward table not learned after %lu ms\n", (unsigned long) duration_ms);
+		failures++;
+	}
+
+	state = fan_sim_test_autotune(2000, RELAY_TUNE_TYREUS_LUYBEN, &duration_ms);
+	if (state == RELAY_TUNE_DONE) {
+		printf("auto-tuning done in %lu ms: Ku %.1f, Tu %lu ms, kp %.1f, ki %.1f (Q15 duty per RPM)\n",
+				(unsigned long) duration_ms, fan_sim_test_core.tune.ku / 65536.0,
+				(unsigned long) (fan_sim_test_core.tune.tu_us / 1000),
+				fan_sim_test_core.kp / 65536.0, fan_sim_test_core.ki / 65536.0);
+		failures += fan_sim_test_steps_run("ff+tuned", metrics);
+	} else {
+		printf("FAIL: auto-tuning failed after %lu ms\n", (unsigned long) duration_ms);
+		failures++;
+	}
+
+	state = fan_sim_test_board(&duration_ms);
+	if (state == RELAY_TUNE_DONE) {
+		printf("auto-tuning of the board done in %lu ms: kp %.1f, ki %.1f (Q15 duty per RPM)\n",
+				(unsigned long) duration_ms, fan_sim_test_core.kp / 65536.0,
+				fan_sim_test_core.ki / 65536.0);
+		failures += fan_sim_test_steps_run("board", metrics);
+	} else {
+		printf("FAIL: auto-tuning of the board failed after %lu ms\n", (unsigned long) duration_ms);
+		failures++;
+	}
+
+	if (failures > 0) {
+		printf("fan_sim_test: %d checks failed\n", failures);
+		return 1;
+	}
+	printf("fan_sim_test: all checks passed\n");
+	return 0;
+}
@@ -0,0 +1,52 @@
+/**
+**************************************************
+* @file host_timebase.c
+* @author Berkay Özgür, C. Arda Sengenc
+* @version v1.0
+* @date 17.10.2026
+* @brief: Host replacement of the timebase module for the host tests. The timestamps come
+*         from the monotonic clock of the host, one "cycle" is one nanosecond.
+**************************************************
+*/
+
+/* Includes */
+#include <time.h>
+#include <timebase/timebase.h>
+
+/**
+ * @brief Nothing to configure on the host.
+ * @param none
+ * @return none
+ */
+void timebase_init(void) {
+}
+
+/**
+ * @brief Returns the nanoseconds of the monotonic clock as 64 bit value.
+ * @param none
+ * @return Nanoseconds.
+ */
+static uint64_t host_timebase_now_ns(void) {
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t) now.tv_sec * 1000000000u + (uint64_t) now.tv_nsec;
+}
+
+/**
+ * @brief Returns the microseconds of the monotonic clock.
+ * @param none
+ * @return Microsecond counter, wraps after 2^32 us.
+ */
+uint32_t timebase_now_us(void) {
+	return (uint32_t) (host_timebase_now_ns() / 1000u);
+}
+
+/**
+ * @brief Returns the nanoseconds of the monotonic clock instead of the core clock cycles.
+ * @param none
+ * @return Nanosecond counter, wraps after 2^32 ns.
+ */
+uint32_t timebase_now_cycles(void) {
+	return (uint32_t) host_timebase_now_ns();
+}
@@ -0,0 +1,237 @@
+/**
+**************************************************
+* @file median_bench.c
+* @author Berkay Özgür, C. Arda Sengenc
+* @version v1.0
+* @date 17.10.2026
+* @brief: Host test and benchmark of the median kernels.
+@verbatim
+==================================================
+### Checks ###
+(#) median_kernel() and the sorting networks median_kernel_3/5/7/9() return the same value as
+	qsort() for random lists of every length from 1 to MEDIAN_KERNEL_MAX_LENGTH.
+(#) median_sort_list(), the bubble sort of median_get_median() before the networks, returns the
+	same median as qsort().
+(#) median_kernel() rejects the lengths 0 and MEDIAN_KERNEL_MAX_LENGTH + 1 and leaves the
+	result untouched.
+(#) median_block_running() rejects a window of 0.
+
+### Benchmark ###
+Nanoseconds per median for the networks, median_kernel(), median_sort_list() (bubble sort, the
+former median_get_median()), an insertion sort and qsort(), and how many times as fast the
+networks are as median_sort_list().
+The numbers are from the host, on the Cortex-M4 use median_benchmark().
+The program returns 1 if a check fails.
+==================================================
+@endverbatim
+**************************************************
+*/
+
+/* Includes */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <median/median.h>
+
+/* Private preprocessor macros */
+#define MEDIAN_BENCH_CHECK_RUNS 2000
+#define MEDIAN_BENCH_RUNS 200000
+
+/* Module functions of median.c without a prototype in median.h */
+void median_sort_list(uint32_t *list, uint32_t *srcList, uint16_t length);
+
+/* Private variables */
+static int median_bench_failures = 0;
+/* Written by the benchmark loops, so the compiler cannot drop them */
+static volatile uint32_t median_bench_sink;
+
+/**
+ * @brief Compare function for qsort().
+ */
+static int median_bench_compare(const void *a, const void *b) {
+	uint32_t x = *(const uint32_t *) a;
+	uint32_t y = *(const uint32_t *) b;
+
+	return (x > y) - (x < y);
+}
+
+/**
+ * @brief Reference median: sorts a copy with qsort().
+ */
+static uint32_t median_bench_qsort(const uint32_t *values, uint16_t length) {
+	uint32_t list[MEDIAN_KERNEL_MAX_LENGTH];
+
+	for (uint16_t i = 0; i < length; i++) {
+		list[i] = values[i];
+	}
+	qsort(list, length, sizeof(list[0]), median_bench_compare);
+	return list[length / 2];
+}
+
+/**
+ * @brief Median with median_sort_list() (bubble sort of a copy), the sort used before the networks.
+ */
+static uint32_t median_bench_sort_list(const uint32_t *values, uint16_t length) {
+	uint32_t list[MEDIAN_KERNEL_MAX_LENGTH];
+
+	median_sort_list(list, (uint32_t *) values, length);
+	return list[length / 2];
+}
+
+/**
+ * @brief Median with a plain insertion sort of a copy.
+ */
+static uint32_t median_bench_insertion(const uint32_t *values, uint16_t length) {
+	uint32_t list[MEDIAN_KERNEL_MAX_LENGTH];
+	uint16_t i, j;
+
+	for (j = 0; j < length; j++) {
+		uint32_t tmp = values[j];
+		for (i = j; (i > 0) && (list[i - 1] > tmp); i--) {
+			list[i] = list[i - 1];
+		}
+		list[i] = tmp;
+	}
+	return list[length / 2];
+}
+
+/**
+ * @brief Fills a list with random values, some lists have many equal values.
+ */
+static void median_bench_fill(uint32_t *values, uint16_t length, uint32_t range) {
+	for (uint16_t i = 0; i < length; i++) {
+		values[i] = (uint32_t) rand() % range;
+	}
+}
+
+/**
+ * @brief Counts and prints a failed check.
+ */
+static void median_bench_expect(int ok, const char *what, uint16_t length) {
+	if (!ok) {
+		printf("FAIL: %s (length %u)\n", what, length);
+		median_bench_failures++;
+	}
+}
+
+/**
+ * @brief Checks median_kernel() and the networks against qsort().
+ */
+static void median_bench_check_kernels(void) {
+	uint32_t values[MEDIAN_KERNEL_MAX_LENGTH + 1];
+	uint32_t median;
+	uint32_t reference;
+
+	for (uint16_t length = 1; length <= MEDIAN_KERNEL_MAX_LENGTH; length++) {
+		for (int run = 0; run < MEDIAN_BENCH_CHECK_RUNS; run++) {
+			median_bench_fill(values, length, (run % 2) ? 8 : 100000);
+			reference = median_bench_qsort(values, length);
+
+			median_bench_expect(median_bench_sort_list(values, length) == reference,
+					"median_sort_list", length);
+
+			median = ~reference;
+			median_bench_expect(median_kernel(values, length, &median) == 0
+					&& median == reference, "median_kernel", length);
+
+			if (length == 3) {
+				median_bench_expect(median_kernel_3(values) == reference, "median_kernel_3", length);
+			} else if (length == 5) {
+				median_bench_expect(median_kernel_5(values) == reference, "median_kernel_5", length);
+			} else if (length == 7) {
+				median_bench_expect(median_kernel_7(values) == reference, "median_kernel_7", length);
+			} else if (length == 9) {
+				median_bench_expect(median_kernel_9(values) == reference, "median_kernel_9", length);
+			}
+		}
+	}
+
+	median = 12345;
+	median_bench_expect(median_kernel(values, 0, &median) == -1 && median == 12345,
+			"median_kernel accepts length 0", 0);
+	median_bench_expect(median_kernel(values, MEDIAN_KERNEL_MAX_LENGTH + 1, &median) == -1
+			&& median == 12345, "median_kernel accepts a too long list", MEDIAN_KERNEL_MAX_LENGTH + 1);
+	median_bench_expect(median_block_running(values, 8, 1, 0, 1, values) == 0,
+			"median_block_running accepts window 0", 0);
+}
+
+/**
+ * @brief Returns the nanoseconds of the monotonic clock.
+ */
+static double median_bench_now_ns(void) {
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec * 1e9 + now.tv_nsec;
+}
+
+/**
+ * @brief Times one median function over MEDIAN_BENCH_RUNS random lists.
+ * @return Nanoseconds per median.
+ */
+static double median_bench_time(uint32_t (*median)(const uint32_t *, uint16_t),
+		const uint32_t *lists, uint16_t length) {
+	double start = median_bench_now_ns();
+
+	for (int run = 0; run < MEDIAN_BENCH_RUNS; run++) {
+		median_bench_sink = median(&lists[(run % 64) * length], length);
+	}
+	return (median_bench_now_ns() - start) / MEDIAN_BENCH_RUNS;
+}
+
+/* Adapters with the signature of median_bench_time() */
+static uint32_t median_bench_network(const uint32_t *values, uint16_t length) {
+	switch (length) {
+	case 3:
+		return median_kernel_3(values);
+	case 5:
+		return median_kernel_5(values);
+	case 7:
+		return median_kernel_7(values);
+	default:
+		return median_kernel_9(values);
+	}
+}
+
+static uint32_t median_bench_kernel(const uint32_t *values, uint16_t length) {
+	uint32_t median = 0;
+
+	(void) median_kernel(values, length, &median);
+	return median;
+}
+
+/**
+ * @brief Prints the time per median of each method for the lengths with a network.
+ */
+static void median_bench_run(void) {
+	static const uint16_t lengths[] = { 3, 5, 7, 9 };
+	static uint32_t lists[64 * 9];
+
+	median_bench_fill(lists, 64 * 9, 4096);
+
+	printf("length  network  median_kernel  sort_list  insertion  qsort  speed-up   (ns per median, "
+			"speed-up of the network over sort_list)\n");
+	for (unsigned i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++) {
+		uint16_t length = lengths[i];
+		double network = median_bench_time(median_bench_network, lists, length);
+		double sort_list = median_bench_time(median_bench_sort_list, lists, length);
+
+		printf("%6u  %7.1f  %13.1f  %9.1f  %9.1f  %5.1f  %7.1fx\n", length, network,
+				median_bench_time(median_bench_kernel, lists, length), sort_list,
+				median_bench_time(median_bench_insertion, lists, length),
+				median_bench_time(median_bench_qsort, lists, length), sort_list / network);
+	}
+}
+
+int main(void) {
+	srand(1);
+	median_bench_check_kernels();
+	median_bench_run();
+
+	if (median_bench_failures) {
+		printf("median_bench: %d checks failed\n", median_bench_failures);
+		return 1;
+	}
+	printf("median_bench: all checks passed\n");
+	return 0;
+}
@@ -0,0 +1,317 @@
+/**
+**************************************************
+* @file median_test.c
+* @author Berkay Özgür, C. Arda Sengenc
+* @version v1.0
+* @date 17.10.2026
+* @brief: Host test of the sliding median filter (median_filter_init(), median_filter_update()) and
+* of the block functions median_block_hampel() and median_block_trimmed_mean().
+@verbatim
+==================================================
+### Checks ###
+(#) median_filter_update() against a brute force reference, sample by sample: the last length
+	inputs (zeros from the init before the first ones) are sorted with qsort(). The median, the
+	whole sorted list of the filter and median_filter_get() must match it.
+(#) Lengths 1, 3, 5 and 9 with random values of a wide range, of a range with many duplicates,
+	constant, rising and falling inputs.
+(#) median_filter_init() rejects the length 0 and even lengths and leaves the filter untouched.
+(#) median_block_hampel() on a noisy signal with injected spikes (also interleaved with a stride):
+	exactly the spikes are replaced, by the median of their window, every other value stays.
+	A signal near 3e9 with a MAD of 20000, whose threshold k * 1.4826 * MAD does not fit into
+	32 bit, must not lose values to a wrapped threshold.
+(#) median_block_trimmed_mean() against known means: spikes on both sides trimmed away, without
+	trim, trim clamped to MEDIAN_TRIM_MAX, trim too large for the count, a stride and values,
+	whose sum does not fit into 32 bit.
+The program returns 1 if a check fails.
+==================================================
+@endverbatim
+**************************************************
+*/
+
+/* Includes */
+#include <stdio.h>
+#include <stdlib.h>
+#include <median/median.h>
+
+/* Private preprocessor macros */
+#define MEDIAN_TEST_MAX_LENGTH 9
+#define MEDIAN_TEST_SAMPLES 5000
+#define MEDIAN_TEST_BLOCK 64
+
+/* Private types */
+/* Input sequences of the filter test */
+typedef enum {
+	MEDIAN_TEST_WIDE,			// random values of a wide range
+	MEDIAN_TEST_DUPLICATES,		// random values 0 ... 3, nearly every value is in the window twice
+	MEDIAN_TEST_CONSTANT,
+	MEDIAN_TEST_RISING,
+	MEDIAN_TEST_FALLING,
+	MEDIAN_TEST_INPUTS
+} median_test_input_t;
+
+/* Private variables */
+static const char *median_test_input_names[MEDIAN_TEST_INPUTS] = {
+	"wide", "duplicates", "constant", "rising", "falling"
+};
+static int median_test_failures = 0;
+
+/**
+ * @brief Compare function for qsort().
+ */
+static int median_test_compare(const void *a, const void *b) {
+	uint32_t x = *(const uint32_t *) a;
+	uint32_t y = *(const uint32_t *) b;
+
+	return (x > y) - (x < y);
+}
+
+/**
+ * @brief Returns the input number n of a sequence.
+ */
+static uint32_t median_test_input(median_test_input_t input, uint32_t n) {
+	switch (input) {
+	case MEDIAN_TEST_WIDE:
+		return ((uint32_t) rand() << 16) ^ (uint32_t) rand();
+	case MEDIAN_TEST_DUPLICATES:
+		return (uint32_t) rand() % 4;
+	case MEDIAN_TEST_CONSTANT:
+		return 42;
+	case MEDIAN_TEST_RISING:
+		return n * 3;
+	default:
+		return 0xFFFFFFFF - n * 3;
+	}
+}
+
+/**
+ * @brief Runs one sequence through a filter and the reference.
+ *
+ * @param length Window length.
+ * @param input Input sequence.
+ */
+static void median_test_filter(uint16_t length, median_test_input_t input) {
+	uint32_t buffer[MEDIAN_FILTER_BUFFER_SIZE(MEDIAN_TEST_MAX_LENGTH)];
+	uint32_t history[MEDIAN_TEST_MAX_LENGTH] = { 0 };
+	uint32_t sorted[MEDIAN_TEST_MAX_LENGTH];
+	median_filter_t filter;
+	uint32_t value;
+	uint32_t median;
+
+	if (median_filter_init(&filter, buffer, length) != 0) {
+		printf("FAIL: length %u rejected\n", length);
+		median_test_failures++;
+		return;
+	}
+
+	for (uint32_t n = 0; n < MEDIAN_TEST_SAMPLES; n++) {
+		value = median_test_input(input, n);
+		median = median_filter_update(&filter, value);
+
+		history[n % length] = value;
+		for (uint16_t i = 0; i < length; i++) {
+			sorted[i] = history[i];
+		}
+		qsort(sorted, length, sizeof(sorted[0]), median_test_compare);
+
+		for (uint16_t i = 0; i < length; i++) {
+			if (filter.sortedList[i] != sorted[i]) {
+				printf("FAIL: length %u, %s, sample %lu: sorted list [%u] is %lu, reference %lu\n",
+						length, median_test_input_names[input], (unsigned long) n, i,
+						(unsigned long) filter.sortedList[i], (unsigned long) sorted[i]);
+				median_test_failures++;
+				return;
+			}
+		}
+		if (median != sorted[length / 2] || median_filter_get(&filter) != median) {
+			printf("FAIL: length %u, %s, sample %lu: median %lu, get %lu, reference %lu\n",
+					length, median_test_input_names[input], (unsigned long) n,
+					(unsigned long) median, (unsigned long) median_filter_get(&filter),
+					(unsigned long) sorted[length / 2]);
+			median_test_failures++;
+			return;
+		}
+	}
+}
+
+/**
+ * @brief Checks, that median_filter_init() rejects a length and does not touch the filter.
+ *
+ * @param length Invalid window length.
+ */
+static void median_test_reject(uint16_t length) {
+	uint32_t buffer[MEDIAN_FILTER_BUFFER_SIZE(MEDIAN_TEST_MAX_LENGTH + 1)] = { 0 };
+	median_filter_t filter = { 0, 0, 7, 3 };
+
+	if (median_filter_init(&filter, buffer, length) != -1 || filter.ringBuffer != 0
+			|| filter.sortedList != 0 || filter.length != 7 || filter.pos != 3) {
+		printf("FAIL: median_filter_init accepts length %u\n", length);
+		median_test_failures++;
+	}
+}
+
+/**
+ * @brief Runs median_block_hampel() on a block and compares it with the expected output.
+ *
+ * @param name Name of the case in the output.
+ * @param src Block, stride values apart.
+ * @param stride Distance of two values.
+ * @param expected Expected output (dense).
+ * @param outliers Expected number of replaced values.
+ */
+static void median_test_hampel_block(const char *name, const uint32_t *src, uint16_t stride,
+		const uint32_t *expected, uint16_t outliers) {
+	uint32_t dst[MEDIAN_TEST_BLOCK];
+	uint16_t replaced = median_block_hampel(src, MEDIAN_TEST_BLOCK, stride, 7, MEDIAN_HAMPEL_K3, dst);
+
+	if (replaced != outliers) {
+		printf("FAIL: hampel %s: %u values replaced, expected %u\n", name, replaced, outliers);
+		median_test_failures++;
+		return;
+	}
+	for (uint16_t i = 0; i < MEDIAN_TEST_BLOCK; i++) {
+		if (dst[i] != expected[i]) {
+			printf("FAIL: hampel %s: value %u is %lu, expected %lu\n", name, i,
+					(unsigned long) dst[i], (unsigned long) expected[i]);
+			median_test_failures++;
+			return;
+		}
+	}
+}
+
+/**
+ * @brief Checks median_block_hampel() with injected spikes and with a large MAD.
+ */
+static void median_test_hampel(void) {
+	static const uint16_t spikes[] = { 0, 9, 10, 31, 63 };
+	uint32_t src[2 * MEDIAN_TEST_BLOCK];
+	uint32_t expected[MEDIAN_TEST_BLOCK];
+	uint32_t interleaved[2 * MEDIAN_TEST_BLOCK];
+	uint32_t window[7];
+	uint16_t start;
+
+	/* Noise 1000 ... 1004, a spike far above or below replaces a value */
+	for (uint16_t i = 0; i < MEDIAN_TEST_BLOCK; i++) {
+		src[i] = 1000 + (i * 7) % 5;
+	}
+	for (uint16_t i = 0; i < sizeof(spikes) / sizeof(spikes[0]); i++) {
+		src[spikes[i]] = (i % 2) ? 50 : 100000;
+	}
+
+	/* Expected: the signal, the spikes replaced by the median of their window */
+	for (uint16_t i = 0; i < MEDIAN_TEST_BLOCK; i++) {
+		expected[i] = src[i];
+	}
+	for (uint16_t i = 0; i < sizeof(spikes) / sizeof(spikes[0]); i++) {
+		start = (spikes[i] > 3) ? spikes[i] - 3 : 0;
+		if (start + 7 > MEDIAN_TEST_BLOCK) {
+			start = MEDIAN_TEST_BLOCK - 7;
+		}
+		for (uint16_t j = 0; j < 7; j++) {
+			window[j] = src[start + j];
+		}
+		qsort(window, 7, sizeof(window[0]), median_test_compare);
+		expected[spikes[i]] = window[3];
+	}
+	median_test_hampel_block("spikes", src, 1, expected, sizeof(spikes) / sizeof(spikes[0]));
+
+	/* The same channel interleaved with another one */
+	for (uint16_t i = 0; i < MEDIAN_TEST_BLOCK; i++) {
+		interleaved[2 * i] = src[i];
+		interleaved[2 * i + 1] = 0xFFFFFFFF - i;
+	}
+	median_test_hampel_block("stride 2", interleaved, 2, expected, sizeof(spikes) / sizeof(spikes[0]));
+
+	/* Values 3e9 + 0 ... 80000 in steps of 20000: MAD 20000, threshold about 89000, but
+	 * 20000 * 380 * 768 is above 2^32, wrapped it would be about 23500 */
+	for (uint16_t i = 0; i < MEDIAN_TEST_BLOCK; i++) {
+		src[i] = 3000000000u + ((i * 3) % 5) * 20000;
+		expected[i] = src[i];
+	}
+	median_test_hampel_block("large MAD", src, 1, expected, 0);
+}
+
+/**
+ * @brief Checks one result of median_block_trimmed_mean().
+ */
+static void median_test_trimmed(const char *name, const uint32_t *src, uint16_t count, uint16_t stride,
+		uint16_t trim, uint32_t expected) {
+	uint32_t mean = median_block_trimmed_mean(src, count, stride, trim);
+
+	if (mean != expected) {
+		printf("FAIL: trimmed mean %s: %lu, expected %lu\n", name, (unsigned long) mean,
+				(unsigned long) expected);
+		median_test_failures++;
+	}
+}
+
+/**
+ * @brief Checks median_block_trimmed_mean() against known means.
+ */
+static void median_test_trimmed_mean(void) {
+	static const uint32_t tens[] = { 70, 10, 100, 40, 90, 20, 60, 30, 80, 50 };
+	uint32_t src[3 * MEDIAN_TEST_BLOCK];
+
+	/* 16 values 1000, two spikes above, two below */
+	for (uint16_t i = 0; i < 20; i++) {
+		src[i] = 1000;
+	}
+	src[3] = 1000000;
+	src[7] = 0;
+	src[12] = 4000000;
+	src[18] = 1;
+	median_test_trimmed("spikes", src, 20, 1, 2, 1000);
+	median_test_trimmed("trim 1 keeps a spike", src, 20, 1, 1, (16 * 1000 + 1000000 + 1) / 18);
+
+	median_test_trimmed("10 ... 100 trim 0", tens, 10, 1, 0, 55);
+	median_test_trimmed("10 ... 100 trim 1", tens, 10, 1, 1, 55);
+	median_test_trimmed("10 ... 100 trim 3", tens, 10, 1, 3, 55);
+	median_test_trimmed("10 ... 100 trim 5 (too many)", tens, 10, 1, 5, 55);
+	median_test_trimmed("one value", tens, 1, 1, 1, 70);
+	median_test_trimmed("no value", tens, 0, 1, 1, 0);
+
+	/* 40 values 0 ... 39, trim 12 is clamped to MEDIAN_TRIM_MAX (8): mean of 8 ... 31 */
+	for (uint16_t i = 0; i < 40; i++) {
+		src[i] = (i * 17) % 40;
+	}
+	median_test_trimmed("trim clamped", src, 40, 1, 12, (8 + 31) / 2);
+
+	/* Every third value belongs to the channel */
+	for (uint16_t i = 0; i < 10; i++) {
+		src[3 * i] = tens[i];
+		src[3 * i + 1] = 0xFFFFFFFF;
+		src[3 * i + 2] = 0;
+	}
+	median_test_trimmed("stride 3", src, 10, 3, 2, 55);
+
+	/* Sum of 4e9 * 10 does not fit into 32 bit */
+	for (uint16_t i = 0; i < 10; i++) {
+		src[i] = 4000000000u + i;
+	}
+	src[4] = 0xFFFFFFFF;
+	src[5] = 0;
+	median_test_trimmed("large values", src, 10, 1, 1, 4000000000u + (0 + 1 + 2 + 3 + 6 + 7 + 8 + 9) / 8);
+}
+
+int main(void) {
+	static const uint16_t lengths[] = { 1, 3, 5, 9 };
+	static const uint16_t invalid[] = { 0, 2, 4, 8, 10 };
+
+	srand(1);
+	for (uint32_t i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++) {
+		for (int input = 0; input < MEDIAN_TEST_INPUTS; input++) {
+			median_test_filter(lengths[i], (median_test_input_t) input);
+		}
+	}
+	for (uint32_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++) {
+		median_test_reject(invalid[i]);
+	}
+	median_test_hampel();
+	median_test_trimmed_mean();
+
+	if (median_test_failures > 0) {
+		printf("median_test: %d checks failed\n", median_test_failures);
+		return 1;
+	}
+	printf("median_test: all checks passed\n");
+	return 0;
+}
@@ -0,0 +1,171 @@
+/**
+**************************************************
+* @file pi_ctrl_test.c
+* @author Berkay Özgür, C. Arda Sengenc
+* @version v1.0
+* @date 17.10.2026
+* @brief: Host test of the fixed-point PI controller against a floating point reference.
+@verbatim
+==================================================
+### Checks ###
+(#) The reference is the same controller in double: proportional term with setpoint weight,
+	conditional integration as anti-windup, rounding to output units and clamping. It uses
+	the gains, that pi_ctrl holds after the Q16 conversion (kp and ki * Ts), so only the
+	fixed-point arithmetic is compared, not the quantisation of the gains.
+(#) Random gains within the documented ranges, random setpoint weights and random setpoint
+	and measurement sequences: jumps over the whole range (mostly saturated at out_min or
+	out_max) and a first order plant driven by the controller output, like a fan.
+(#) Every output may differ by at most one count from the reference.
+The program returns 1 if a check fails.
+==================================================
+@endverbatim
+**************************************************
+*/
+
+/* Includes */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <pi_ctrl/pi_ctrl.h>
+
+/* Private preprocessor macros */
+#define PI_CTRL_TEST_RUNS 2000
+#define PI_CTRL_TEST_STEPS 2000
+
+/* Private types */
+/* Reference controller in double, output units */
+typedef struct {
+	double kp;
+	double ki_ts;
+	double weight;
+	double integral;
+	double out_min;
+	double out_max;
+} pi_ref_t;
+
+/* Private variables */
+static long pi_ctrl_test_samples = 0;
+static long pi_ctrl_test_saturated = 0;
+
+/**
+ * @brief Random integer in [low, high].
+ */
+static int32_t pi_ctrl_test_random(int32_t low, int32_t high) {
+	return low + (int32_t) (((uint64_t) rand() * RAND_MAX + rand()) % (uint64_t) (high - low + 1));
+}
+
+/**
+ * @brief One sample of the reference controller.
+ */
+static int32_t pi_ref_update(pi_ref_t *ref, int32_t setpoint, int32_t measurement) {
+	double proportional = ref->kp * (ref->weight * setpoint - measurement);
+	double step = ref->ki_ts * (setpoint - measurement);
+	double integral = ref->integral + step;
+	double output = proportional + integral;
+
+	/* Anti-windup: do not integrate further into a limit */
+	if ((output > ref->out_max && step > 0) || (output < ref->out_min && step < 0)) {
+		integral = ref->integral;
+		output = proportional + integral;
+	}
+	ref->integral = integral;
+
+	output = floor(output + 0.5);
+	if (output > ref->out_max) {
+		output = ref->out_max;
+	} else if (output < ref->out_min) {
+		output = ref->out_min;
+	}
+	return (int32_t) output;
+}
+
+/**
+ * @brief Runs one random sequence through both controllers.
+ * @param plant 0 for random setpoints and measurements, 1 for a first order plant.
+ * @return Number of samples, that differ by more than one count.
+ */
+static int pi_ctrl_test_run(int plant) {
+	pi_ctrl_t pi;
+	pi_ref_t ref;
+	int32_t kp = pi_ctrl_test_random(0, plant ? PI_CTRL_Q16(2.0) : PI_CTRL_Q16(255.0));
+	int32_t ki = pi_ctrl_test_random(0, plant ? PI_CTRL_Q16(50.0) : PI_CTRL_Q16(32767.0));
+	uint32_t sample_us = (uint32_t) pi_ctrl_test_random(100, 100000);
+	int32_t out_min = pi_ctrl_test_random(-32767, plant ? 0 : 32767);
+	int32_t out_max = pi_ctrl_test_random(out_min, 32767);
+	int32_t range = plant ? 4000 : (1 << 20);
+	int32_t setpoint = pi_ctrl_test_random(-range, range);
+	int32_t measurement = 0;
+	double speed = 0;
+	int32_t output;
+	int32_t expected;
+	int failures = 0;
+
+	pi_ctrl_init(&pi, kp, ki, sample_us, out_min, out_max);
+	switch (pi_ctrl_test_random(0, 2)) {
+	case 0:
+		break;
+	case 1:
+		pi_ctrl_set_setpoint_weight(&pi, PI_CTRL_ONE);
+		break;
+	default:
+		pi_ctrl_set_setpoint_weight(&pi, pi_ctrl_test_random(0, PI_CTRL_ONE));
+		break;
+	}
+
+	ref.kp = pi.kp / 65536.0;
+	ref.ki_ts = pi.ki_ts / 65536.0;
+	ref.weight = pi.setpoint_weight / 65536.0;
+	ref.integral = pi.integral / 65536.0;
+	ref.out_min = out_min;
+	ref.out_max = out_max;
+
+	for (int n = 0; n < PI_CTRL_TEST_STEPS; n++) {
+		if (pi_ctrl_test_random(0, 99) < 3) {
+			setpoint = pi_ctrl_test_random(-range, range);
+		}
+		if (plant) {
+			measurement = (int32_t) lround(speed) + pi_ctrl_test_random(-20, 20);
+		} else {
+			measurement = pi_ctrl_test_random(-range, range);
+		}
+
+		output = pi_ctrl_update(&pi, setpoint, measurement);
+		expected = pi_ref_update(&ref, setpoint, measurement);
+
+		pi_ctrl_test_samples++;
+		if (output == out_min || output == out_max) {
+			pi_ctrl_test_saturated++;
+		}
+		if (abs(output - expected) > 1) {
+			if (failures == 0) {
+				printf("FAIL: step %d: output %d, reference %d (kp %d, ki %d, Ts %u us, "
+						"limits %d ... %d)\n", n, output, expected, kp, ki, sample_us,
+						out_min, out_max);
+			}
+			failures++;
+		}
+
+		/* First order plant, the speed follows 0.12 per output count with a time constant
+		 * of 20 samples */
+		speed += (0.12 * output - speed) / 20.0;
+	}
+	return failures;
+}
+
+int main(void) {
+	int failures = 0;
+
+	srand(1);
+	for (int run = 0; run < PI_CTRL_TEST_RUNS; run++) {
+		failures += pi_ctrl_test_run(run % 2);
+	}
+
+	printf("pi_ctrl_test: %ld samples, %ld at a limit\n", pi_ctrl_test_samples,
+			pi_ctrl_test_saturated);
+	if (failures) {
+		printf("pi_ctrl_test: %d samples differ by more than one count\n", failures);
+		return 1;
+	}
+	printf("pi_ctrl_test: all checks passed\n");
+	return 0;
+}
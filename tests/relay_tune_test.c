@@ -0,0 +1,121 @@
+/**
+**************************************************
+* @file relay_tune_test.c
+* @author Berkay Özgür, C. Arda Sengenc
+* @version v1.0
+* @date 17.10.2026
+* @brief: Host test of the relay auto-tuning: gains of a normal run and the range checks.
+@verbatim
+==================================================
+### Checks ###
+(#) A triangle plant (the measurement rises or falls by a fixed slope per sample, depending on
+	the relay output) oscillates around the setpoint, its amplitude follows from the hysteresis
+	and the slope, its period from the sample time.
+(#) Normal runs with both rules: RELAY_TUNE_DONE, kp and ki equal the rule calculated in double
+	from the measured Ku and Tu (at most one Q16 step apart, ki from the rounded kp).
+(#) Runs, whose gains would be outside the ranges of pi_ctrl: an ultimate gain, that does not fit
+	into 32 bit, kp of 256 or more and ki of 32768 or more (the last two fitted into the int32
+	before, ki wrapped to a negative gain). They must end with RELAY_TUNE_FAILED and kp = ki = 0.
+The program returns 1 if a check fails.
+==================================================
+@endverbatim
+**************************************************
+*/
+
+/* Includes */
+#include <math.h>
+#include <stdio.h>
+#include <relay_tune/relay_tune.h>
+
+/* Private types */
+/* One tuning run against the triangle plant */
+typedef struct {
+	const char *name;
+	int32_t hysteresis;
+	int32_t slope;				// change of the measurement per sample
+	int32_t out_low;
+	int32_t out_high;
+	uint32_t sample_us;
+	relay_tune_rule rule;
+	relay_tune_state expected;
+} relay_tune_test_case_t;
+
+/* Private variables */
+static const relay_tune_test_case_t relay_tune_test_cases[] = {
+	{ "fan ZN", 30, 120, 2458, 32604, 20000, RELAY_TUNE_ZIEGLER_NICHOLS, RELAY_TUNE_DONE },
+	{ "fan TL", 30, 120, 2458, 32604, 20000, RELAY_TUNE_TYREUS_LUYBEN, RELAY_TUNE_DONE },
+	{ "slow", 200, 50, 0, 1000, 100000, RELAY_TUNE_ZIEGLER_NICHOLS, RELAY_TUNE_DONE },
+	{ "Ku > 2^31", 0, 1, INT32_MIN, INT32_MAX, 20000, RELAY_TUNE_ZIEGLER_NICHOLS, RELAY_TUNE_FAILED },
+	{ "kp >= 256", 10, 10, 0, 32767, 20000, RELAY_TUNE_ZIEGLER_NICHOLS, RELAY_TUNE_FAILED },
+	{ "ki >= 32768", 40, 50, 0, 32767, 250, RELAY_TUNE_ZIEGLER_NICHOLS, RELAY_TUNE_FAILED },
+};
+
+/**
+ * @brief Runs one tuning case against the triangle plant and checks its result.
+ *
+ * @param test The case.
+ * @return 1 if the check fails, 0 otherwise.
+ */
+static int relay_tune_test_run(const relay_tune_test_case_t *test) {
+	const int32_t setpoint = 2000;
+	relay_tune_t tune;
+	relay_tune_state state;
+	int32_t measurement = setpoint;
+	int32_t output = test->out_high;
+	double kp;
+	double ki;
+
+	relay_tune_start(&tune, setpoint, test->hysteresis, test->out_low, test->out_high,
+			test->sample_us, 30000, test->rule);
+	do {
+		measurement += (output == test->out_high) ? test->slope : -test->slope;
+		output = relay_tune_update(&tune, measurement);
+		state = relay_tune_get_state(&tune);
+	} while (state == RELAY_TUNE_RUNNING);
+
+	printf("%-12s %s: Ku %.1f, Tu %lu us, kp %.2f, ki %.2f\n", test->name,
+			state == RELAY_TUNE_DONE ? "done  " : "failed", tune.ku / 65536.0,
+			(unsigned long) tune.tu_us, tune.kp / 65536.0, tune.ki / 65536.0);
+	if (state != test->expected) {
+		printf("FAIL: %s: state %d, expected %d\n", test->name, state, test->expected);
+		return 1;
+	}
+	if (state == RELAY_TUNE_FAILED) {
+		if (tune.kp != 0 || tune.ki != 0) {
+			printf("FAIL: %s: gains set by a failed run\n", test->name);
+			return 1;
+		}
+		return 0;
+	}
+
+	/* Reference in double from the measured Ku (Q16) and Tu, ki from the rounded kp of relay_tune */
+	if (test->rule == RELAY_TUNE_TYREUS_LUYBEN) {
+		kp = tune.ku / 3.2;
+		ki = tune.kp / (2.2 * tune.tu_us * 1e-6);
+	} else {
+		kp = tune.ku * 0.45;
+		ki = tune.kp / (tune.tu_us * 1e-6 / 1.2);
+	}
+	if (fabs(tune.kp - kp) > 1.0 || fabs(tune.ki - ki) > 1.0 || tune.kp <= 0 || tune.ki < 0
+			|| tune.kp >= RELAY_TUNE_MAX_KP) {
+		printf("FAIL: %s: kp %ld, ki %ld, reference %.1f, %.1f (Q16)\n", test->name,
+				(long) tune.kp, (long) tune.ki, kp, ki);
+		return 1;
+	}
+	return 0;
+}
+
+int main(void) {
+	int failures = 0;
+
+	for (uint32_t i = 0; i < sizeof(relay_tune_test_cases) / sizeof(relay_tune_test_cases[0]); i++) {
+		failures += relay_tune_test_run(&relay_tune_test_cases[i]);
+	}
+
+	if (failures > 0) {
+		printf("relay_tune_test: %d checks failed\n", failures);
+		return 1;
+	}
+	printf("relay_tune_test: all checks passed\n");
+	return 0;
+}